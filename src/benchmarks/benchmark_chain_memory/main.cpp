@@ -0,0 +1,131 @@
+// Memory that stays resident while only the last task of then()
+// chain is referenced. Every step of the chain produces 4KB buffer
+// (think of curl's Buffer) and captures 1KB of state in its functor.
+// Reports task internals (from the Scheduler's TaskAllocator),
+// results and functor state that are still alive once all chains
+// are finished, but before the handles are dropped.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/task_allocator.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <memory>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	class CountingAllocator final : public TaskAllocator
+	{
+	public:
+		virtual void* allocate(std::size_t size, std::size_t alignment) override
+		{
+			++alive;
+			alive_bytes += size;
+			return new_delete.allocate(size, alignment);
+		}
+
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override
+		{
+			--alive;
+			alive_bytes -= size;
+			new_delete.deallocate(ptr, size, alignment);
+		}
+
+		NewDeleteTaskAllocator new_delete;
+		std::size_t alive = 0;
+		std::size_t alive_bytes = 0;
+	};
+
+	std::size_t g_alive_bytes = 0;
+
+	// Result of the step or state captured by the functor
+	class Buffer
+	{
+	public:
+		explicit Buffer(std::size_t size)
+			: data_(size, '\0')
+		{
+			g_alive_bytes += data_.size();
+		}
+
+		Buffer(Buffer&& rhs) noexcept
+			: data_(std::move(rhs.data_))
+		{
+			rhs.data_.clear();
+		}
+
+		Buffer& operator=(Buffer&&) = delete;
+
+		Buffer(const Buffer& rhs)
+			: data_(rhs.data_)
+		{
+			g_alive_bytes += data_.size();
+		}
+
+		~Buffer()
+		{
+			g_alive_bytes -= data_.size();
+		}
+
+		std::size_t size() const
+		{
+			return data_.size();
+		}
+
+	private:
+		std::vector<char> data_;
+	};
+
+	const std::size_t k_result_size = 4 * 1024;
+	const std::size_t k_state_size = 1024;
+
+	Task<Buffer> MakeChain(Scheduler& scheduler, std::size_t depth)
+	{
+		Task<Buffer> task = make_task(scheduler, [] { return Buffer(k_result_size); });
+		for (std::size_t i = 1; i < depth; ++i)
+		{
+			task = task.then([state = Buffer(k_state_size)](const Task<Buffer>& parent)
+			{
+				return Buffer(parent.get().value().size() + state.size() - k_state_size);
+			});
+		}
+		return task;
+	}
+
+	void Run(std::size_t chains, std::size_t depth)
+	{
+		CountingAllocator allocator;
+		Scheduler scheduler(allocator);
+		std::vector<Task<Buffer>> tasks;
+		for (std::size_t i = 0; i < chains; ++i)
+		{
+			tasks.push_back(MakeChain(scheduler, depth));
+		}
+		const double seconds = MeasureSeconds([&]
+		{
+			scheduler.run_until_idle();
+		});
+		std::printf("%zu chains x %zu steps: %.2f ms, alive %zu tasks (%zu KB)"
+			", results and functors %zu KB\n"
+			, chains, depth, seconds * 1e3
+			, allocator.alive, allocator.alive_bytes / 1024
+			, g_alive_bytes / 1024);
+	}
+
+} // namespace
+
+int main()
+{
+	Run(1'000, 2);
+	Run(1'000, 8);
+	Run(1'000, 32);
+	return 0;
+}
@@ -0,0 +1,252 @@
+// Producer/consumer pipelines on single Scheduler. Producer makes
+// k_per_tick items per tick (think of the socket reads) into one of
+// the bounded queues, round-robin; every queue has its own consumer.
+// Compares consumers that check std::deque<> on every tick with
+// Channel<> consumers that wait in receive_many(): they are ticked
+// only when the producer gives them the items.
+// Scheduler is polled in a loop (no run_until() back-off).
+#include <rename_me/scheduler.h>
+#include <rename_me/channel.h>
+#include <rename_me/function_task.h>
+
+#include "benchmark_tools.h"
+
+#include <deque>
+#include <vector>
+#include <memory>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	const std::size_t k_items = 1'000'000;
+	const std::size_t k_per_tick = 16;
+	const std::size_t k_capacity = 256;
+	const std::size_t k_batch = 64;
+
+	using Queues = std::vector<std::deque<int>>;
+	using Channels = std::vector<std::unique_ptr<Channel<int>>>;
+
+	// Bounded deques that are polled by the consumers
+	struct DequeProducer
+	{
+		explicit DequeProducer(Queues& queues)
+			: queues_(queues)
+			, produced_(0)
+			, ticks_(0)
+			, data_(unexpected_void())
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			std::deque<int>& queue = queues_[ticks_++ % queues_.size()];
+			for (std::size_t i = 0; (i < k_per_tick) && (queue.size() < k_capacity); ++i)
+			{
+				queue.push_back(static_cast<int>(produced_++));
+				if (produced_ == k_items)
+				{
+					data_ = expected<void, void>();
+					return Status::Successful;
+				}
+			}
+			return Status::InProgress;
+		}
+
+		expected<void, void>& get() { return data_; }
+
+		Queues& queues_;
+		std::size_t produced_;
+		std::size_t ticks_;
+		expected<void, void> data_;
+	};
+
+	struct DequeConsumer
+	{
+		explicit DequeConsumer(std::deque<int>& queue, std::size_t& consumed, long long& sum)
+			: queue_(queue)
+			, consumed_(consumed)
+			, sum_(sum)
+			, data_(unexpected_void())
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			while (!queue_.empty())
+			{
+				sum_ += queue_.front();
+				queue_.pop_front();
+				++consumed_;
+			}
+			if (consumed_ < k_items)
+			{
+				return Status::InProgress;
+			}
+			data_ = expected<void, void>();
+			return Status::Successful;
+		}
+
+		expected<void, void>& get() { return data_; }
+
+		std::deque<int>& queue_;
+		std::size_t& consumed_;
+		long long& sum_;
+		expected<void, void> data_;
+	};
+
+	// Waits for the send() only when the channel is full
+	struct ChannelProducer
+	{
+		explicit ChannelProducer(Channels& channels)
+			: channels_(channels)
+			, produced_(0)
+			, ticks_(0)
+			, pending_()
+			, data_(unexpected_void())
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (pending_.is_valid() && pending_.is_in_progress())
+			{
+				return Status::InProgress;
+			}
+			Channel<int>& channel = *channels_[ticks_++ % channels_.size()];
+			for (std::size_t i = 0; i < k_per_tick; ++i)
+			{
+				pending_ = channel.send(static_cast<int>(produced_++));
+				if (produced_ == k_items)
+				{
+					data_ = expected<void, void>();
+					return Status::Successful;
+				}
+				if (pending_.is_in_progress())
+				{
+					break;
+				}
+			}
+			return Status::InProgress;
+		}
+
+		expected<void, void>& get() { return data_; }
+
+		Channels& channels_;
+		std::size_t produced_;
+		std::size_t ticks_;
+		Task<void, void> pending_;
+		expected<void, void> data_;
+	};
+
+	struct ChannelConsumer
+	{
+		explicit ChannelConsumer(Channel<int>& channel, std::size_t& consumed, long long& sum)
+			: channel_(channel)
+			, consumed_(consumed)
+			, sum_(sum)
+		{
+		}
+
+		void receive()
+		{
+			(void)channel_.receive_many(k_batch).then([this](const Task<std::vector<int>>& batch)
+			{
+				if (!batch.is_successful())
+				{
+					// Closed
+					return;
+				}
+				for (int value : batch.get().value())
+				{
+					sum_ += value;
+				}
+				consumed_ += batch.get().value().size();
+				receive();
+			});
+		}
+
+		Channel<int>& channel_;
+		std::size_t& consumed_;
+		long long& sum_;
+	};
+
+	void Report(const char* name, std::size_t consumers
+		, Scheduler& scheduler, double seconds, long long sum)
+	{
+		char row[128];
+		std::snprintf(row, sizeof(row), "%s, %zu consumers", name, consumers);
+		PrintRow(row, k_items, seconds);
+		std::printf("%s: %.3f ticks per item, sum %lld\n", row
+			, static_cast<double>(scheduler.stats().ticks) / static_cast<double>(k_items), sum);
+	}
+
+	void RunDeque(std::size_t consumers)
+	{
+		Scheduler scheduler;
+		Queues queues(consumers);
+		std::size_t consumed = 0;
+		long long sum = 0;
+		const double seconds = MeasureSeconds([&]
+		{
+			(void)Task<void>::make<DequeProducer>(scheduler, queues);
+			for (std::deque<int>& queue : queues)
+			{
+				(void)Task<void>::make<DequeConsumer>(scheduler, queue, consumed, sum);
+			}
+			while (consumed < k_items)
+			{
+				(void)scheduler.poll();
+			}
+		});
+		Report("polled std::deque<>", consumers, scheduler, seconds, sum);
+		scheduler.run_until_idle();
+	}
+
+	void RunChannel(std::size_t consumers)
+	{
+		Scheduler scheduler;
+		Channels channels;
+		std::vector<ChannelConsumer> receivers;
+		receivers.reserve(consumers);
+		std::size_t consumed = 0;
+		long long sum = 0;
+		for (std::size_t i = 0; i < consumers; ++i)
+		{
+			channels.push_back(std::make_unique<Channel<int>>(scheduler, k_capacity));
+			receivers.emplace_back(*channels.back(), consumed, sum);
+		}
+		const double seconds = MeasureSeconds([&]
+		{
+			for (ChannelConsumer& receiver : receivers)
+			{
+				receiver.receive();
+			}
+			(void)Task<void>::make<ChannelProducer>(scheduler, channels);
+			while (consumed < k_items)
+			{
+				(void)scheduler.poll();
+			}
+		});
+		Report("Channel<>::receive_many()", consumers, scheduler, seconds, sum);
+		for (auto& channel : channels)
+		{
+			channel->close();
+		}
+		scheduler.run_until_idle();
+	}
+
+} // namespace
+
+int main()
+{
+	RunDeque(1);
+	RunChannel(1);
+	RunDeque(100);
+	RunChannel(100);
+	return 0;
+}
@@ -0,0 +1,147 @@
+// Single task (think of config loading) that is waited
+// by many subscribers. Compares subscribers that are continuations
+// (then(), kept in the list of the task until it finishes) with
+// subscribers that poll status() of the task on every tick.
+// Number of continuations goes beyond 65535 references to the task.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Task that is finished only by the benchmark
+	struct PendingTask
+	{
+		explicit PendingTask(const bool& finish)
+			: finish_(finish)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (!finish_)
+			{
+				return Status::InProgress;
+			}
+			data_ = expected<int, void>(1);
+			return Status::Successful;
+		}
+
+		expected<int, void>& get()
+		{
+			return data_;
+		}
+
+		const bool& finish_;
+		expected<int, void> data_;
+	};
+
+	// Subscriber that polls status() of the task.
+	// Task should outlive the subscriber
+	struct PollingTask
+	{
+		explicit PollingTask(const Task<int>& task)
+			: task_(task)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (task_.is_in_progress())
+			{
+				return Status::InProgress;
+			}
+			data_ = expected<int, void>(task_.get().value() + 1);
+			return Status::Successful;
+		}
+
+		expected<int, void>& get()
+		{
+			return data_;
+		}
+
+		const Task<int>& task_;
+		expected<int, void> data_;
+	};
+
+	// Polls before the task is finished
+	const std::size_t k_polls = 10;
+
+	template<typename Subscribe>
+	void Run(const char* name, std::size_t subscribers, Subscribe subscribe)
+	{
+		Scheduler scheduler;
+		bool finish = false;
+		Task<int> task = Task<int>::make<PendingTask>(scheduler, finish);
+		std::vector<Task<int>> tasks;
+		tasks.reserve(subscribers);
+		const double subscribe_seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < subscribers; ++i)
+			{
+				tasks.push_back(subscribe(task));
+			}
+		});
+		const std::uint64_t ticks_before = scheduler.stats().ticks;
+		const double wait_seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_polls; ++i)
+			{
+				(void)scheduler.poll();
+			}
+		});
+		finish = true;
+		const double finish_seconds = MeasureSeconds([&]
+		{
+			scheduler.run_until_idle();
+		});
+		const std::uint64_t ticks = (scheduler.stats().ticks - ticks_before);
+
+		char row[128];
+		std::snprintf(row, sizeof(row), "%s, subscribe", name);
+		PrintRow(row, subscribers, subscribe_seconds);
+		std::snprintf(row, sizeof(row), "%s, %zu polls while waiting", name, k_polls);
+		PrintRow(row, subscribers, wait_seconds);
+		std::snprintf(row, sizeof(row), "%s, finish", name);
+		PrintRow(row, subscribers, finish_seconds);
+		std::printf("%s: %.2f ticks per subscriber\n", name
+			, static_cast<double>(ticks) / static_cast<double>(subscribers));
+	}
+
+	void RunContinuations(std::size_t subscribers)
+	{
+		Run("then()", subscribers, [](Task<int>& task)
+		{
+			return task.then([](const Task<int>& t) { return t.get().value() + 1; });
+		});
+	}
+
+	void RunPolling(std::size_t subscribers)
+	{
+		Run("polling status()", subscribers, [](Task<int>& task)
+		{
+			return Task<int>::make<PollingTask>(task.scheduler(), task);
+		});
+	}
+
+} // namespace
+
+int main()
+{
+	RunContinuations(10'000);
+	RunPolling(10'000);
+	RunContinuations(500'000);
+	RunPolling(500'000);
+	return 0;
+}
@@ -0,0 +1,96 @@
+// Request-scoped tasks: every request creates small graph of tasks
+// (fan-out of then() continuations, results collected into a vector)
+// and drops all of them once the request is done. Compares tasks
+// from Scheduler's PoolTaskAllocator, from global operator new/delete
+// and from std::pmr::monotonic_buffer_resource that is released
+// after every request (nothing is freed one by one).
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/task_allocator.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <memory_resource>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	const std::size_t k_requests = 20'000;
+	const std::size_t k_fan_out = 16;
+
+	int HandleRequest(Scheduler& scheduler)
+	{
+		std::pmr::vector<Task<int>> tasks(&scheduler.memory_resource());
+		tasks.reserve(k_fan_out);
+		Task<int> root = make_task(scheduler, [] { return 1; });
+		for (std::size_t i = 0; i < k_fan_out; ++i)
+		{
+			tasks.push_back(root.then([i](const Task<int>& t)
+			{
+				return t.get().value() + static_cast<int>(i);
+			}));
+		}
+		scheduler.run_until_idle();
+		int sum = 0;
+		for (const Task<int>& task : tasks)
+		{
+			sum += task.get().value();
+		}
+		return sum;
+	}
+
+	template<typename AfterRequest>
+	void Run(const char* name, Scheduler& scheduler, AfterRequest after_request)
+	{
+		int sum = 0;
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_requests; ++i)
+			{
+				sum += HandleRequest(scheduler);
+				after_request();
+			}
+		});
+		PrintRow(name, k_requests, seconds);
+		(void)sum;
+	}
+
+	void RunPool()
+	{
+		Scheduler scheduler;
+		Run("PoolTaskAllocator", scheduler, [] {});
+	}
+
+	void RunNewDelete()
+	{
+		NewDeleteTaskAllocator allocator;
+		Scheduler scheduler(allocator);
+		Run("NewDeleteTaskAllocator", scheduler, [] {});
+	}
+
+	void RunMonotonic()
+	{
+		std::vector<unsigned char> buffer(64 * 1024);
+		std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size()
+			, std::pmr::null_memory_resource());
+		Scheduler scheduler(arena);
+		Run("monotonic_buffer_resource, released per request", scheduler
+			, [&arena] { arena.release(); });
+	}
+
+} // namespace
+
+int main()
+{
+	std::printf("%zu requests, %zu continuations each\n", k_requests, k_fan_out);
+	RunPool();
+	RunNewDelete();
+	RunMonotonic();
+	return 0;
+}
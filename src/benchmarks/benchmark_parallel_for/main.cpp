@@ -0,0 +1,129 @@
+// Processing of the large array. Compares parallel_for() with the
+// array that is split by hand into make_task() per chunk of
+// k_grain elements (all chunk tasks are polled until they finish).
+// Counts task allocations (see CountingAllocator) besides the time.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/parallel_for.h>
+#include <rename_me/task_allocator.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <atomic>
+#include <cmath>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	const std::size_t k_size = 4'000'000;
+	const std::size_t k_grain = 1'000;
+	const std::size_t k_rounds = 5;
+
+	class CountingAllocator final : public TaskAllocator
+	{
+	public:
+		virtual void* allocate(std::size_t size, std::size_t alignment) override
+		{
+			++allocations;
+			return pool.allocate(size, alignment);
+		}
+
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override
+		{
+			pool.deallocate(ptr, size, alignment);
+		}
+
+		PoolTaskAllocator pool;
+		std::atomic<std::size_t> allocations{0};
+	};
+
+	void Process(float& value)
+	{
+		value = std::sqrt(value * value + 1.f);
+	}
+
+	void RunByHand(Scheduler& scheduler, std::vector<float>& data)
+	{
+		std::vector<Task<void>> tasks;
+		tasks.reserve(data.size() / k_grain + 1);
+		for (std::size_t begin = 0; begin < data.size(); begin += k_grain)
+		{
+			const std::size_t end = (std::min)(begin + k_grain, data.size());
+			tasks.push_back(make_task(scheduler, [&data, begin, end]
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					Process(data[i]);
+				}
+			}));
+		}
+		for (const Task<void>& task : tasks)
+		{
+			scheduler.run_until(task);
+		}
+	}
+
+	void RunParallelFor(Scheduler& scheduler, std::vector<float>& data, std::size_t grain)
+	{
+		auto task = parallel_for(scheduler, data.begin(), data.end()
+			, [](float& value) { Process(value); }, grain);
+		scheduler.run_until(task);
+	}
+
+	template<typename Run>
+	void Measure(const char* name, Scheduler& scheduler, CountingAllocator& allocator, Run run)
+	{
+		std::vector<float> data(k_size, 1.f);
+		run(scheduler, data);
+		const std::size_t allocations = allocator.allocations;
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_rounds; ++i)
+			{
+				run(scheduler, data);
+			}
+		});
+		PrintRow(name, k_size * k_rounds, seconds);
+		std::printf("%s: %zu task allocations per round\n", name
+			, (allocator.allocations - allocations) / k_rounds);
+	}
+
+	void MeasureAll(const char* scheduler_name, Scheduler& scheduler, CountingAllocator& allocator)
+	{
+		std::printf("%s, concurrency %zu\n", scheduler_name, scheduler.concurrency());
+		Measure("make_task() per chunk", scheduler, allocator
+			, [](Scheduler& s, std::vector<float>& data) { RunByHand(s, data); });
+		Measure("parallel_for(), same grain", scheduler, allocator
+			, [](Scheduler& s, std::vector<float>& data) { RunParallelFor(s, data, k_grain); });
+		Measure("parallel_for(), default grain", scheduler, allocator
+			, [](Scheduler& s, std::vector<float>& data) { RunParallelFor(s, data, 0); });
+	}
+
+} // namespace
+
+int main()
+{
+	{
+		CountingAllocator allocator;
+		Scheduler scheduler(allocator);
+		MeasureAll("Scheduler", scheduler, allocator);
+	}
+#if !(NN_SINGLE_THREADED)
+	{
+		CountingAllocator allocator;
+		ThreadPoolScheduler scheduler(allocator);
+		MeasureAll("ThreadPoolScheduler", scheduler, allocator);
+	}
+#endif
+	return 0;
+}
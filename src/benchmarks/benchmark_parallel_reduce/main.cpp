@@ -0,0 +1,135 @@
+// Sum of squares of the large array. Compares parallel_reduce() with
+// make_task() per shard that are combined by serial then() (how
+// it's done by hand) and with std::transform_reduce() with
+// std::execution::par (NN_HAS_STD_PAR, needs TBB for libstdc++;
+// without it std::transform_reduce() is sequential).
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/when_all.h>
+#include <rename_me/parallel_for.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <numeric>
+#include <functional>
+#if (NN_HAS_STD_PAR)
+#include <execution>
+#endif
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	const std::size_t k_size = 8'000'000;
+	const std::size_t k_shard = 10'000;
+	const std::size_t k_rounds = 5;
+
+	double Square(double value)
+	{
+		return value * value;
+	}
+
+	double ReduceByHand(Scheduler& scheduler, const std::vector<double>& data)
+	{
+		std::vector<Task<double>> shards;
+		shards.reserve(data.size() / k_shard + 1);
+		for (std::size_t begin = 0; begin < data.size(); begin += k_shard)
+		{
+			const std::size_t end = (std::min)(begin + k_shard, data.size());
+			shards.push_back(make_task(scheduler, [&data, begin, end]
+			{
+				double sum = 0;
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					sum += Square(data[i]);
+				}
+				return sum;
+			}));
+		}
+		auto total = when_all(scheduler, std::move(shards))
+			.then([](const Task<std::vector<expected<double, void>>>& task)
+		{
+			double sum = 0;
+			for (const expected<double, void>& shard : task.get().value())
+			{
+				sum += shard.value();
+			}
+			return sum;
+		});
+		scheduler.run_until(total);
+		return total.get().value();
+	}
+
+	double ParallelReduce(Scheduler& scheduler, const std::vector<double>& data)
+	{
+		auto total = parallel_reduce(scheduler, data.begin(), data.end(), 0.0
+			, std::plus<>(), [](double value) { return Square(value); });
+		scheduler.run_until(total);
+		return total.get().value();
+	}
+
+	double StdReduce(const std::vector<double>& data)
+	{
+#if (NN_HAS_STD_PAR)
+		return std::transform_reduce(std::execution::par, data.begin(), data.end()
+			, 0.0, std::plus<>(), [](double value) { return Square(value); });
+#else
+		return std::transform_reduce(data.begin(), data.end()
+			, 0.0, std::plus<>(), [](double value) { return Square(value); });
+#endif
+	}
+
+	template<typename Reduce>
+	void Measure(const char* name, const std::vector<double>& data, Reduce reduce)
+	{
+		volatile double sink = reduce(data);
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_rounds; ++i)
+			{
+				sink = reduce(data);
+			}
+		});
+		(void)sink;
+		PrintRow(name, k_size * k_rounds, seconds);
+	}
+
+	void MeasureScheduler(const char* name, Scheduler& scheduler, const std::vector<double>& data)
+	{
+		std::printf("%s, concurrency %zu\n", name, scheduler.concurrency());
+		Measure("make_task() per shard + then()", data
+			, [&](const std::vector<double>& d) { return ReduceByHand(scheduler, d); });
+		Measure("parallel_reduce()", data
+			, [&](const std::vector<double>& d) { return ParallelReduce(scheduler, d); });
+	}
+
+} // namespace
+
+int main()
+{
+	const std::vector<double> data(k_size, 0.5);
+#if (NN_HAS_STD_PAR)
+	Measure("std::transform_reduce(par)", data, StdReduce);
+#else
+	Measure("std::transform_reduce(), sequential", data, StdReduce);
+#endif
+	{
+		Scheduler scheduler;
+		MeasureScheduler("Scheduler", scheduler, data);
+	}
+#if !(NN_SINGLE_THREADED)
+	{
+		ThreadPoolScheduler scheduler;
+		MeasureScheduler("ThreadPoolScheduler", scheduler, data);
+	}
+#endif
+	return 0;
+}
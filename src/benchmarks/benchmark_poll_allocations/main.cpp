@@ -0,0 +1,184 @@
+// Heap allocations and time of single Scheduler::poll() with
+// many pending (in-progress) tasks. Compares intrusive run list
+// used by the Scheduler with std::vector<> run list that was
+// moved out, compacted and merged back on every poll.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <new>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	std::atomic<std::size_t> g_allocations(0);
+} // namespace
+
+void* operator new(std::size_t size)
+{
+	++g_allocations;
+	if (void* ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Stays in progress until `stop` is set
+	struct WaitTask
+	{
+		explicit WaitTask(const bool& stop)
+			: stop_(stop)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			return (stop_ ? Status::Successful : Status::InProgress);
+		}
+
+		expected<void, void>& get()
+		{
+			return data_;
+		}
+
+		const bool& stop_;
+		expected<void, void> data_;
+	};
+
+	struct PollPolicy
+	{
+		Scheduler& scheduler;
+
+		void post_wait(const bool& stop)
+		{
+			(void)Task<>::make<WaitTask>(scheduler, stop);
+		}
+
+		std::size_t poll()
+		{
+			return scheduler.poll();
+		}
+	};
+
+	// Poll loop of the Scheduler before intrusive run list
+	class VectorPoller
+	{
+	public:
+		explicit VectorPoller(Scheduler& scheduler)
+			: scheduler_(scheduler)
+		{
+		}
+
+		void post_wait(const bool& stop)
+		{
+			auto task = detail::InternalCustomTask<void, void, WaitTask>::Make(scheduler_, stop);
+			std::lock_guard<std::mutex> _(guard_);
+			tasks_.push_back(task.template to_base<detail::TaskBase>());
+		}
+
+		std::size_t poll()
+		{
+			std::vector<detail::ErasedTask> tasks;
+			{
+				std::lock_guard<std::mutex> _(guard_);
+				tasks = std::move(tasks_);
+			}
+			std::size_t finished = 0;
+			for (auto& task : tasks)
+			{
+				if (task->update() != Status::InProgress)
+				{
+					task = nullptr;
+					++finished;
+				}
+			}
+			auto it = std::remove_if(std::begin(tasks), std::end(tasks)
+				, [](const detail::ErasedTask& task) { return !task; });
+			std::lock_guard<std::mutex> _(guard_);
+			tasks_.reserve(tasks_.size() + tasks.size());
+			tasks_.insert(std::end(tasks_)
+				, std::make_move_iterator(std::begin(tasks))
+				, std::make_move_iterator(it));
+			return finished;
+		}
+
+	private:
+		Scheduler& scheduler_;
+		std::mutex guard_;
+		std::vector<detail::ErasedTask> tasks_;
+	};
+
+	template<typename Poller>
+	void Run(const char* name, Poller& poller, std::size_t pending)
+	{
+		const std::size_t k_polls = 20;
+		bool stop = false;
+		for (std::size_t i = 0; i < pending; ++i)
+		{
+			poller.post_wait(stop);
+		}
+		// Warm up: get all posted tasks to the run list
+		(void)poller.poll();
+
+		const std::size_t allocations_before = g_allocations;
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_polls; ++i)
+			{
+				(void)poller.poll();
+			}
+		});
+		const std::size_t allocations = (g_allocations - allocations_before);
+
+		std::printf("%-28s %8zu pending %8.2f allocations/poll %12.0f ns/poll\n"
+			, name, pending
+			, static_cast<double>(allocations) / static_cast<double>(k_polls)
+			, (seconds * 1e9) / static_cast<double>(k_polls));
+
+		stop = true;
+		while (poller.poll() != pending)
+		{
+		}
+	}
+
+} // namespace
+
+int main()
+{
+	const std::size_t k_pending[] = {10'000, 100'000, 1'000'000};
+	for (std::size_t pending : k_pending)
+	{
+		Scheduler scheduler;
+		PollPolicy policy{scheduler};
+		Run("intrusive run list", policy, pending);
+
+		VectorPoller vector_poller(scheduler);
+		Run("std::vector<> run list", vector_poller, pending);
+	}
+	return 0;
+}
@@ -0,0 +1,182 @@
+// Contention of Scheduler::post() when many threads create tasks.
+// Compares lock-free detail::TaskQueue used by the Scheduler
+// with std::mutex + std::vector<> queue Scheduler used before.
+#include <rename_me/function_task.h>
+#include <rename_me/detail/task_queue.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <string>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	struct BenchTask : detail::TaskBase
+	{
+		explicit BenchTask(Scheduler& scheduler)
+			: TaskBase(scheduler)
+		{
+		}
+
+		virtual Status update() override { return Status::Successful; }
+	};
+
+	// Submission path of the Scheduler before detail::TaskQueue
+	class MutexQueue
+	{
+	public:
+		void push(detail::ErasedTask task)
+		{
+			std::lock_guard<std::mutex> _(guard_);
+			tasks_.push_back(std::move(task));
+		}
+
+		std::size_t pop_all()
+		{
+			std::vector<detail::ErasedTask> tasks;
+			{
+				std::lock_guard<std::mutex> _(guard_);
+				tasks = std::move(tasks_);
+			}
+			return tasks.size();
+		}
+
+	private:
+		std::mutex guard_;
+		std::vector<detail::ErasedTask> tasks_;
+	};
+
+	class LockFreeQueue
+	{
+	public:
+		void push(detail::ErasedTask task)
+		{
+			queue_.push(std::move(task));
+		}
+
+		std::size_t pop_all()
+		{
+			std::size_t count = 0;
+			detail::TaskBase* task = queue_.pop_all();
+			while (task)
+			{
+				detail::TaskBase* next = task->next();
+				task->set_next(nullptr);
+				(void)detail::ErasedTask::attach(task);
+				task = next;
+				++count;
+			}
+			return count;
+		}
+
+	private:
+		detail::TaskQueue queue_;
+	};
+
+	template<typename Queue>
+	double RunQueue(Scheduler& scheduler, std::size_t producers, std::size_t tasks_per_producer)
+	{
+		std::vector<std::vector<detail::ErasedTask>> tasks(producers);
+		for (auto& per_producer : tasks)
+		{
+			per_producer.reserve(tasks_per_producer);
+			for (std::size_t i = 0; i < tasks_per_producer; ++i)
+			{
+				per_producer.push_back(detail::RefCountPtr<BenchTask>::make(scheduler)
+					.template to_base<detail::TaskBase>());
+			}
+		}
+
+		Queue queue;
+		std::atomic<bool> start(false);
+		const std::size_t total = (producers * tasks_per_producer);
+		std::vector<std::thread> threads;
+		for (auto& per_producer : tasks)
+		{
+			threads.emplace_back([&]
+			{
+				while (!start) { }
+				for (auto& task : per_producer)
+				{
+					queue.push(std::move(task));
+				}
+			});
+		}
+
+		return MeasureSeconds([&]
+		{
+			start = true;
+			std::size_t consumed = 0;
+			while (consumed != total)
+			{
+				consumed += queue.pop_all();
+			}
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		});
+	}
+
+	double RunScheduler(std::size_t producers, std::size_t tasks_per_producer)
+	{
+		Scheduler scheduler;
+		std::atomic<bool> start(false);
+		std::atomic<std::size_t> active(producers);
+		std::vector<std::thread> threads;
+		for (std::size_t i = 0; i < producers; ++i)
+		{
+			threads.emplace_back([&]
+			{
+				while (!start) { }
+				for (std::size_t j = 0; j < tasks_per_producer; ++j)
+				{
+					(void)make_task(scheduler, [] { });
+				}
+				--active;
+			});
+		}
+
+		return MeasureSeconds([&]
+		{
+			start = true;
+			while ((active > 0) || scheduler.has_tasks())
+			{
+				(void)scheduler.poll();
+			}
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		});
+	}
+
+} // namespace
+
+int main()
+{
+	const std::size_t k_tasks_per_producer = 100'000;
+	const std::size_t k_producers[] = {1, 2, 4, 8, 16};
+
+	Scheduler scheduler;
+	for (std::size_t producers : k_producers)
+	{
+		const std::size_t total = (producers * k_tasks_per_producer);
+		const std::string suffix = " (" + std::to_string(producers) + " producers)";
+
+		PrintRow(("std::mutex queue post" + suffix).c_str(), total
+			, RunQueue<MutexQueue>(scheduler, producers, k_tasks_per_producer));
+		PrintRow(("lock-free queue post" + suffix).c_str(), total
+			, RunQueue<LockFreeQueue>(scheduler, producers, k_tasks_per_producer));
+		PrintRow(("make_task() + poll()" + suffix).c_str(), total
+			, RunScheduler(producers, k_tasks_per_producer));
+	}
+	return 0;
+}
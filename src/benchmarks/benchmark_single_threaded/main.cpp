@@ -0,0 +1,148 @@
+// Task overhead that depends on the threading policy (see
+// detail/threading.h). Build once as usual and once with
+// NN_SINGLE_THREADED to compare atomic reference counts, statuses
+// and Scheduler's locks with plain integers.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <string>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Task that is finished only by the benchmark
+	struct PendingTask
+	{
+		explicit PendingTask(const bool& finish)
+			: finish_(finish)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (!finish_)
+			{
+				return Status::InProgress;
+			}
+			data_ = expected<void, void>();
+			return Status::Successful;
+		}
+
+		expected<void, void>& get()
+		{
+			return data_;
+		}
+
+		const bool& finish_;
+		expected<void, void> data_;
+	};
+
+	struct ReferencedTask : detail::TaskBase
+	{
+		explicit ReferencedTask(Scheduler& scheduler)
+			: TaskBase(scheduler)
+		{
+		}
+
+		virtual Status update() override { return Status::Successful; }
+	};
+
+	void RunTasks(Scheduler& scheduler)
+	{
+		const std::size_t k_tasks = 1'000'000;
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_tasks; ++i)
+			{
+				auto task = make_task(scheduler, [] { return 1; });
+				while (task.is_in_progress())
+				{
+					(void)scheduler.poll();
+				}
+			}
+		});
+		PrintRow("make_task() + poll()", k_tasks, seconds);
+	}
+
+	void RunChains(Scheduler& scheduler)
+	{
+		const std::size_t k_chains = 200'000;
+		const std::size_t k_steps = 5;
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_chains; ++i)
+			{
+				auto task = make_task(scheduler, [] { return 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; });
+				while (task.is_in_progress())
+				{
+					(void)scheduler.poll();
+				}
+			}
+		});
+		PrintRow("then() x5 chains, per task", k_chains * k_steps, seconds);
+	}
+
+	void RunTicks(Scheduler& scheduler)
+	{
+		const std::size_t k_tasks = 1'000;
+		const std::size_t k_polls = 5'000;
+		bool finish = false;
+		for (std::size_t i = 0; i < k_tasks; ++i)
+		{
+			(void)Task<>::make<PendingTask>(scheduler, finish);
+		}
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_polls; ++i)
+			{
+				(void)scheduler.poll();
+			}
+		});
+		PrintRow("poll() of not finished tasks, per tick", k_tasks * k_polls, seconds);
+		finish = true;
+		scheduler.run_until_idle();
+	}
+
+	void RunReferences(Scheduler& scheduler)
+	{
+		const std::size_t k_copies = 20'000'000;
+		const std::size_t k_slots = 16;
+		const detail::ErasedTask task = detail::ErasedTask::attach(
+			new ReferencedTask(scheduler));
+		std::vector<detail::ErasedTask> copies(k_slots);
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_copies; ++i)
+			{
+				// Adds reference to the `task`, removes from the previous copy
+				copies[i % k_slots] = task;
+			}
+		});
+		PrintRow("add/remove reference", k_copies, seconds);
+	}
+
+} // namespace
+
+int main()
+{
+	std::printf("NN_SINGLE_THREADED=%d\n", NN_SINGLE_THREADED);
+	Scheduler scheduler;
+	RunTasks(scheduler);
+	RunChains(scheduler);
+	RunTicks(scheduler);
+	RunReferences(scheduler);
+	return 0;
+}
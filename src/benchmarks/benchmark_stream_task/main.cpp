@@ -0,0 +1,145 @@
+// Source that makes k_per_tick items per tick (think of the socket
+// reads) and consumer that sums them up. Compares the Task per item
+// (make_task() + then()) with StreamTask<> consumed by for_each()
+// and by next_many() in a loop. Reports allocations per item
+// from the Scheduler's memory resource.
+// Scheduler is polled in a loop (no run_until() back-off).
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/stream_task.h>
+
+#include "benchmark_tools.h"
+
+#include <memory_resource>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	const int k_items = 1'000'000;
+	const int k_per_tick = 16;
+	const std::size_t k_capacity = 1024;
+	const std::size_t k_batch = 64;
+
+	class CountingResource final : public std::pmr::memory_resource
+	{
+	public:
+		std::size_t allocations = 0;
+
+	private:
+		virtual void* do_allocate(std::size_t size, std::size_t alignment) override
+		{
+			++allocations;
+			return std::pmr::new_delete_resource()->allocate(size, alignment);
+		}
+
+		virtual void do_deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) override
+		{
+			std::pmr::new_delete_resource()->deallocate(ptr, size, alignment);
+		}
+
+		virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return (this == &other);
+		}
+	};
+
+	struct Source
+	{
+		int produced = 0;
+
+		Status operator()(StreamWriter<int>& out)
+		{
+			for (int i = 0; i < k_per_tick; ++i)
+			{
+				out.push(produced++);
+				if (produced == k_items)
+				{
+					return Status::Successful;
+				}
+			}
+			return Status::InProgress;
+		}
+	};
+
+	long long TaskPerItem(Scheduler& scheduler)
+	{
+		long long sum = 0;
+		for (int produced = 0; produced < k_items; )
+		{
+			for (int i = 0; (i < k_per_tick) && (produced < k_items); ++i)
+			{
+				(void)make_task(scheduler, [value = produced++] { return value; })
+					.then([&sum](const Task<int>& item) { sum += item.get().value(); });
+			}
+			(void)scheduler.poll();
+		}
+		scheduler.run_until_idle();
+		return sum;
+	}
+
+	long long StreamForEach(Scheduler& scheduler)
+	{
+		long long sum = 0;
+		auto done = StreamTask<int>::make(scheduler, Source(), k_capacity)
+			.for_each([&sum](int value) { sum += value; });
+		while (done.is_in_progress())
+		{
+			(void)scheduler.poll();
+		}
+		return sum;
+	}
+
+	long long StreamNextMany(Scheduler& scheduler)
+	{
+		long long sum = 0;
+		auto stream = StreamTask<int>::make(scheduler, Source(), k_capacity);
+		while (true)
+		{
+			auto batch = stream.next_many(k_batch);
+			while (batch.is_in_progress())
+			{
+				(void)scheduler.poll();
+			}
+			if (!batch.is_successful())
+			{
+				break;
+			}
+			for (int value : batch.get().value())
+			{
+				sum += value;
+			}
+		}
+		return sum;
+	}
+
+	template<typename F>
+	void Measure(const char* name, F consume)
+	{
+		CountingResource resource;
+		Scheduler scheduler(resource);
+		long long sum = 0;
+		const double seconds = MeasureSeconds([&]
+		{
+			sum = consume(scheduler);
+		});
+		PrintRow(name, k_items, seconds);
+		std::printf("%s: %.3f allocations per item, %.3f ticks per item, sum %lld\n", name
+			, static_cast<double>(resource.allocations) / k_items
+			, static_cast<double>(scheduler.stats().ticks) / k_items, sum);
+	}
+
+} // namespace
+
+int main()
+{
+	Measure("Task per item, make_task() + then()", TaskPerItem);
+	Measure("StreamTask<>::for_each()", StreamForEach);
+	Measure("StreamTask<>::next_many()", StreamNextMany);
+	return 0;
+}
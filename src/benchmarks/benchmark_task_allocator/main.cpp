@@ -0,0 +1,118 @@
+// Creation and destruction throughput of task internals.
+// Compares Scheduler's default PoolTaskAllocator with global
+// operator new/delete (glibc malloc): raw allocate/deallocate
+// of task-sized blocks from one and several threads and
+// then() chains that allocate every step from the Scheduler.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/task_allocator.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <thread>
+#include <string>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Typical sizes of InternalCustomTask<> of function tasks
+	const std::size_t k_sizes[] = {96, 128, 160, 96, 224, 128};
+	const std::size_t k_sizes_count = sizeof(k_sizes) / sizeof(k_sizes[0]);
+
+	// Keeps `live` blocks allocated, frees and allocates them in FIFO order
+	void AllocateFree(TaskAllocator& allocator, std::size_t count, std::size_t live)
+	{
+		std::vector<void*> blocks(live, nullptr);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const std::size_t slot = (i % live);
+			const std::size_t size = k_sizes[slot % k_sizes_count];
+			allocator.deallocate(blocks[slot], size, alignof(std::max_align_t));
+			blocks[slot] = allocator.allocate(size, alignof(std::max_align_t));
+		}
+		for (std::size_t slot = 0; slot < live; ++slot)
+		{
+			allocator.deallocate(blocks[slot]
+				, k_sizes[slot % k_sizes_count], alignof(std::max_align_t));
+		}
+	}
+
+	void RunRaw(const char* name, TaskAllocator& allocator
+		, std::size_t threads_count, std::size_t live)
+	{
+		const std::size_t k_count = 2'000'000;
+		const double seconds = MeasureSeconds([&]
+		{
+			std::vector<std::thread> threads;
+			for (std::size_t i = 0; i < threads_count; ++i)
+			{
+				threads.emplace_back([&] { AllocateFree(allocator, k_count, live); });
+			}
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		});
+		const std::string row = std::string(name)
+			+ " x" + std::to_string(threads_count)
+			+ " threads, " + std::to_string(live) + " live";
+		PrintRow(row.c_str(), k_count * threads_count, seconds);
+	}
+
+	// Every step allocates new task from the scheduler's allocator
+	void RunChains(const char* name, Scheduler& scheduler)
+	{
+		const std::size_t k_chains = 200'000;
+		const std::size_t k_steps = 5;
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_chains; ++i)
+			{
+				auto task = make_task(scheduler, [] { return 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; })
+					.then([](const Task<int>& t) { return t.get().value() + 1; });
+				while (task.is_in_progress())
+				{
+					(void)scheduler.poll();
+				}
+			}
+		});
+		const std::string row = std::string(name) + " then() x5 chains";
+		PrintRow(row.c_str(), k_chains * k_steps, seconds);
+	}
+
+} // namespace
+
+int main()
+{
+	NewDeleteTaskAllocator new_delete;
+	PoolTaskAllocator pool;
+	const std::size_t k_threads[] = {1, 4};
+	const std::size_t k_live[] = {1, 1'000, 100'000};
+	for (std::size_t threads_count : k_threads)
+	{
+		for (std::size_t live : k_live)
+		{
+			RunRaw("new/delete", new_delete, threads_count, live);
+			RunRaw("PoolTaskAllocator", pool, threads_count, live);
+		}
+	}
+
+	{
+		Scheduler scheduler(new_delete);
+		RunChains("new/delete", scheduler);
+	}
+	{
+		Scheduler scheduler;
+		RunChains("PoolTaskAllocator", scheduler);
+	}
+	return 0;
+}
@@ -0,0 +1,168 @@
+// Cost of the Task<> queries that go to task internals:
+// status(), is_in_progress() and scheduler() of tasks that
+// are in progress, and Scheduler::poll() of tasks which tick()
+// only checks status of other task (like then() of Task<> does).
+#include <rename_me/scheduler.h>
+#include <rename_me/task.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <string>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Task that is finished only by the benchmark
+	struct PendingTask
+	{
+		explicit PendingTask(const bool& finish)
+			: finish_(finish)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (!finish_)
+			{
+				return Status::InProgress;
+			}
+			data_ = expected<int, void>(1);
+			return Status::Successful;
+		}
+
+		expected<int, void>& get()
+		{
+			return data_;
+		}
+
+		const bool& finish_;
+		expected<int, void> data_;
+	};
+
+	// Task that waits for other task by polling its status
+	struct WaitTask
+	{
+		explicit WaitTask(Task<int>&& task)
+			: task_(std::move(task))
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (task_.is_in_progress())
+			{
+				return Status::InProgress;
+			}
+			data_ = expected<int, void>(1);
+			return Status::Successful;
+		}
+
+		expected<int, void>& get()
+		{
+			return data_;
+		}
+
+		Task<int> task_;
+		expected<int, void> data_;
+	};
+
+	const std::size_t k_tasks = 1'000;
+
+	void RunQueries()
+	{
+		const std::size_t k_rounds = 50'000;
+		Scheduler scheduler;
+		bool finish = false;
+		std::vector<Task<int>> tasks;
+		for (std::size_t i = 0; i < k_tasks; ++i)
+		{
+			tasks.push_back(Task<int>::make<PendingTask>(scheduler, finish));
+		}
+
+		std::size_t in_progress = 0;
+		double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_rounds; ++i)
+			{
+				for (const Task<int>& task : tasks)
+				{
+					in_progress += task.is_in_progress();
+				}
+			}
+		});
+		PrintRow("Task::is_in_progress()", k_tasks * k_rounds, seconds);
+
+		std::size_t same_scheduler = 0;
+		seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_rounds; ++i)
+			{
+				for (const Task<int>& task : tasks)
+				{
+					same_scheduler += (&task.scheduler() == &scheduler);
+				}
+			}
+		});
+		PrintRow("Task::scheduler()", k_tasks * k_rounds, seconds);
+
+		seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_rounds; ++i)
+			{
+				for (Task<int>& task : tasks)
+				{
+					task.try_cancel();
+				}
+			}
+		});
+		PrintRow("Task::try_cancel()", k_tasks * k_rounds, seconds);
+
+		if ((in_progress != k_tasks * k_rounds) || (same_scheduler != k_tasks * k_rounds))
+		{
+			std::printf("Unexpected state of the tasks\n");
+		}
+		finish = true;
+		scheduler.run_until_idle();
+	}
+
+	void RunTicks()
+	{
+		const std::size_t k_polls = 5'000;
+		Scheduler scheduler;
+		bool finish = false;
+		for (std::size_t i = 0; i < k_tasks; ++i)
+		{
+			(void)Task<int>::make<WaitTask>(scheduler
+				, Task<int>::make<PendingTask>(scheduler, finish));
+		}
+
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_polls; ++i)
+			{
+				(void)scheduler.poll();
+			}
+		});
+		// Both waiting and pending tasks are ticked
+		PrintRow("poll() of waiting tasks, per tick", 2 * k_tasks * k_polls, seconds);
+
+		finish = true;
+		scheduler.run_until_idle();
+	}
+
+} // namespace
+
+int main()
+{
+	RunQueries();
+	RunTicks();
+	return 0;
+}
@@ -0,0 +1,211 @@
+// Memory layout of task internals (see detail::TaskBase and
+// NN_CACHE_LINE_SIZE). Reports footprint of every kind of the task
+// and cost of the tick while other threads read status()
+// or copy references of the ticked tasks.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/delay_task.h>
+#include <rename_me/then_chain.h>
+#include <rename_me/task_allocator.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Remembers size of the last allocated task
+	class RecordingAllocator final : public TaskAllocator
+	{
+	public:
+		virtual void* allocate(std::size_t size, std::size_t alignment) override
+		{
+			last_size = size;
+			last_alignment = alignment;
+			return new_delete.allocate(size, alignment);
+		}
+
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override
+		{
+			new_delete.deallocate(ptr, size, alignment);
+		}
+
+		NewDeleteTaskAllocator new_delete;
+		std::size_t last_size = 0;
+		std::size_t last_alignment = 0;
+	};
+
+	template<typename MakeTask>
+	void PrintFootprint(const char* name, MakeTask make_task)
+	{
+		RecordingAllocator allocator;
+		Scheduler scheduler(allocator);
+		{
+			auto task = make_task(scheduler);
+			const std::size_t granularity = PoolTaskAllocator::k_block_granularity;
+			const std::size_t block = ((allocator.last_size + granularity - 1)
+				/ granularity) * granularity;
+			std::printf("%-40s %5zu bytes, aligned by %3zu, pool block %5zu bytes\n"
+				, name, allocator.last_size, allocator.last_alignment, block);
+			task.try_cancel();
+		}
+		scheduler.run_until_idle();
+	}
+
+	void RunFootprint()
+	{
+		std::printf("NN_CACHE_LINE_SIZE=%d, sizeof(TaskBase)=%zu\n"
+			, NN_CACHE_LINE_SIZE, sizeof(detail::TaskBase));
+		PrintFootprint("make_task() -> int", [](Scheduler& scheduler)
+		{
+			return make_task(scheduler, [] { return 1; });
+		});
+		PrintFootprint("make_task() -> std::string", [](Scheduler& scheduler)
+		{
+			return make_task(scheduler, [] { return std::string("value"); });
+		});
+		PrintFootprint("make_task() -> Task<int>", [](Scheduler& scheduler)
+		{
+			return make_task(scheduler, [&scheduler] { return make_task(scheduler, [] { return 1; }); });
+		});
+		PrintFootprint("then() -> int", [](Scheduler& scheduler)
+		{
+			auto task = make_task(scheduler, [] { return 1; });
+			return task.then([](const Task<int>& t) { return t.get().value() + 1; });
+		});
+		PrintFootprint("then_chain() x3 -> int", [](Scheduler& scheduler)
+		{
+			return then_chain(make_task(scheduler, [] { return 1; }))
+				.then([](const Task<int>& t) { return t.get().value() + 1; })
+				.then([](const Task<int>& t) { return t.get().value() + 1; })
+				.then([](const Task<int>& t) { return t.get().value() + 1; })
+				.task();
+		});
+		PrintFootprint("make_delay_task()", [](Scheduler& scheduler)
+		{
+			return make_delay_task(scheduler, std::chrono::milliseconds(1));
+		});
+	}
+
+#if !(NN_SINGLE_THREADED)
+	// Never finishes, touches own state on every tick
+	struct SpinTask
+	{
+		Status tick(const ExecutionContext&)
+		{
+			++ticks_;
+			return Status::InProgress;
+		}
+
+		expected<void, void>& get()
+		{
+			return data_;
+		}
+
+		std::uint64_t ticks_ = 0;
+		expected<void, void> data_;
+	};
+
+	using SpinInternalTask = detail::InternalCustomTask<void, void, SpinTask>;
+
+	enum class Interference
+	{
+		None,
+		ReadStatus,
+		CopyReferences,
+	};
+
+	void RunTicks(const char* name, Interference interference, std::size_t threads)
+	{
+		const std::size_t k_tasks = 64;
+		const std::size_t k_rounds = 100'000;
+		Scheduler scheduler;
+		std::vector<detail::ErasedTask> tasks;
+		for (std::size_t i = 0; i < k_tasks; ++i)
+		{
+			tasks.push_back(SpinInternalTask::Make(scheduler)
+				.to_base<detail::TaskBase>());
+		}
+
+		std::atomic<bool> stop(false);
+		std::atomic<std::size_t> started(0);
+		std::vector<std::thread> workers;
+		for (std::size_t t = 0; (interference != Interference::None) && (t < threads); ++t)
+		{
+			workers.emplace_back([&, t]
+			{
+				++started;
+				std::size_t i = t;
+				std::size_t in_progress = 0;
+				while (!stop.load(std::memory_order_relaxed))
+				{
+					detail::TaskBase& task = *tasks[i++ % k_tasks];
+					if (interference == Interference::ReadStatus)
+					{
+						in_progress += (task.status() == Status::InProgress);
+					}
+					else
+					{
+						task.add_ref_count();
+						(void)task.remove_ref_count();
+					}
+				}
+				(void)in_progress;
+			});
+		}
+		while (started != workers.size())
+		{
+			std::this_thread::yield();
+		}
+
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t r = 0; r < k_rounds; ++r)
+			{
+				for (detail::ErasedTask& task : tasks)
+				{
+					(void)task->update();
+				}
+			}
+		});
+		stop = true;
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		PrintRow(name, k_tasks * k_rounds, seconds);
+	}
+
+	void RunContention()
+	{
+		const std::size_t threads = std::max<std::size_t>(1
+			, std::min<std::size_t>(3, std::thread::hardware_concurrency() - 1));
+		std::printf("tick of %zu tasks with %zu other threads\n", std::size_t(64), threads);
+		RunTicks("tick, no other threads", Interference::None, threads);
+		RunTicks("tick, other threads read status()", Interference::ReadStatus, threads);
+		RunTicks("tick, other threads copy references", Interference::CopyReferences, threads);
+	}
+#endif
+
+} // namespace
+
+int main()
+{
+	RunFootprint();
+#if !(NN_SINGLE_THREADED)
+	RunContention();
+#endif
+	return 0;
+}
@@ -0,0 +1,94 @@
+// then() chains of 8 steps: every then() as separate task
+// versus the same functors fused with then_chain().
+// Reports allocations from the Scheduler's TaskAllocator per chain
+// and latency from posting the root task till the last step finishes.
+#include <rename_me/scheduler.h>
+#include <rename_me/function_task.h>
+#include <rename_me/then_chain.h>
+#include <rename_me/task_allocator.h>
+
+#include "benchmark_tools.h"
+
+#include <string>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	class CountingAllocator final : public TaskAllocator
+	{
+	public:
+		virtual void* allocate(std::size_t size, std::size_t alignment) override
+		{
+			++allocations;
+			return pool.allocate(size, alignment);
+		}
+
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override
+		{
+			pool.deallocate(ptr, size, alignment);
+		}
+
+		PoolTaskAllocator pool;
+		std::size_t allocations = 0;
+	};
+
+	const std::size_t k_chains = 200'000;
+	const std::size_t k_steps = 8;
+
+	int Step(const Task<int>& task)
+	{
+		return task.get().value() + 1;
+	}
+
+	Task<int> MakeChain(Scheduler& scheduler)
+	{
+		return make_task(scheduler, [] { return 0; })
+			.then(&Step).then(&Step).then(&Step).then(&Step)
+			.then(&Step).then(&Step).then(&Step).then(&Step);
+	}
+
+	Task<int> MakeFusedChain(Scheduler& scheduler)
+	{
+		return then_chain(make_task(scheduler, [] { return 0; }))
+			.then(&Step).then(&Step).then(&Step).then(&Step)
+			.then(&Step).then(&Step).then(&Step).then(&Step)
+			.task();
+	}
+
+	template<typename MakeTask>
+	void Run(const char* name, MakeTask make)
+	{
+		CountingAllocator allocator;
+		Scheduler scheduler(allocator);
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_chains; ++i)
+			{
+				Task<int> task = make(scheduler);
+				while (task.is_in_progress())
+				{
+					(void)scheduler.poll();
+				}
+			}
+		});
+		const std::string row = std::string(name)
+			+ " then() x" + std::to_string(k_steps) + " chains";
+		PrintRow(row.c_str(), k_chains, seconds);
+		std::printf("%-48s %12.2f allocations/chain\n", ""
+			, static_cast<double>(allocator.allocations) / static_cast<double>(k_chains));
+	}
+
+} // namespace
+
+int main()
+{
+	Run("separate tasks", &MakeChain);
+	Run("then_chain()", &MakeFusedChain);
+	return 0;
+}
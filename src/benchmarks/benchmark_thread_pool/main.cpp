@@ -0,0 +1,112 @@
+// Throughput of ThreadPoolScheduler depending on workers count.
+// Compares with single Scheduler polled from the main thread.
+// "fan-out" tasks are created from the single worker thread,
+// so other workers get them only by stealing.
+#include <rename_me/thread_pool_scheduler.h>
+#include <rename_me/function_task.h>
+
+#include "benchmark_tools.h"
+
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <string>
+
+#include <cstdint>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	std::atomic<std::uint64_t> g_sink(0);
+
+	void Work(std::size_t iterations)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i < iterations; ++i)
+		{
+			hash = (hash ^ i) * 1099511628211ull;
+		}
+		g_sink += hash;
+	}
+
+	void WaitAllTasks(Scheduler& scheduler)
+	{
+		while (scheduler.has_tasks())
+		{
+			if (scheduler.poll() == 0)
+			{
+				// ThreadPoolScheduler: nothing to poll, don't take workers CPU
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	double RunPosted(Scheduler& scheduler, std::size_t tasks, std::size_t iterations)
+	{
+		return MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < tasks; ++i)
+			{
+				(void)make_task(scheduler, [=] { Work(iterations); });
+			}
+			WaitAllTasks(scheduler);
+		});
+	}
+
+	double RunFanOut(Scheduler& scheduler, std::size_t tasks, std::size_t iterations)
+	{
+		return MeasureSeconds([&]
+		{
+			(void)make_task(scheduler, [&scheduler, tasks, iterations]
+			{
+				for (std::size_t i = 0; i < tasks; ++i)
+				{
+					(void)make_task(scheduler, [=] { Work(iterations); });
+				}
+			});
+			WaitAllTasks(scheduler);
+		});
+	}
+
+	void RunAll(const std::string& name, Scheduler& scheduler)
+	{
+		const std::size_t k_heavy_tasks = 20'000;
+		const std::size_t k_heavy_iterations = 20'000;
+		const std::size_t k_light_tasks = 1'000'000;
+
+		PrintRow((name + " posted, heavy").c_str(), k_heavy_tasks
+			, RunPosted(scheduler, k_heavy_tasks, k_heavy_iterations));
+		PrintRow((name + " fan-out, heavy").c_str(), k_heavy_tasks
+			, RunFanOut(scheduler, k_heavy_tasks, k_heavy_iterations));
+		PrintRow((name + " posted, empty").c_str(), k_light_tasks
+			, RunPosted(scheduler, k_light_tasks, 0));
+		PrintRow((name + " fan-out, empty").c_str(), k_light_tasks
+			, RunFanOut(scheduler, k_light_tasks, 0));
+	}
+
+} // namespace
+
+int main()
+{
+	{
+		Scheduler scheduler;
+		RunAll("Scheduler::poll()", scheduler);
+	}
+
+	const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+	for (std::size_t workers = 1; ; workers *= 2)
+	{
+		workers = std::min(workers, hardware);
+		ThreadPoolScheduler scheduler(workers);
+		RunAll("ThreadPoolScheduler(" + std::to_string(workers) + ")", scheduler);
+		if (workers == hardware)
+		{
+			break;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,125 @@
+// Cost of many sleeping tasks. Compares tasks that wait in
+// the Scheduler's timer wheel (make_delay_task()) with tasks
+// that check deadline on every tick. Also measures posting
+// and canceling of timers.
+#include <rename_me/scheduler.h>
+#include <rename_me/delay_task.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+#include <chrono>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Sleeps by polling the clock
+	struct PollingDelayTask
+	{
+		explicit PollingDelayTask(Clock::time_point deadline)
+			: deadline_(deadline)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext& context)
+		{
+			if (context.cancel_requested)
+			{
+				data_ = MakeExpectedWithDefaultError<expected<void, void>>();
+				return Status::Canceled;
+			}
+			return ((Clock::now() < deadline_) ? Status::InProgress : Status::Successful);
+		}
+
+		expected<void, void>& get()
+		{
+			return data_;
+		}
+
+		const Clock::time_point deadline_;
+		expected<void, void> data_;
+	};
+
+	template<typename MakeTask>
+	void RunSleeping(const char* name, std::size_t sleeping, MakeTask make_task)
+	{
+		const std::size_t k_polls = 100;
+		Scheduler scheduler;
+		std::vector<Task<>> tasks;
+		tasks.reserve(sleeping);
+		for (std::size_t i = 0; i < sleeping; ++i)
+		{
+			tasks.push_back(make_task(scheduler, std::chrono::hours(1)));
+		}
+		(void)scheduler.poll();
+
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < k_polls; ++i)
+			{
+				(void)scheduler.poll();
+			}
+		});
+		std::printf("%-36s %8zu sleeping %14.0f ns/poll\n"
+			, name, sleeping, (seconds * 1e9) / static_cast<double>(k_polls));
+
+		for (Task<>& task : tasks)
+		{
+			task.try_cancel();
+		}
+		scheduler.run_until_idle();
+	}
+
+	void RunPostCancel(std::size_t count)
+	{
+		Scheduler scheduler;
+		std::vector<Task<>> tasks;
+		tasks.reserve(count);
+		const double post_seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				// Spread over all levels of the wheel
+				const auto delay = std::chrono::milliseconds(1 + (i * 7919) % 10'000'000);
+				tasks.push_back(make_delay_task(scheduler, delay));
+			}
+			(void)scheduler.poll();
+		});
+		PrintRow("make_delay_task() + poll()", count, post_seconds);
+
+		const double cancel_seconds = MeasureSeconds([&]
+		{
+			for (Task<>& task : tasks)
+			{
+				task.try_cancel();
+			}
+			scheduler.run_until_idle();
+		});
+		PrintRow("try_cancel() + run_until_idle()", count, cancel_seconds);
+	}
+
+} // namespace
+
+int main()
+{
+	const std::size_t k_sleeping[] = {1'000, 10'000, 100'000};
+	for (std::size_t sleeping : k_sleeping)
+	{
+		RunSleeping("timer wheel", sleeping, [](Scheduler& scheduler, auto delay)
+		{
+			return make_delay_task(scheduler, delay);
+		});
+		RunSleeping("polling tasks", sleeping, [](Scheduler& scheduler, auto delay)
+		{
+			return Task<>::make<PollingDelayTask>(scheduler, Clock::now() + delay);
+		});
+	}
+	RunPostCancel(100'000);
+	return 0;
+}
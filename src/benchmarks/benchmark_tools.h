@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <utility>
+
+#include <cstdio>
+
+namespace nn
+{
+	namespace benchmark
+	{
+
+		using Clock = std::chrono::steady_clock;
+
+		template<typename F>
+		double MeasureSeconds(F&& f)
+		{
+			const auto start = Clock::now();
+			std::forward<F>(f)();
+			const std::chrono::duration<double> elapsed = (Clock::now() - start);
+			return elapsed.count();
+		}
+
+		inline void PrintRow(const char* name, std::size_t count, double seconds)
+		{
+			const double ns_per_op = (seconds * 1e9) / static_cast<double>(count);
+			const double ops_per_second = static_cast<double>(count) / seconds;
+			std::printf("%-48s %12zu ops %10.2f ns/op %14.0f ops/s\n"
+				, name, count, ns_per_op, ops_per_second);
+		}
+
+	} // namespace benchmark
+} // namespace nn
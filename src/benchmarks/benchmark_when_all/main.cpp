@@ -0,0 +1,155 @@
+// Waiting for many tasks at once. Compares when_all() (tasks
+// count themselves once they finish) with the task that checks
+// status() of every task on each tick until all of them finish
+// (think of make_in_place_task() that polls N tasks).
+// All tasks, except the last one, finish on the first tick.
+// Last one needs several ticks.
+#include <rename_me/scheduler.h>
+#include <rename_me/when_all.h>
+
+#include "benchmark_tools.h"
+
+#include <vector>
+
+#include <cstdio>
+
+namespace
+{
+
+	using namespace nn;
+	using namespace nn::benchmark;
+
+	// Finishes after given number of ticks
+	struct CountdownTask
+	{
+		explicit CountdownTask(std::size_t ticks)
+			: ticks_(ticks)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (--ticks_ > 0)
+			{
+				return Status::InProgress;
+			}
+			data_.emplace(1);
+			return Status::Successful;
+		}
+
+		expected<int, void>& get()
+		{
+			return data_;
+		}
+
+		std::size_t ticks_;
+		expected<int, void> data_;
+	};
+
+	// Checks all tasks on every tick
+	struct PollAllTask
+	{
+		explicit PollAllTask(std::vector<Task<int>>&& tasks)
+			: tasks_(std::move(tasks))
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			for (const Task<int>& task : tasks_)
+			{
+				if (task.is_in_progress())
+				{
+					return Status::InProgress;
+				}
+			}
+			int sum = 0;
+			for (const Task<int>& task : tasks_)
+			{
+				sum += task.get().value();
+			}
+			data_.emplace(sum);
+			return Status::Successful;
+		}
+
+		expected<int, void>& get()
+		{
+			return data_;
+		}
+
+		std::vector<Task<int>> tasks_;
+		expected<int, void> data_;
+	};
+
+	std::vector<Task<int>> MakeTasks(Scheduler& scheduler, std::size_t count, std::size_t ticks)
+	{
+		std::vector<Task<int>> tasks;
+		tasks.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const bool last = ((i + 1) == count);
+			tasks.push_back(Task<int>::make<CountdownTask>(scheduler, last ? ticks : 1));
+		}
+		return tasks;
+	}
+
+	// Same scheduler waits several times: first round warms up
+	// the pool of task's memory
+	const std::size_t k_rounds = 5;
+
+	template<typename MakeWait>
+	void Run(const char* name, std::size_t count, std::size_t ticks, MakeWait make_wait)
+	{
+		Scheduler scheduler;
+		auto wait = [&]
+		{
+			auto task = make_wait(scheduler, MakeTasks(scheduler, count, ticks));
+			scheduler.run_until(task);
+		};
+		wait();
+		const std::uint64_t ticks_before = scheduler.stats().ticks;
+		const double seconds = MeasureSeconds([&]
+		{
+			for (std::size_t i = 1; i < k_rounds; ++i)
+			{
+				wait();
+			}
+		});
+		const std::size_t waited = count * (k_rounds - 1);
+		char row[128];
+		std::snprintf(row, sizeof(row), "%s, %zu tasks", name, count);
+		PrintRow(row, waited, seconds);
+		std::printf("%s: %.2f ticks per task\n", name
+			, static_cast<double>(scheduler.stats().ticks - ticks_before)
+				/ static_cast<double>(waited));
+	}
+
+	void RunWhenAll(std::size_t count, std::size_t ticks)
+	{
+		Run("when_all()", count, ticks, [](Scheduler& scheduler, std::vector<Task<int>> tasks)
+		{
+			return when_all(scheduler, std::move(tasks));
+		});
+	}
+
+	void RunPollAll(std::size_t count, std::size_t ticks)
+	{
+		Run("polling status()", count, ticks, [](Scheduler& scheduler, std::vector<Task<int>> tasks)
+		{
+			return Task<int>::make<PollAllTask>(scheduler, std::move(tasks));
+		});
+	}
+
+} // namespace
+
+int main()
+{
+	const std::size_t k_ticks = 64;
+	RunWhenAll(1'000, k_ticks);
+	RunPollAll(1'000, k_ticks);
+	RunWhenAll(100'000, k_ticks);
+	RunPollAll(100'000, k_ticks);
+	return 0;
+}
@@ -1,5 +1,6 @@
 #include <rename_me/future_task.h>
 #include <chrono>
+#include <thread>
 #include <cstdio>
 #include <cassert>
 
@@ -32,9 +33,7 @@ int main()
 
 	nn::Scheduler scheduler;
 	nn::Task<int> task = do_work(scheduler, 10);
-	while (task.is_in_progress())
-	{
-		scheduler.poll();
-	}
+	// Polls the scheduler, sleeps while there is nothing to do
+	scheduler.run_until(task);
 	return task.get().value(); // Returns 10 * 2 * 3 = 60
 }
@@ -0,0 +1,346 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/scheduler.h>
+#include <rename_me/detail/channel_base.h>
+#include <rename_me/detail/task_list.h>
+#include <rename_me/detail/threading.h>
+
+#include <vector>
+#include <optional>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <algorithm>
+
+#include <cstddef>
+#include <cassert>
+
+namespace nn
+{
+
+	// Bounded multi-producer/multi-consumer queue of values between
+	// tasks (e.g., stages of the pipeline). Keeps up to `capacity`
+	// values in the ring that is allocated once.
+	//
+	// send() and receive() return tasks: ready task (nothing is
+	// allocated and posted) if the operation completes right away,
+	// otherwise the task that waits in the channel. Waiting task is not
+	// polled: the other side completes it and posts it to the scheduler.
+	// Until then it's counted by Scheduler::tasks_count().
+	// Full channel makes senders wait (backpressure), empty channel -
+	// receivers. Waiting operations are completed in FIFO order.
+	// try_cancel() of the waiting operation has no effect, close()
+	// the channel to stop waiting.
+	// Thread-safe; the channel should outlive waiting operations
+	//
+	//   Channel<Row> rows(scheduler, 64);
+	//   rows.send(ReadRow()).then([&] { ... });
+	//   rows.receive_many(16).then([](const Task<std::vector<Row>>& batch) { ... });
+	//
+	// Consumer may call receive() again from the continuation. If the
+	// value is ready, the continuation is invoked inline only few times
+	// in a row, then it's posted (see Task<>::make_ready()): long
+	// backlog of buffered values does not grow the stack
+	template<typename T>
+	class Channel
+	{
+	public:
+		// `capacity` should be greater than 0.
+		// Tasks of the channel are posted to the `scheduler`
+		explicit Channel(Scheduler& scheduler, std::size_t capacity);
+		// close()-es the channel. Buffered values are destroyed
+		~Channel();
+		Channel(Channel&& rhs) = delete;
+		Channel& operator=(Channel&& rhs) = delete;
+		Channel(const Channel& rhs) = delete;
+		Channel& operator=(const Channel& rhs) = delete;
+
+		// Gives `value` to the first waiting receiver or keeps
+		// it in the ring. Waits if the ring is full.
+		// Fails if the channel is closed
+		Task<void, void> send(T value);
+		// Takes the first value. Waits if the channel is empty.
+		// Fails if the channel is closed and empty
+		Task<T, void> receive();
+		// Same as receive(), but takes up to `count` values at once,
+		// all buffered ones if there are enough. Waiting receiver
+		// gets single value from the sender
+		Task<std::vector<T>, void> receive_many(std::size_t count);
+		// Fails waiting senders (their values are dropped)
+		// and receivers. Buffered values still can be received.
+		// Subsequent send() fails
+		void close();
+
+		bool is_closed() const;
+		// Buffered values
+		std::size_t size() const;
+		std::size_t capacity() const;
+
+	private:
+		using SendTask = detail::InternalCustomTask<void, void, detail::ChannelSendTask<T>>;
+		using Receiver = detail::ChannelReceiver<T>;
+		using Lock = std::unique_lock<detail::Mutex>;
+
+		template<typename Value>
+		Task<Value, void> wait_value();
+		void push(T&& value);
+		T pop();
+		// Moves values of waiting senders to the freed room of the ring.
+		// Senders are posted later, without the lock
+		void take_senders(detail::TaskList& sent);
+		void push_receiver(Receiver& receiver);
+		Receiver* pop_receiver();
+		void post(detail::TaskList& tasks);
+		void post(Receiver& receiver);
+
+	private:
+		Scheduler& scheduler_;
+		mutable detail::Mutex guard_;
+		std::pmr::vector<std::optional<T>> ring_;
+		std::size_t head_;
+		std::size_t size_;
+		bool closed_;
+		// Non-empty only if the ring is full
+		detail::TaskList senders_;
+		// Non-empty only if the ring is empty
+		Receiver* receivers_head_;
+		Receiver* receivers_tail_;
+	};
+
+	template<typename T>
+	/*explicit*/ Channel<T>::Channel(Scheduler& scheduler, std::size_t capacity)
+		: scheduler_(scheduler)
+		, guard_()
+		, ring_(capacity, &scheduler.memory_resource())
+		, head_(0)
+		, size_(0)
+		, closed_(false)
+		, senders_()
+		, receivers_head_(nullptr)
+		, receivers_tail_(nullptr)
+	{
+		assert((capacity > 0) && "Channel should keep at least one value");
+	}
+
+	template<typename T>
+	Channel<T>::~Channel()
+	{
+		close();
+	}
+
+	template<typename T>
+	Task<void, void> Channel<T>::send(T value)
+	{
+		Lock lock(guard_);
+		if (closed_)
+		{
+			return Task<void, void>::make_ready(scheduler_
+				, MakeExpectedWithDefaultError<expected<void, void>>());
+		}
+		if (Receiver* receiver = pop_receiver())
+		{
+			lock.unlock();
+			receiver->set_value(std::move(value));
+			post(*receiver);
+			return Task<void, void>::make_ready(scheduler_, expected<void, void>());
+		}
+		if (size_ < ring_.size())
+		{
+			push(std::move(value));
+			return Task<void, void>::make_ready(scheduler_, expected<void, void>());
+		}
+		auto task = SendTask::Make(scheduler_, std::move(value));
+		detail::CountWaitingTask(scheduler_);
+		senders_.push_back(task.template to_base<detail::TaskBase>());
+		return Task<void, void>(task.template to_base<detail::InternalTask<void, void>>());
+	}
+
+	template<typename T>
+	Task<T, void> Channel<T>::receive()
+	{
+		Lock lock(guard_);
+		if (size_ == 0)
+		{
+			return wait_value<T>();
+		}
+		T value = pop();
+		detail::TaskList sent;
+		take_senders(sent);
+		lock.unlock();
+		post(sent);
+		return Task<T, void>::make_ready(scheduler_, expected<T, void>(std::move(value)));
+	}
+
+	template<typename T>
+	Task<std::vector<T>, void> Channel<T>::receive_many(std::size_t count)
+	{
+		assert(count > 0);
+		Lock lock(guard_);
+		if (size_ == 0)
+		{
+			return wait_value<std::vector<T>>();
+		}
+		std::vector<T> values;
+		values.reserve((std::min)(count, size_));
+		while ((size_ > 0) && (values.size() < count))
+		{
+			values.push_back(pop());
+		}
+		detail::TaskList sent;
+		take_senders(sent);
+		lock.unlock();
+		post(sent);
+		return Task<std::vector<T>, void>::make_ready(scheduler_
+			, expected<std::vector<T>, void>(std::move(values)));
+	}
+
+	template<typename T>
+	template<typename Value>
+	Task<Value, void> Channel<T>::wait_value()
+	{
+		// Invoked under the lock
+		if (closed_)
+		{
+			return Task<Value, void>::make_ready(scheduler_
+				, MakeExpectedWithDefaultError<expected<Value, void>>());
+		}
+		using ReceiveTask = detail::InternalCustomTask<Value, void
+			, detail::ChannelReceiveTask<T, Value>>;
+		auto task = ReceiveTask::Make(scheduler_);
+		Receiver& receiver = task->task();
+		receiver.set_task(task.template to_base<detail::TaskBase>().detach());
+		detail::CountWaitingTask(scheduler_);
+		push_receiver(receiver);
+		return Task<Value, void>(task.template to_base<detail::InternalTask<Value, void>>());
+	}
+
+	template<typename T>
+	void Channel<T>::close()
+	{
+		detail::TaskList senders;
+		Receiver* receivers = nullptr;
+		{
+			Lock lock(guard_);
+			if (closed_)
+			{
+				return;
+			}
+			closed_ = true;
+			while (!senders_.empty())
+			{
+				senders.push_back(senders_.remove_after(nullptr));
+			}
+			receivers = receivers_head_;
+			receivers_head_ = nullptr;
+			receivers_tail_ = nullptr;
+		}
+		// Without values: tasks fail once ticked
+		post(senders);
+		while (receivers)
+		{
+			Receiver* next = receivers->next();
+			post(*receivers);
+			receivers = next;
+		}
+	}
+
+	template<typename T>
+	bool Channel<T>::is_closed() const
+	{
+		Lock lock(guard_);
+		return closed_;
+	}
+
+	template<typename T>
+	std::size_t Channel<T>::size() const
+	{
+		Lock lock(guard_);
+		return size_;
+	}
+
+	template<typename T>
+	std::size_t Channel<T>::capacity() const
+	{
+		return ring_.size();
+	}
+
+	template<typename T>
+	void Channel<T>::push(T&& value)
+	{
+		assert(size_ < ring_.size());
+		ring_[(head_ + size_) % ring_.size()].emplace(std::move(value));
+		++size_;
+	}
+
+	template<typename T>
+	T Channel<T>::pop()
+	{
+		assert(size_ > 0);
+		std::optional<T>& slot = ring_[head_];
+		T value = std::move(*slot);
+		slot.reset();
+		head_ = ((head_ + 1) % ring_.size());
+		--size_;
+		return value;
+	}
+
+	template<typename T>
+	void Channel<T>::take_senders(detail::TaskList& sent)
+	{
+		while ((size_ < ring_.size()) && !senders_.empty())
+		{
+			detail::ErasedTask task = senders_.remove_after(nullptr);
+			push(static_cast<SendTask&>(*task).task().take_value());
+			sent.push_back(std::move(task));
+		}
+	}
+
+	template<typename T>
+	void Channel<T>::push_receiver(Receiver& receiver)
+	{
+		assert(!receiver.next());
+		if (receivers_tail_)
+		{
+			receivers_tail_->set_next(&receiver);
+		}
+		else
+		{
+			receivers_head_ = &receiver;
+		}
+		receivers_tail_ = &receiver;
+	}
+
+	template<typename T>
+	typename Channel<T>::Receiver* Channel<T>::pop_receiver()
+	{
+		Receiver* receiver = receivers_head_;
+		if (!receiver)
+		{
+			return nullptr;
+		}
+		receivers_head_ = receiver->next();
+		if (!receivers_head_)
+		{
+			receivers_tail_ = nullptr;
+		}
+		receiver->set_next(nullptr);
+		return receiver;
+	}
+
+	template<typename T>
+	void Channel<T>::post(detail::TaskList& tasks)
+	{
+		while (!tasks.empty())
+		{
+			detail::PostWaitingTask(scheduler_, tasks.remove_after(nullptr));
+		}
+	}
+
+	template<typename T>
+	void Channel<T>::post(Receiver& receiver)
+	{
+		// Reference is owned by the channel while receiver waits
+		detail::PostWaitingTask(scheduler_, detail::ErasedTask::attach(receiver.task()));
+	}
+
+} // namespace nn
@@ -10,6 +10,11 @@ namespace nn
 {
 	class Scheduler;
 
+	namespace detail
+	{
+		class TimerNode;
+	} // namespace detail
+
 	enum class Status : std::uint8_t
 	{
 		InProgress,
@@ -18,6 +23,15 @@ namespace nn
 		Canceled,
 	};
 
+	// Scheduler ticks tasks of higher priority first.
+	// See Task::make() and Scheduler::poll()
+	enum class Priority : std::uint8_t
+	{
+		High,
+		Normal,
+		Low,
+	};
+
 	struct ExecutionContext
 	{
 		Scheduler& scheduler;
@@ -45,6 +59,14 @@ namespace nn
 		// be invoked.
 		// Can be useful for creating no-op (ready) tasks.
 		Status initial_status() const;
+		// Optional.
+		// If exists, task is not posted to scheduler immediately.
+		// Instead, it waits in scheduler's timer wheel and is
+		// not ticked until timer's deadline expires or cancel is
+		// requested. Continuations (see Task::on_finish()) are posted
+		// as usual, without waiting for the timer.
+		// See make_delay_task()
+		detail::TimerNode& timer();
 	};
 #endif
 
@@ -103,4 +125,23 @@ namespace nn
 	{
 	};
 
+	template<typename CustomTask>
+	using TimerInterface = std::void_t<
+			typename detail::VoidifySame<
+				detail::TimerNode&, decltype(std::declval<CustomTask&>()
+					.timer())>::type>;
+
+	template<typename CustomTask, typename = void>
+	struct HasTimer
+		: std::false_type
+	{
+	};
+
+	template<typename CustomTask>
+	struct HasTimer<CustomTask
+		, TimerInterface<CustomTask>>
+		: std::true_type
+	{
+	};
+
 } // namespace nn
@@ -0,0 +1,50 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/detail/delay_task_base.h>
+
+#include <chrono>
+
+namespace nn
+{
+
+	// Task that finishes successfully once `deadline` expires.
+	// Until then the task is kept in the Scheduler's timer wheel
+	// and is not ticked: sleeping tasks cost nothing for poll().
+	// Timers have 1ms resolution and never expire earlier.
+	// try_cancel() finishes the task with Canceled status
+	// on the next poll().
+	inline Task<void, void> make_delay_task(Scheduler& scheduler
+		, std::chrono::steady_clock::time_point deadline)
+	{
+		return Task<void, void>::make<detail::DelayTask>(
+			scheduler, deadline, Status::Successful);
+	}
+
+	template<typename Rep, typename Period>
+	Task<void, void> make_delay_task(Scheduler& scheduler
+		, const std::chrono::duration<Rep, Period>& delay)
+	{
+		return make_delay_task(scheduler, std::chrono::steady_clock::now()
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay));
+	}
+
+	// Same as make_delay_task(), but fails once `deadline` expires.
+	// Intended to be raced with other task: cancel the task
+	// from timeout's on_fail() and cancel timeout once
+	// the task finishes
+	inline Task<void, void> make_timeout_task(Scheduler& scheduler
+		, std::chrono::steady_clock::time_point deadline)
+	{
+		return Task<void, void>::make<detail::DelayTask>(
+			scheduler, deadline, Status::Failed);
+	}
+
+	template<typename Rep, typename Period>
+	Task<void, void> make_timeout_task(Scheduler& scheduler
+		, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		return make_timeout_task(scheduler, std::chrono::steady_clock::now()
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+	}
+
+} // namespace nn
@@ -0,0 +1,64 @@
+#pragma once
+#include <rename_me/scheduler_stats.h>
+
+#include <atomic>
+
+#include <cstdint>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Histogram that can be recorded from many threads at once.
+		// Relaxed counters: snapshot() may see partially recorded value
+		class AtomicHistogram
+		{
+		public:
+			explicit AtomicHistogram();
+			AtomicHistogram(AtomicHistogram&& rhs) = delete;
+			AtomicHistogram& operator=(AtomicHistogram&& rhs) = delete;
+			AtomicHistogram(const AtomicHistogram& rhs) = delete;
+			AtomicHistogram& operator=(const AtomicHistogram& rhs) = delete;
+
+			void record(std::uint64_t value);
+			Histogram snapshot() const;
+
+		private:
+			std::atomic<std::uint64_t> counts_[Histogram::k_buckets];
+			std::atomic<std::uint64_t> sum_;
+		};
+
+		/*explicit*/ inline AtomicHistogram::AtomicHistogram()
+			: counts_()
+			, sum_(0)
+		{
+			for (auto& count : counts_)
+			{
+				count.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		inline void AtomicHistogram::record(std::uint64_t value)
+		{
+			counts_[Histogram::BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+			sum_.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		inline Histogram AtomicHistogram::snapshot() const
+		{
+			Histogram histogram;
+			for (std::size_t i = 0; i < Histogram::k_buckets; ++i)
+			{
+				const std::uint64_t count = counts_[i].load(std::memory_order_relaxed);
+				if (count != 0)
+				{
+					histogram.add(i, count, 0);
+				}
+			}
+			histogram.add(0, 0, sum_.load(std::memory_order_relaxed));
+			return histogram;
+		}
+
+	} // namespace detail
+} // namespace nn
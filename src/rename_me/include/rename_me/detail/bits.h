@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace nn
+{
+	namespace detail
+	{
+
+		inline unsigned CountTrailingZeros(std::uint64_t v)
+		{
+			assert(v != 0);
+#if defined(_MSC_VER)
+			unsigned long index = 0;
+			_BitScanForward64(&index, v);
+			return static_cast<unsigned>(index);
+#else
+			return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+		}
+
+		inline unsigned HighestBit(std::uint64_t v)
+		{
+			assert(v != 0);
+#if defined(_MSC_VER)
+			unsigned long index = 0;
+			_BitScanReverse64(&index, v);
+			return static_cast<unsigned>(index);
+#else
+			return static_cast<unsigned>(63 - __builtin_clzll(v));
+#endif
+		}
+
+		inline std::uint64_t RotateRight(std::uint64_t v, unsigned shift)
+		{
+			shift &= 63;
+			return ((shift == 0) ? v : ((v >> shift) | (v << (64 - shift))));
+		}
+
+	} // namespace detail
+} // namespace nn
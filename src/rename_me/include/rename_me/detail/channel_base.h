@@ -0,0 +1,114 @@
+#pragma once
+#include <rename_me/custom_task.h>
+#include <rename_me/expected.h>
+#include <rename_me/detail/internal_task.h>
+
+#include <vector>
+#include <optional>
+#include <utility>
+#include <type_traits>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Receive operation of the Channel that waits for the value.
+		// Node of the intrusive FIFO of the Channel's receivers
+		template<typename T>
+		class ChannelReceiver
+		{
+		public:
+			virtual void set_value(T&& value) = 0;
+
+			ChannelReceiver* next() const           { return next_; }
+			void set_next(ChannelReceiver* next)    { next_ = next; }
+			// Owned reference to the task of this operation
+			TaskBase* task() const                  { return task_; }
+			void set_task(TaskBase* task)           { task_ = task; }
+
+		protected:
+			~ChannelReceiver() = default;
+
+		private:
+			ChannelReceiver* next_ = nullptr;
+			TaskBase* task_ = nullptr;
+		};
+
+		// Not posted until the sender sets the value (or the channel
+		// is closed), ticked once then. `Value` is T for receive()
+		// or std::vector<T> for receive_many()
+		template<typename T, typename Value>
+		class ChannelReceiveTask final : public ChannelReceiver<T>
+		{
+		public:
+			explicit ChannelReceiveTask()
+				: data_()
+			{
+			}
+
+			virtual void set_value(T&& value) override
+			{
+				if constexpr (std::is_same_v<Value, T>)
+				{
+					data_.emplace(std::move(value));
+				}
+				else
+				{
+					data_.emplace();
+					data_->push_back(std::move(value));
+				}
+			}
+
+			// Value was given before the task is posted,
+			// try_cancel() has no effect
+			Status tick(const ExecutionContext&)
+			{
+				return (data_.has_value() ? Status::Successful : Status::Failed);
+			}
+
+			expected<Value, void>& get()
+			{
+				return data_;
+			}
+
+		private:
+			expected<Value, void> data_;
+		};
+
+		// Send operation of the Channel that waits for the room.
+		// Not posted until the receiver takes the value (or the
+		// channel is closed), ticked once then
+		template<typename T>
+		class ChannelSendTask
+		{
+		public:
+			explicit ChannelSendTask(T&& value)
+				: value_(std::move(value))
+				, data_(unexpected_void())
+			{
+			}
+
+			T take_value()
+			{
+				data_ = expected<void, void>();
+				return std::move(value_);
+			}
+
+			Status tick(const ExecutionContext&)
+			{
+				return (data_.has_value() ? Status::Successful : Status::Failed);
+			}
+
+			expected<void, void>& get()
+			{
+				return data_;
+			}
+
+		private:
+			T value_;
+			expected<void, void> data_;
+		};
+
+	} // namespace detail
+} // namespace nn
@@ -0,0 +1,67 @@
+#pragma once
+#include <rename_me/custom_task.h>
+#include <rename_me/detail/timer_wheel.h>
+
+#include <cassert>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		class DelayTask
+		{
+		public:
+			using Clock = TimerNode::Clock;
+
+			// `on_expire` is a status of the task once `deadline` expires
+			explicit DelayTask(Clock::time_point deadline, Status on_expire)
+				: timer_(deadline)
+				, on_expire_(on_expire)
+				, data_()
+			{
+				assert((on_expire == Status::Successful)
+					|| (on_expire == Status::Failed));
+			}
+
+			DelayTask(const DelayTask&) = delete;
+			DelayTask(DelayTask&&) = delete;
+
+			Status tick(const ExecutionContext& context)
+			{
+				if (context.cancel_requested)
+				{
+					data_ = MakeExpectedWithDefaultError<expected<void, void>>();
+					return Status::Canceled;
+				}
+				if (Clock::now() < timer_.deadline())
+				{
+					// Not expected: Scheduler ticks the task
+					// only when the timer expires
+					return Status::InProgress;
+				}
+				if (on_expire_ == Status::Failed)
+				{
+					data_ = MakeExpectedWithDefaultError<expected<void, void>>();
+				}
+				return on_expire_;
+			}
+
+			expected<void, void>& get()
+			{
+				return data_;
+			}
+
+			TimerNode& timer()
+			{
+				return timer_;
+			}
+
+		private:
+			TimerNode timer_;
+			const Status on_expire_;
+			expected<void, void> data_;
+		};
+
+	} // namespace detail
+} // namespace nn
@@ -4,6 +4,7 @@
 #include <rename_me/detail/config.h>
 #include <rename_me/detail/cpp_20.h>
 #include <rename_me/detail/lazy_storage.h>
+#include <rename_me/detail/ebo_storage.h>
 #include <rename_me/detail/noop_task_base.h>
 
 #include <functional>
@@ -53,8 +54,9 @@ namespace nn
 			template<typename F, typename... Args>
 			static Task<R, void> invoke(Scheduler& scheduler, F&& f, Args&&... args)
 			{
-				return Task<R, void>::template make<detail::NoopTask<R, void>>(scheduler
-					, expected_type(std::forward<F>(f)(std::forward<Args>(args)...)));
+				// Same as FunctionTask, moves result if f() returns reference
+				return Task<R, void>::make_ready(scheduler
+					, expected_type(std::move(std::forward<F>(f)(std::forward<Args>(args)...))));
 			}
 		};
 
@@ -88,7 +90,7 @@ namespace nn
 			static Task<X, X> invoke_incomplete(Scheduler& scheduler, F&& f, Args&&... args)
 			{
 				(void)std::forward<F>(f)(std::forward<Args>(args)...);
-				return Task<X, X>::template make<detail::NoopTask<X, X>>(scheduler, expected_type());
+				return Task<X, X>::make_ready(scheduler, expected_type());
 			}
 
 			template<typename F, typename... Args>
@@ -128,8 +130,8 @@ namespace nn
 			template<typename F, typename... Args>
 			static Task<T, E> invoke(Scheduler& scheduler, F&& f, Args&&... args)
 			{
-				return Task<T, E>::template make<detail::NoopTask<T, E>>(scheduler
-					, std::forward<F>(f)(std::forward<Args>(args)...));
+				return Task<T, E>::make_ready(scheduler
+					, std::move(std::forward<F>(f)(std::forward<Args>(args)...)));
 			}
 		};
 
@@ -146,7 +148,8 @@ namespace nn
 			static void set_default_error(Scheduler& scheduler, storage& data)
 			{
 				assert(!data.has_value());
-				data.emplace_once(type::template make<detail::NoopTask<T, E>>(scheduler, detail::CanceledTag()));
+				data.emplace_once(type::make_ready(scheduler
+					, MakeExpectedWithDefaultError<expected_type>()));
 			}
 
 			static Status tick_results(storage& data, bool cancel_requested)
@@ -168,7 +171,7 @@ namespace nn
 			static Task<T, E> invoke(Scheduler& scheduler, F&& f, Args&&... args)
 			{
 				(void)scheduler;
-				return std::forward<F>(f)(std::forward<Args>(args)...);
+				return std::move(std::forward<F>(f)(std::forward<Args>(args)...));
 			}
 		};
 
@@ -197,25 +200,68 @@ namespace nn
 		template<typename F, typename... Args>
 		using FunctionTaskReturnT = typename FunctionTaskReturn<F, Args...>::type;
 
+		// Keeps Invoker of the FunctionTask until reset().
+		// Empty Invoker has nothing to release and is kept thru EBO
+		template<typename Invoker, bool IsEbo = IsEboEnabled<Invoker>::value>
+		class InvokerStorage;
+
+		template<typename Invoker>
+		class NN_EBO_CLASS InvokerStorage<Invoker, true/*IsEbo*/>
+			: private EboStorage<Invoker>
+		{
+			using Base = EboStorage<Invoker>;
+		public:
+			explicit InvokerStorage(Invoker&& invoker)
+				: Base(std::move(invoker))
+			{
+			}
+
+			Invoker& get() { return Base::get(); }
+			void reset()   { }
+		};
+
+		template<typename Invoker>
+		class InvokerStorage<Invoker, false/*IsEbo*/>
+		{
+		public:
+			explicit InvokerStorage(Invoker&& invoker)
+				: invoker_()
+			{
+				invoker_.emplace_once(std::move(invoker));
+			}
+
+			Invoker& get() { return invoker_.get(); }
+			void reset()   { invoker_.reset(); }
+
+		private:
+			LazyStorage<Invoker> invoker_;
+		};
+
 		// `Invoker` is:
 		//  (1) `auto invoke()` that returns result of functor invocation.
 		//  (2) `bool can_invoke()` that returns true if invoke() call is allowed.
 		//    Otherwise task will be marked as canceled.
 		//  (3) `bool wait() const` that returns true if invoke() call is delayed.
+		// 
+		// Invoker (with the functor and, for continuations, reference
+		// to the parent task) is destroyed once it's not needed anymore:
+		// right after invoke() or when the task is canceled.
+		// Finished task keeps only the result
 		template<
 			typename Return // FunctionTaskReturn helper
 			, typename Invoker
 			, typename Storage = typename Return::storage>
 		class NN_EBO_CLASS FunctionTask
-			: private Invoker
+			: private InvokerStorage<Invoker>
 			, private Storage
 		{
 			using IsTask = typename Return::is_task;
 			using IsApplyVoid = typename Return::is_void;
 			using expected_type = typename Return::expected_type;
+			using InvokerBase = InvokerStorage<Invoker>;
 		public:
 			explicit FunctionTask(Invoker&& invoker)
-				: Invoker(std::move(invoker))
+				: InvokerBase(std::move(invoker))
 				, Storage()
 				, invoked_(false)
 			{
@@ -230,6 +276,7 @@ namespace nn
 			{
 				if (context.cancel_requested && !invoked_)
 				{
+					InvokerBase::reset();
 					Return::set_default_error(context.scheduler, *this);
 					return Status::Canceled;
 				}
@@ -244,6 +291,7 @@ namespace nn
 				}
 				if (!invoker().can_invoke())
 				{
+					InvokerBase::reset();
 					Return::set_default_error(context.scheduler, *this);
 					return Status::Canceled;
 				}
@@ -251,6 +299,7 @@ namespace nn
 				assert(!invoked_);
 				call_impl(IsApplyVoid());
 				invoked_ = true;
+				InvokerBase::reset();
 				assert(Storage::has_value());
 				return Return::tick_results(*this, context.cancel_requested);
 			}
@@ -280,12 +329,12 @@ namespace nn
 
 			Invoker& invoker()
 			{
-				return static_cast<Invoker&>(*this);
+				return InvokerBase::get();
 			}
 
 			const Invoker& const_invoker()
 			{
-				return static_cast<const Invoker&>(*this);
+				return InvokerBase::get();
 			}
 
 		private:
@@ -1,9 +1,15 @@
 #pragma once
 #include <rename_me/custom_task.h>
 #include <rename_me/detail/ref_count_ptr.h>
+#include <rename_me/detail/timer_wheel.h>
+#include <rename_me/detail/trace.h>
+#include <rename_me/detail/threading.h>
 
-#include <atomic>
+#include <typeinfo>
+#include <new>
+#include <limits>
 
+#include <cstddef>
 #include <cassert>
 
 namespace nn
@@ -14,48 +20,206 @@ namespace nn
 	namespace detail
 	{
 
+		// Everything, except tick and value of the task, is kept there
+		// and is accessed without virtual call: status() is queried
+		// in every Task<>::is_in_progress() and scheduler() - for
+		// every continuation
 		class TaskBase
 		{
 		public:
-			virtual ~TaskBase() = default;
+			explicit TaskBase(Scheduler& scheduler);
+			virtual ~TaskBase();
 
 			virtual Status update() = 0;
+			// Destroys and frees the task once last reference
+			// is removed (see RefCountPtr)
+			virtual void destroy() noexcept { delete this; }
+
+			Scheduler& scheduler() const { return *scheduler_; }
+			Status status() const        { return last_run_; }
+			// Thread-safe. Next update() sees cancel request.
+			// Task that waits for the timer is ticked immediately
+			void cancel();
+			// Thread-safe. True if cancel() was called, but
+			// the task was not updated since then
+			bool cancel_requested() const { return try_cancel_.load(std::memory_order_acquire); }
+
+			// Task that can't make progress until something else happens
+			// (see StreamState) is parked instead of being polled:
+			// update() invokes request_park() and returns InProgress.
+			// The scheduler takes the task from its queue and counts it
+			// as waiting one (see park()) until unpark() or cancel() posts
+			// it again. request_park() and unpark() should be ordered
+			// by the task (e.g., invoked under the same lock)
+			void request_park();
+			bool is_park_requested() const;
+			// Invoked by the scheduler once update() returns after
+			// request_park(). Returns false if unpark() was invoked
+			// already: the task should be posted
+			bool park();
+			// Thread-safe. Posts the parked task or cancels park request
+			void unpark();
 
 		public:
 			// Pointer interface
 			bool remove_ref_count() noexcept
 			{
-				assert(ref_ != 0);
-				return (ref_.fetch_sub(1) == 0);
+				assert(shared_.ref != 0);
+				return (shared_.ref.fetch_sub(1, std::memory_order_acq_rel) == 1);
 			}
 
 			void add_ref_count() noexcept
 			{
-				assert(ref_ != std::numeric_limits<std::uint16_t>::max());
-				ref_.fetch_add(1);
+				assert(shared_.ref != std::numeric_limits<RefCount>::max());
+				shared_.ref.fetch_add(1, std::memory_order_relaxed);
 			}
 
+		public:
+			// Continuations interface. Continuation is a task that
+			// waits for this task to finish. Instead of polling status()
+			// of this task on every Scheduler::poll(), continuation is
+			// kept there and posted to its scheduler only once.
+			// Every continuation references this task (to get the result),
+			// so the number of continuations is limited by RefCount only.
+			//
+			// Thread-safe. Returns false if this task is finished already.
+			// In this case ownership of `continuation` is not taken
+			// and caller is responsible to run it
+			bool add_continuation(TaskBase* continuation);
+			// Invoked once, after update() returns finish status.
+			// Returns list of continuations in order they were added
+			// (see next()). Ownership is transferred to the caller.
+			// Any subsequent add_continuation() call will fail
+			TaskBase* close_continuations();
+
+			// Intrusive single-linked list support
+			TaskBase* next() const      { return next_; }
+			void set_next(TaskBase* next) { next_ = next; }
+
+			// Should be set before the task is posted
+			Priority priority() const            { return priority_; }
+			void set_priority(Priority priority) { priority_ = priority; }
+
+			// Continuation that only counts finished tasks (see WhenWaiter)
+			// is updated right away by the thread that finishes its parent,
+			// instead of being posted and ticked by its scheduler
+			bool is_inline_continuation() const { return inline_continuation_; }
+
+			// Scheduler's statistics support (see SchedulerStats).
+			// Nanoseconds of steady_clock, 0 if not set
+			struct Timestamps
+			{
+				std::int64_t created = 0;
+				// Reset to 0 once task is ticked first time
+				std::int64_t ready = 0;
+			};
+			Timestamps& timestamps() { return timestamps_; }
+
 		protected:
-			std::atomic<std::uint16_t> ref_ = 1;
-			// Put there for better memory layout
-			std::atomic<Status> last_run_ = Status::InProgress;
-			std::atomic_bool try_cancel_ = false;
-			// char alignment[4]; // For x64
+			// Task<> handles and continuations of this task
+			using RefCount = std::uint32_t;
+
+			// Task waits for the `timer`, that is part of the task object.
+			// Offset of the timer is kept instead of the pointer
+			void set_timer(TimerNode& timer);
+			// update() of such task should be thread-safe and cheap
+			void set_inline_continuation() { inline_continuation_ = true; }
+
+			// Hot state: used by the thread that ticks the task.
+			// Other threads only read status() and, rarely, cancel().
+			// Written only when task finishes or cancel is requested
+			Atomic<Status> last_run_ = Status::InProgress;
+			Atomic<bool> try_cancel_ = false;
+		private:
+			enum class ParkState : std::uint8_t
+			{
+				None,
+				Requested,
+				Parked,
+			};
+			// Written by the ticking thread and by unpark()
+			Atomic<ParkState> park_ = ParkState::None;
+			Priority priority_ = Priority::Normal;
+			bool inline_continuation_ = false;
+			// char alignment[1]; // For x64
+			// Offset of the TimerNode from `this` or 0 if there is no timer
+			std::uint16_t timer_offset_ = 0;
+			Scheduler* const scheduler_;
+			TaskBase* next_ = nullptr;
+			Timestamps timestamps_;
+
+			// Modified by any thread that keeps Task<> handles or adds
+			// continuations. Takes whole cache line (see NN_CACHE_LINE_SIZE):
+			// data of the derived task starts on the next one
+			struct alignas(k_shared_alignment) SharedState
+			{
+				Atomic<RefCount> ref = 1;
+				// Head of LIFO list of continuations.
+				// Points to the task when list is closed
+				Atomic<TaskBase*> continuations = nullptr;
+			};
+			SharedState shared_;
 		};
 
-		static_assert(sizeof(TaskBase) <= 2 * sizeof(void*)
-			, "Expecting TaskBase to be virtual pointer + reference count with "
-			"alignment no more then 2 pointers");
+#if (NN_CACHE_LINE_SIZE > 0)
+		static_assert(sizeof(TaskBase) == (2 * NN_CACHE_LINE_SIZE)
+			, "Expecting TaskBase to be virtual pointer + status + scheduler + "
+			"intrusive link + timestamps on the first cache line and "
+			"reference count + continuations list on the second one");
+#else
+		static_assert(sizeof(TaskBase) <= (6 * sizeof(void*) + sizeof(TaskBase::Timestamps))
+			, "Expecting TaskBase to be virtual pointer + reference count + "
+			"scheduler + continuations list with alignment no more then 6 pointers "
+			"and timestamps");
+#endif
 
 		using ErasedTask = RefCountPtr<TaskBase>;
 
+		// Reverses intrusive list linked thru TaskBase::next()
+		inline TaskBase* ReverseTaskList(TaskBase* head);
+
+		// Thread-safe. Asks `scheduler` to stop waiting for the `timer`
+		// and tick the task. Does nothing if task did not wait
+		// for the timer or the timer expired already
+		void CancelTimer(Scheduler& scheduler, TimerNode& timer);
+
+		// Tasks that wait for something else then single task
+		// (see WhenLatch) are posted directly. Same as Task<>'s posting:
+		// PostTaskAfter() posts `task` once `parent` finishes
+		void PostTask(Scheduler& scheduler, ErasedTask task);
+		void PostTaskAfter(Scheduler& scheduler, TaskBase& parent, ErasedTask task);
+		// Task that is not posted until something else completes it
+		// (see Channel) is counted by tasks_count() with
+		// CountWaitingTask(). PostWaitingTask() posts it and uncounts,
+		// ReleaseWaitingTask() - drops it and uncounts
+		void CountWaitingTask(Scheduler& scheduler);
+		void PostWaitingTask(Scheduler& scheduler, ErasedTask task);
+		void ReleaseWaitingTask(Scheduler& scheduler, ErasedTask task);
+
+		// Continuation of the ready task (see Task::make_ready()) can be
+		// invoked right away, on the calling thread, only from the tick
+		// of other task of the same `scheduler` and only if there are not
+		// too many such continuations on the stack already. Returns false
+		// if continuation should be posted. Otherwise
+		// LeaveInlineContinuation() should be invoked after
+		bool EnterInlineContinuation(const Scheduler& scheduler);
+		void LeaveInlineContinuation();
+
+		// Memory for the task from Scheduler's TaskAllocator
+		void* AllocateTask(Scheduler& scheduler
+			, std::size_t size, std::size_t alignment);
+		void DeallocateTask(Scheduler& scheduler, void* ptr
+			, std::size_t size, std::size_t alignment) noexcept;
+
 		template<typename T, typename E>
 		class InternalTask : public TaskBase
 		{
 		public:
-			virtual Scheduler& scheduler() = 0;
-			virtual void cancel() = 0;
-			virtual Status status() const = 0;
+			explicit InternalTask(Scheduler& scheduler)
+				: TaskBase(scheduler)
+			{
+			}
+
 			virtual expected<T, E>& get_data() = 0;
 		};
 
@@ -67,25 +231,31 @@ namespace nn
 			static_assert(IsCustomTask<CustomTask, T, E>::value
 				, "CustomTask should satisfy CustomTask<T, E> interface");
 		public:
+			// Allocates the task from `scheduler`'s TaskAllocator
 			template<typename... Args>
-			explicit InternalCustomTask(Scheduler& scheduler, Args&&... args);
+			static RefCountPtr<InternalCustomTask> Make(Scheduler& scheduler, Args&&... args);
 
 			CustomTask& task();
 
-			virtual Scheduler& scheduler() override;
+			virtual void destroy() noexcept override;
 			virtual Status update() override;
-			virtual void cancel() override;
-			virtual Status status() const override;
 			virtual expected<T, E>& get_data() override;
 
 			void set_custom_status(std::true_type);
 			void set_custom_status(std::false_type);
 
+			void set_custom_timer(std::true_type);
+			void set_custom_timer(std::false_type);
+
 #if !defined(NDEBUG)
 			void validate_data_state(Status status);
 #endif
 		private:
-			Scheduler& scheduler_;
+			// destroy() frees into `scheduler`'s TaskAllocator:
+			// only Make() can create the task
+			template<typename... Args>
+			explicit InternalCustomTask(Scheduler& scheduler, Args&&... args);
+
 			CustomTask task_;
 		};
 
@@ -98,14 +268,163 @@ namespace nn
 	namespace detail
 	{
 
+		inline /*explicit*/ TaskBase::TaskBase(Scheduler& scheduler)
+			: scheduler_(&scheduler)
+		{
+		}
+
+		inline TaskBase::~TaskBase()
+		{
+			// Task was never finished. Release continuations
+			// that wait for it: they are not counted by their
+			// schedulers anymore (see Scheduler::post_after())
+			TaskBase* continuation = shared_.continuations.load();
+			if (continuation == this)
+			{
+				return;
+			}
+			while (continuation)
+			{
+				TaskBase* next = continuation->next_;
+				continuation->next_ = nullptr;
+				ReleaseWaitingTask(continuation->scheduler(), ErasedTask::attach(continuation));
+				continuation = next;
+			}
+		}
+
+		inline bool TaskBase::add_continuation(TaskBase* continuation)
+		{
+			assert(continuation && (continuation != this));
+			assert(!continuation->next_);
+			if (last_run_ != Status::InProgress)
+			{
+				// Fast path: there is no need to wait
+				return false;
+			}
+			TaskBase* head = shared_.continuations.load(std::memory_order_acquire);
+			do
+			{
+				if (head == this)
+				{
+					// Closed by close_continuations()
+					continuation->next_ = nullptr;
+					return false;
+				}
+				continuation->next_ = head;
+			}
+			while (!shared_.continuations.compare_exchange_weak(head, continuation
+				, std::memory_order_acq_rel, std::memory_order_acquire));
+			return true;
+		}
+
+		inline TaskBase* TaskBase::close_continuations()
+		{
+			assert(last_run_ != Status::InProgress);
+			TaskBase* head = shared_.continuations.exchange(this, std::memory_order_acq_rel);
+			assert((head != this) && "Continuations can be closed only once");
+			// Reverse to preserve order of add_continuation() calls
+			return ReverseTaskList(head);
+		}
+
+		inline void TaskBase::cancel()
+		{
+			try_cancel_.store(true, std::memory_order_release);
+			NN_TRACE(TraceCancel(this));
+			if (timer_offset_ != 0)
+			{
+				char* self = reinterpret_cast<char*>(this);
+				CancelTimer(*scheduler_, *reinterpret_cast<TimerNode*>(self + timer_offset_));
+			}
+			unpark();
+		}
+
+		inline void TaskBase::request_park()
+		{
+			park_.store(ParkState::Requested, std::memory_order_relaxed);
+		}
+
+		inline bool TaskBase::is_park_requested() const
+		{
+			return (park_.load(std::memory_order_relaxed) == ParkState::Requested);
+		}
+
+		inline bool TaskBase::park()
+		{
+			ParkState requested = ParkState::Requested;
+			return park_.compare_exchange_strong(requested, ParkState::Parked
+				, std::memory_order_acq_rel, std::memory_order_acquire);
+		}
+
+		inline void TaskBase::unpark()
+		{
+			ParkState state = park_.load(std::memory_order_acquire);
+			while (state != ParkState::None)
+			{
+				if (park_.compare_exchange_weak(state, ParkState::None
+					, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					if (state == ParkState::Parked)
+					{
+						// Reference is owned by the parked task itself
+						PostWaitingTask(*scheduler_, ErasedTask::attach(this));
+					}
+					return;
+				}
+			}
+		}
+
+		inline void TaskBase::set_timer(TimerNode& timer)
+		{
+			const std::ptrdiff_t offset = (reinterpret_cast<char*>(&timer)
+				- reinterpret_cast<char*>(this));
+			assert((offset > 0) && (offset <= std::numeric_limits<std::uint16_t>::max())
+				&& "Timer should be part of the task object");
+			timer_offset_ = static_cast<std::uint16_t>(offset);
+		}
+
+		inline TaskBase* ReverseTaskList(TaskBase* head)
+		{
+			TaskBase* reversed = nullptr;
+			while (head)
+			{
+				TaskBase* next = head->next();
+				head->set_next(reversed);
+				reversed = head;
+				head = next;
+			}
+			return reversed;
+		}
+
+		template<typename T, typename E, typename CustomTask>
+		template<typename... Args>
+		/*static*/ RefCountPtr<InternalCustomTask<T, E, CustomTask>>
+			InternalCustomTask<T, E, CustomTask>::Make(Scheduler& scheduler, Args&&... args)
+		{
+			void* memory = AllocateTask(scheduler
+				, sizeof(InternalCustomTask), alignof(InternalCustomTask));
+			try
+			{
+				return RefCountPtr<InternalCustomTask>::attach(
+					new(memory) InternalCustomTask(scheduler, std::forward<Args>(args)...));
+			}
+			catch (...)
+			{
+				DeallocateTask(scheduler, memory
+					, sizeof(InternalCustomTask), alignof(InternalCustomTask));
+				throw;
+			}
+		}
+
 		template<typename T, typename E, typename CustomTask>
 		template<typename... Args>
 		/*explicit*/ InternalCustomTask<T, E, CustomTask>::InternalCustomTask(
 			Scheduler& scheduler, Args&&... args)
-			: scheduler_(scheduler)
+			: Base(scheduler)
 			, task_(std::forward<Args>(args)...)
 		{
 			set_custom_status(HasInitialStatus<CustomTask>());
+			set_custom_timer(HasTimer<CustomTask>());
+			NN_TRACE(TraceCreate(this, typeid(CustomTask).name(), Base::last_run_));
 		}
 
 		template<typename T, typename E, typename CustomTask>
@@ -115,9 +434,12 @@ namespace nn
 		}
 
 		template<typename T, typename E, typename CustomTask>
-		Scheduler& InternalCustomTask<T, E, CustomTask>::scheduler()
+		void InternalCustomTask<T, E, CustomTask>::destroy() noexcept
 		{
-			return scheduler_;
+			Scheduler& scheduler = Base::scheduler();
+			this->~InternalCustomTask();
+			DeallocateTask(scheduler, this
+				, sizeof(InternalCustomTask), alignof(InternalCustomTask));
 		}
 
 		template<typename T, typename E, typename CustomTask>
@@ -125,25 +447,34 @@ namespace nn
 		{
 			assert(Base::last_run_ == Status::InProgress);
 			const bool cancel_requested = Base::try_cancel_;
-			const Status status = task().tick(ExecutionContext{scheduler_, cancel_requested});
+			NN_TRACE(const std::int64_t trace_start = TraceStart());
+			const Status status = task().tick(ExecutionContext{Base::scheduler(), cancel_requested});
 #if !defined(NDEBUG)
 			validate_data_state(status);
 #endif
-			Base::try_cancel_ = false;
-			Base::last_run_ = status;
+			// Nothing is written while task is in progress: other
+			// threads that read status() keep the cache line
+			if (cancel_requested)
+			{
+				Base::try_cancel_ = false;
+			}
+			if (status != Status::InProgress)
+			{
+				Base::last_run_ = status;
+			}
+			NN_TRACE(TraceTick(this, trace_start, status));
 			return status;
 		}
 
 		template<typename T, typename E, typename CustomTask>
-		Status InternalCustomTask<T, E, CustomTask>::status() const
+		void InternalCustomTask<T, E, CustomTask>::set_custom_timer(std::true_type)
 		{
-			return Base::last_run_;
+			Base::set_timer(task().timer());
 		}
 
 		template<typename T, typename E, typename CustomTask>
-		void InternalCustomTask<T, E, CustomTask>::cancel()
+		void InternalCustomTask<T, E, CustomTask>::set_custom_timer(std::false_type)
 		{
-			Base::try_cancel_.store(true);
 		}
 
 		template<typename T, typename E, typename CustomTask>
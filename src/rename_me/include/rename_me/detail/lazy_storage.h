@@ -59,6 +59,11 @@ namespace nn
 				// Always has value since default constructed
 				return true;
 			}
+
+			void reset()
+			{
+				// Empty T, nothing to release
+			}
 		};
 
 		template<typename T>
@@ -101,7 +106,21 @@ namespace nn
 				return set_;
 			}
 
+			void reset()
+			{
+				if (set_)
+				{
+					set_ = false;
+					get_unchecked().~T();
+				}
+			}
+
 		private:
+			T& get_unchecked()
+			{
+				return *static_cast<T*>(ptr());
+			}
+
 			void* ptr()
 			{
 				return std::addressof(data_);
@@ -121,6 +140,7 @@ namespace nn
 			void emplace_once() { }
 			void get() { }
 			bool has_value() const { return true; }
+			void reset() { }
 		};
 
 		// Some unique Tag can be specified in case LazyStorage<>
@@ -136,6 +156,9 @@ namespace nn
 			using Storage::emplace_once;
 			using Storage::get;
 			using Storage::has_value;
+			// Destroys the value, if any. Value of empty T
+			// (see is_ebo) is never destroyed
+			using Storage::reset;
 
 			LazyStorage(LazyStorage&&) = delete;
 			LazyStorage& operator=(LazyStorage&&) = delete;
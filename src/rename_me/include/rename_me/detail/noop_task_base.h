@@ -22,11 +22,22 @@ namespace nn
 			template<typename Expected>
 			explicit NoopTask(Expected&& v)
 				: Storage(std::forward<Expected>(v))
+				, status_(Storage::get().has_value()
+					? Status::Successful : Status::Failed)
+			{
+			}
+
+			// Keeps status of ready Task (see Task::make_ready())
+			template<typename Expected>
+			explicit NoopTask(Status status, Expected&& v)
+				: Storage(std::forward<Expected>(v))
+				, status_(status)
 			{
 			}
 
 			explicit NoopTask(CanceledTag)
 				: Storage(MakeExpectedWithDefaultError<expected<T, E>>())
+				, status_(Status::Failed)
 			{
 			}
 
@@ -35,8 +46,7 @@ namespace nn
 
 			Status initial_status() const
 			{
-				return Storage::get().has_value()
-					? Status::Successful : Status::Failed;
+				return status_;
 			}
 
 			Status tick(const ExecutionContext& context)
@@ -51,6 +61,9 @@ namespace nn
 			{
 				return Storage::get();
 			}
+
+		private:
+			Status status_;
 		};
 
 	} // namespace detail
@@ -0,0 +1,543 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/detail/when_task_base.h>
+#include <rename_me/detail/threading.h>
+
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <type_traits>
+
+#include <cstddef>
+#include <cassert>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Value and error of the function that is invoked for every
+		// element by parallel_for()/parallel_transform()
+		template<typename R>
+		struct ParallelResult
+		{
+			using value_type = R;
+			using error_type = void;
+		};
+
+		template<typename T, typename E>
+		struct ParallelResult<expected<T, E>>
+		{
+			using value_type = T;
+			using error_type = E;
+		};
+
+		template<typename RandomIt, typename F>
+		using ParallelResultOf = ParallelResult<std::invoke_result_t<std::decay_t<F>&
+			, typename std::iterator_traits<RandomIt>::reference>>;
+
+		struct ParallelNone
+		{
+		};
+
+		// Default `map_op` of parallel_reduce()
+		struct ParallelIdentity
+		{
+			template<typename T>
+			T&& operator()(T&& value) const
+			{
+				return std::forward<T>(value);
+			}
+		};
+
+		template<typename E>
+		using ParallelError = std::conditional_t<std::is_void_v<E>
+			, ParallelNone, std::optional<E>>;
+
+		// How the range is split between the workers
+		struct ParallelSplit
+		{
+			std::size_t size;
+			std::size_t grain;
+			std::size_t workers_count;
+			// Scheduler is polled by single thread (see ParallelLoop::run())
+			bool wake_up;
+		};
+
+		// Every chunk is processed by single worker, there are
+		// about that many chunks per worker when grain is not given
+		constexpr std::size_t k_parallel_chunks_per_worker = 8;
+
+		// One worker per thread that ticks tasks of the `scheduler`,
+		// but not more than chunks
+		ParallelSplit SplitParallelRange(const Scheduler& scheduler
+			, std::size_t size, std::size_t grain);
+
+		// Range shared by the workers of parallel_for()-like tasks.
+		// Workers claim chunks of `grain` elements one by one: worker
+		// that is faster (or started earlier) processes more chunks.
+		// Claiming stops on the first error or once the task that
+		// waits for the workers is canceled.
+		// `Body` runs the chunk (see ParallelForBody) and makes the
+		// value of the task once all workers finished
+		template<typename RandomIt, typename Body>
+		class ParallelLoop
+		{
+		public:
+			using Output = typename Body::Output;
+			using Error = typename Body::Error;
+
+			// Single tick of the worker runs chunks for about that long:
+			// long enough to make ticks of the small chunks cheap
+			// and short enough to not starve other tasks
+			static constexpr std::chrono::microseconds k_tick_slice{100};
+
+			explicit ParallelLoop(RandomIt first, const ParallelSplit& split, Body&& body)
+				: first_(first)
+				, size_(split.size)
+				, grain_(split.grain)
+				, wake_up_(split.wake_up)
+				, body_(std::move(body))
+				, latch_(nullptr)
+				, failed_(false)
+				, error_()
+				, next_(0)
+			{
+				assert(grain_ > 0);
+			}
+
+			ParallelLoop(const ParallelLoop&) = delete;
+			ParallelLoop& operator=(const ParallelLoop&) = delete;
+
+			// Latch of the task that waits for the workers.
+			// Its cancel stops the workers
+			void set_latch(const WhenLatch& latch)
+			{
+				latch_.store(&latch, std::memory_order_release);
+			}
+
+			// Runs chunks for about k_tick_slice. Returns Successful
+			// once there is nothing to claim, Failed if the loop is stopped
+			Status run(Scheduler& scheduler, std::size_t worker)
+			{
+				using Clock = std::chrono::steady_clock;
+				const Clock::time_point start = Clock::now();
+				do
+				{
+					if (is_stopped())
+					{
+						return Status::Failed;
+					}
+					const std::size_t begin = next_.fetch_add(grain_, std::memory_order_relaxed);
+					if (begin >= size_)
+					{
+						return Status::Successful;
+					}
+					const std::size_t end = begin + (std::min)(grain_, size_ - begin);
+					if (!body_.run(*this, first_, begin, end, worker))
+					{
+						return Status::Failed;
+					}
+				}
+				while ((Clock::now() - start) < k_tick_slice);
+				if (wake_up_)
+				{
+					// Scheduler that is polled by single thread backs
+					// off polling of the tasks that do not finish
+					// (see Scheduler::run_until())
+					scheduler.wake_up();
+				}
+				return Status::InProgress;
+			}
+
+			// Invoked once all workers finished
+			Status finish(expected<Output, Error>& data)
+			{
+				if (!failed_.load(std::memory_order_acquire))
+				{
+					body_.finish(data);
+					return Status::Successful;
+				}
+				if constexpr (std::is_void_v<Error>)
+				{
+					data = MakeExpectedWithDefaultError<expected<Output, Error>>();
+				}
+				else
+				{
+					assert(error_);
+					data = MakeExpectedWithError<expected<Output, Error>>(std::move(*error_));
+				}
+				return Status::Failed;
+			}
+
+			// Invoked by the `Body` with failed expected<>
+			template<typename Result>
+			void fail(Result& result)
+			{
+				if (failed_.exchange(true, std::memory_order_acq_rel))
+				{
+					// Error of other worker is kept
+					return;
+				}
+				if constexpr (!std::is_void_v<Error>)
+				{
+					error_.emplace(std::move(result).error());
+				}
+			}
+
+		private:
+			bool is_stopped() const
+			{
+				if (failed_.load(std::memory_order_relaxed))
+				{
+					return true;
+				}
+				const WhenLatch* latch = latch_.load(std::memory_order_acquire);
+				return (latch && latch->cancel_requested());
+			}
+
+		private:
+			const RandomIt first_;
+			const std::size_t size_;
+			const std::size_t grain_;
+			const bool wake_up_;
+			Body body_;
+			Atomic<const WhenLatch*> latch_;
+			Atomic<bool> failed_;
+			// Written by the worker that failed first
+			ParallelError<Error> error_;
+			// Claimed by every worker for every chunk
+			alignas(k_worker_alignment) Atomic<std::size_t> next_;
+		};
+
+		template<typename RandomIt>
+		decltype(auto) ParallelElement(RandomIt first, std::size_t index)
+		{
+			using Difference = typename std::iterator_traits<RandomIt>::difference_type;
+			return first[static_cast<Difference>(index)];
+		}
+
+		// Results of parallel_transform(), one per element, allocated
+		// from the Scheduler's memory_resource(). `Buffer` is written
+		// by the workers, `Output` is the value of the task
+		template<typename U>
+		struct ParallelValues
+		{
+			using Output = std::pmr::vector<U>;
+			using Buffer = std::pmr::vector<U>;
+
+			static Output take(Buffer& buffer)
+			{
+				return std::move(buffer);
+			}
+		};
+
+		// Value of parallel_for()
+		template<>
+		struct ParallelValues<ParallelNone>
+		{
+			using Output = void;
+			using Buffer = ParallelNone;
+		};
+
+		// Not packed bool: workers write neighbour elements concurrently
+		struct ParallelBool
+		{
+			ParallelBool(bool v = false)
+				: value(v)
+			{
+			}
+
+			bool value;
+		};
+
+		// std::vector<bool> packs the values into the words that are
+		// shared by different workers. Bools are kept unpacked and
+		// converted once all workers finished
+		template<>
+		struct ParallelValues<bool>
+		{
+			using Output = std::pmr::vector<bool>;
+			using Buffer = std::pmr::vector<ParallelBool>;
+
+			static Output take(Buffer& buffer)
+			{
+				Output values(buffer.size(), false, buffer.get_allocator().resource());
+				for (std::size_t i = 0, count = buffer.size(); i < count; ++i)
+				{
+					values[i] = buffer[i].value;
+				}
+				return values;
+			}
+		};
+
+		// Body of parallel_for()/parallel_transform(): invokes `f`
+		// for every element. `U` is the value of `f` or ParallelNone
+		// if results are not kept (see ParallelValues)
+		template<typename RandomIt, typename F, typename U>
+		class ParallelForBody
+		{
+		public:
+			using Result = std::invoke_result_t<F&
+				, typename std::iterator_traits<RandomIt>::reference>;
+			using Error = typename ParallelResult<Result>::error_type;
+			using Values = typename ParallelValues<U>::Buffer;
+			using Output = typename ParallelValues<U>::Output;
+
+			explicit ParallelForBody(F&& f, Values&& values)
+				: f_(std::move(f))
+				, values_(std::move(values))
+			{
+			}
+
+			template<typename Loop>
+			bool run(Loop& loop, RandomIt first, std::size_t begin, std::size_t end
+				, std::size_t /*worker*/)
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					if constexpr (std::is_void_v<Result>)
+					{
+						f_(ParallelElement(first, i));
+					}
+					else if constexpr (is_expected<Result>())
+					{
+						Result result = f_(ParallelElement(first, i));
+						if (!result.has_value())
+						{
+							loop.fail(result);
+							return false;
+						}
+						if constexpr (!std::is_void_v<Output>)
+						{
+							values_[i] = std::move(*result);
+						}
+					}
+					else
+					{
+						values_[i] = f_(ParallelElement(first, i));
+					}
+				}
+				return true;
+			}
+
+			void finish(expected<Output, Error>& data)
+			{
+				if constexpr (std::is_void_v<Output>)
+				{
+					data = expected<Output, Error>();
+				}
+				else
+				{
+					data.emplace(ParallelValues<U>::take(values_));
+				}
+			}
+
+		private:
+			F f_;
+			Values values_;
+		};
+
+		// Accumulator of single worker (see ParallelReduceBody).
+		// Takes whole cache line: workers write their own only
+		template<typename R>
+		struct alignas(k_worker_alignment) ParallelPartial
+		{
+			R value;
+		};
+
+		// Body of parallel_reduce(): every worker reduces its chunks
+		// into own partial result, partial results are combined
+		// pairwise (as a tree) once all workers finished
+		template<typename RandomIt, typename R, typename Reduce, typename Map>
+		class ParallelReduceBody
+		{
+		public:
+			using Result = std::invoke_result_t<Map&
+				, typename std::iterator_traits<RandomIt>::reference>;
+			using Error = typename ParallelResult<Result>::error_type;
+			using Output = R;
+
+			explicit ParallelReduceBody(R&& identity, Reduce&& reduce, Map&& map
+				, std::size_t workers_count, std::pmr::memory_resource& resource)
+				: identity_(std::move(identity))
+				, reduce_(std::move(reduce))
+				, map_(std::move(map))
+				, partials_(workers_count, ParallelPartial<R>{identity_}, &resource)
+			{
+			}
+
+			template<typename Loop>
+			bool run(Loop& loop, RandomIt first, std::size_t begin, std::size_t end
+				, std::size_t worker)
+			{
+				assert(worker < partials_.size());
+				// Accumulated in the local, written back once per chunk
+				R value = std::move(partials_[worker].value);
+				bool ok = true;
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					if constexpr (is_expected<Result>())
+					{
+						Result result = map_(ParallelElement(first, i));
+						if (!result.has_value())
+						{
+							loop.fail(result);
+							ok = false;
+							break;
+						}
+						value = reduce_(std::move(value), std::move(*result));
+					}
+					else
+					{
+						value = reduce_(std::move(value), map_(ParallelElement(first, i)));
+					}
+				}
+				partials_[worker].value = std::move(value);
+				return ok;
+			}
+
+			void finish(expected<Output, Error>& data)
+			{
+				const std::size_t count = partials_.size();
+				if (count == 0)
+				{
+					data.emplace(std::move(identity_));
+					return;
+				}
+				for (std::size_t step = 1; step < count; step *= 2)
+				{
+					for (std::size_t i = 0; (i + step) < count; i += (2 * step))
+					{
+						partials_[i].value = reduce_(std::move(partials_[i].value)
+							, std::move(partials_[i + step].value));
+					}
+				}
+				data.emplace(std::move(partials_[0].value));
+			}
+
+		private:
+			R identity_;
+			Reduce reduce_;
+			Map map_;
+			std::pmr::vector<ParallelPartial<R>> partials_;
+		};
+
+		template<typename Loop>
+		class ParallelWorker
+		{
+		public:
+			explicit ParallelWorker(std::shared_ptr<Loop> loop, std::size_t index)
+				: loop_(std::move(loop))
+				, index_(index)
+				, data_()
+			{
+			}
+
+			Status tick(const ExecutionContext& context)
+			{
+				Status status = Status::Canceled;
+				if (!context.cancel_requested)
+				{
+					status = loop_->run(context.scheduler, index_);
+				}
+				if ((status == Status::Failed) || (status == Status::Canceled))
+				{
+					data_ = MakeExpectedWithDefaultError<expected<void, void>>();
+				}
+				return status;
+			}
+
+			expected<void, void>& get()
+			{
+				return data_;
+			}
+
+		private:
+			std::shared_ptr<Loop> loop_;
+			const std::size_t index_;
+			expected<void, void> data_;
+		};
+
+		// Ticked once, when all workers finished
+		template<typename Loop>
+		class ParallelTask
+		{
+		public:
+			using Output = typename Loop::Output;
+			using Error = typename Loop::Error;
+			using Workers = std::pmr::vector<Task<void, void>>;
+
+			explicit ParallelTask(Scheduler& scheduler, Workers&& workers
+				, std::shared_ptr<Loop> loop)
+				: workers_(std::move(workers))
+				, latch_(scheduler, workers_.size(), false/*any*/)
+				, loop_(std::move(loop))
+				, data_()
+			{
+				loop_->set_latch(latch_);
+			}
+
+			ParallelTask(const ParallelTask&) = delete;
+			ParallelTask(ParallelTask&&) = delete;
+
+			Status tick(const ExecutionContext& context)
+			{
+				if (context.cancel_requested)
+				{
+					data_ = MakeExpectedWithDefaultError<expected<Output, Error>>();
+					return Status::Canceled;
+				}
+				return loop_->finish(data_);
+			}
+
+			expected<Output, Error>& get()
+			{
+				return data_;
+			}
+
+			Workers& children()
+			{
+				return workers_;
+			}
+
+			WhenLatch& latch()
+			{
+				return latch_;
+			}
+
+		private:
+			Workers workers_;
+			WhenLatch latch_;
+			std::shared_ptr<Loop> loop_;
+			expected<Output, Error> data_;
+		};
+
+		template<typename RandomIt, typename Body>
+		auto MakeParallelTask(Scheduler& scheduler, RandomIt first
+			, const ParallelSplit& split, Body&& body)
+		{
+			using Loop = ParallelLoop<RandomIt, Body>;
+			using Full = ParallelTask<Loop>;
+
+			auto loop = std::allocate_shared<Loop>(
+				std::pmr::polymorphic_allocator<Loop>(&scheduler.memory_resource())
+				, first, split, std::move(body));
+			typename Full::Workers workers(&scheduler.memory_resource());
+			workers.reserve(split.workers_count);
+			for (std::size_t i = 0; i < split.workers_count; ++i)
+			{
+				workers.push_back(Task<void, void>::template make<ParallelWorker<Loop>>(
+					scheduler, loop, i));
+			}
+			return WhenLatch::Make<typename Full::Output, typename Full::Error, Full>(
+				scheduler, std::move(workers), std::move(loop));
+		}
+
+	} // namespace detail
+} // namespace nn
@@ -1,5 +1,6 @@
 #pragma once
 #include <utility>
+#include <type_traits>
 
 #include <cstddef>
 #include <cassert>
@@ -22,9 +23,25 @@ namespace nn
 {
 	namespace detail
 	{
+		template<typename T, typename = void>
+		struct HasDestroy
+			: std::false_type
+		{
+		};
+
+		template<typename T>
+		struct HasDestroy<T
+			, std::void_t<decltype(std::declval<T&>().destroy())>>
+			: std::true_type
+		{
+		};
+
 		// `T` must satisfy type with:
 		// (1) bool remove_ref_count() noexcept
 		// (2) void add_ref_count() noexcept
+		// (3) optional void destroy() noexcept that destroys and frees
+		//     the object when last reference is removed. `delete` is used
+		//     if there is no destroy()
 		template<typename T>
 		class RefCountPtr
 		{
@@ -39,6 +56,22 @@ namespace nn
 				return RefCountPtr(new T(std::forward<Args>(args)...));
 			}
 
+			// Takes ownership of the raw pointer that was detach()-ed before.
+			// Reference count is not changed
+			static RefCountPtr attach(T* ptr)
+			{
+				return RefCountPtr(ptr);
+			}
+
+			// Gives up ownership without reference count change.
+			// Caller is responsible to attach() returned pointer back
+			T* detach() NN_NOEXCEPT(true)
+			{
+				T* ptr = ptr_;
+				ptr_ = nullptr;
+				return ptr;
+			}
+
 			explicit RefCountPtr() NN_NOEXCEPT(true)
 				: ptr_(nullptr)
 			{
@@ -138,12 +171,22 @@ namespace nn
 				assert(ptr_);
 			}
 
-			void destroy() NN_NOEXCEPT(NN_NOEXCEPT(delete ptr_))
+			void destroy() NN_NOEXCEPT(true)
 			{
-				delete ptr_;
+				destroy(HasDestroy<T>());
 				ptr_ = nullptr;
 			}
 
+			void destroy(std::true_type /*has destroy*/) NN_NOEXCEPT(true)
+			{
+				ptr_->destroy();
+			}
+
+			void destroy(std::false_type /*has destroy*/) NN_NOEXCEPT(true)
+			{
+				delete ptr_;
+			}
+
 			void acquire() NN_NOEXCEPT(true)
 			{
 				if (ptr_)
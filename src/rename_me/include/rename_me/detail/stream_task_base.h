@@ -0,0 +1,106 @@
+#pragma once
+#include <rename_me/custom_task.h>
+#include <rename_me/expected.h>
+#include <rename_me/detail/internal_task.h>
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+#include <cstddef>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Consumer of the StreamTask that waits for the items
+		// (next() or next_many()). Node of the intrusive FIFO
+		// of the stream's receivers
+		template<typename T>
+		class StreamReceiver
+		{
+		public:
+			// Moves items from the front of [first, last).
+			// Returns how many were taken
+			virtual std::size_t take(T* first, T* last) = 0;
+
+			StreamReceiver* next() const            { return next_; }
+			void set_next(StreamReceiver* next)     { next_ = next; }
+			// Owned reference to the task of this operation
+			TaskBase* task() const                  { return task_; }
+			void set_task(TaskBase* task)           { task_ = task; }
+
+		protected:
+			~StreamReceiver() = default;
+
+		private:
+			StreamReceiver* next_ = nullptr;
+			TaskBase* task_ = nullptr;
+		};
+
+		// Not posted until the source gives the items (or the stream
+		// ends), ticked once then. `Value` is T for next()
+		// or std::vector<T> for next_many()
+		template<typename T, typename E, typename Value>
+		class StreamReceiveTask final : public StreamReceiver<T>
+		{
+		public:
+			explicit StreamReceiveTask(std::size_t count)
+				: count_(count)
+				, data_(MakeExpectedWithDefaultError<expected<Value, E>>())
+			{
+			}
+
+			virtual std::size_t take(T* first, T* last) override
+			{
+				if constexpr (std::is_same_v<Value, T>)
+				{
+					data_ = expected<Value, E>(std::move(*first));
+					return 1;
+				}
+				else
+				{
+					const std::size_t count = (std::min)(count_
+						, static_cast<std::size_t>(last - first));
+					Value values;
+					values.reserve(count);
+					std::move(first, first + count, std::back_inserter(values));
+					data_ = expected<Value, E>(std::move(values));
+					return count;
+				}
+			}
+
+			// Items were given before the task is posted,
+			// try_cancel() has no effect
+			Status tick(const ExecutionContext&)
+			{
+				return (data_.has_value() ? Status::Successful : Status::Failed);
+			}
+
+			expected<Value, E>& get()
+			{
+				return data_;
+			}
+
+		private:
+			std::size_t count_;
+			expected<Value, E> data_;
+		};
+
+		// Consumer of the StreamTask that takes all items
+		// (for_each()). Invoked on the source's tick
+		template<typename T>
+		class StreamSink
+		{
+		public:
+			virtual void consume(T* first, T* last) = 0;
+
+		protected:
+			~StreamSink() = default;
+		};
+
+	} // namespace detail
+} // namespace nn
@@ -0,0 +1,123 @@
+#pragma once
+#include <rename_me/detail/internal_task.h>
+
+#include <utility>
+
+#include <cassert>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Intrusive single-linked FIFO list of tasks, linked
+		// thru TaskBase::next(). Not thread-safe.
+		// List owns reference to every task in it.
+		class TaskList
+		{
+		public:
+			explicit TaskList();
+			~TaskList();
+			TaskList(TaskList&& rhs) = delete;
+			TaskList& operator=(TaskList&& rhs) = delete;
+			TaskList(const TaskList& rhs) = delete;
+			TaskList& operator=(const TaskList& rhs) = delete;
+
+			void push_back(ErasedTask task);
+			// Takes ownership of tasks `list` (see TaskQueue::pop_all())
+			// and puts them before all tasks of this list
+			void push_front(TaskBase* list);
+			// Removes task that follows `prev`. Removes front task
+			// if `prev` is null
+			ErasedTask remove_after(TaskBase* prev);
+
+			TaskBase* front() const;
+			bool empty() const;
+
+		private:
+			TaskBase* head_;
+			TaskBase* tail_;
+		};
+
+		/*explicit*/ inline TaskList::TaskList()
+			: head_(nullptr)
+			, tail_(nullptr)
+		{
+		}
+
+		inline TaskList::~TaskList()
+		{
+			while (!empty())
+			{
+				(void)remove_after(nullptr);
+			}
+		}
+
+		inline void TaskList::push_back(ErasedTask task)
+		{
+			assert(task);
+			TaskBase* node = task.detach();
+			assert(!node->next());
+			if (tail_)
+			{
+				tail_->set_next(node);
+			}
+			else
+			{
+				head_ = node;
+			}
+			tail_ = node;
+		}
+
+		inline void TaskList::push_front(TaskBase* list)
+		{
+			if (!list)
+			{
+				return;
+			}
+			TaskBase* last = list;
+			while (last->next())
+			{
+				last = last->next();
+			}
+			last->set_next(head_);
+			head_ = list;
+			if (!tail_)
+			{
+				tail_ = last;
+			}
+		}
+
+		inline ErasedTask TaskList::remove_after(TaskBase* prev)
+		{
+			TaskBase* node = (prev ? prev->next() : head_);
+			assert(node);
+			TaskBase* next = node->next();
+			if (prev)
+			{
+				prev->set_next(next);
+			}
+			else
+			{
+				head_ = next;
+			}
+			if (tail_ == node)
+			{
+				tail_ = prev;
+			}
+			node->set_next(nullptr);
+			return ErasedTask::attach(node);
+		}
+
+		inline TaskBase* TaskList::front() const
+		{
+			return head_;
+		}
+
+		inline bool TaskList::empty() const
+		{
+			return (head_ == nullptr);
+		}
+
+	} // namespace detail
+} // namespace nn
@@ -0,0 +1,86 @@
+#pragma once
+#include <rename_me/detail/internal_task.h>
+#include <rename_me/detail/threading.h>
+
+#include <cassert>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Intrusive lock-free multi-producer queue of tasks
+		// (consumers take all tasks at once), linked thru TaskBase::next().
+		// Queue owns reference to every pushed task.
+		class TaskQueue
+		{
+		public:
+			explicit TaskQueue();
+			~TaskQueue();
+			TaskQueue(TaskQueue&& rhs) = delete;
+			TaskQueue& operator=(TaskQueue&& rhs) = delete;
+			TaskQueue(const TaskQueue& rhs) = delete;
+			TaskQueue& operator=(const TaskQueue& rhs) = delete;
+
+			// Thread-safe. Returns true if queue was empty
+			bool push(ErasedTask task);
+			// Returns list of tasks in order they were pushed.
+			// Concurrent calls get distinct tasks, but order between
+			// them is not defined. Ownership is transferred to the caller
+			// (see ErasedTask::attach())
+			TaskBase* pop_all();
+			bool empty() const;
+
+		private:
+			// LIFO list
+			Atomic<TaskBase*> head_;
+		};
+
+		/*explicit*/ inline TaskQueue::TaskQueue()
+			: head_(nullptr)
+		{
+		}
+
+		inline TaskQueue::~TaskQueue()
+		{
+			TaskBase* task = pop_all();
+			while (task)
+			{
+				TaskBase* next = task->next();
+				task->set_next(nullptr);
+				(void)ErasedTask::attach(task);
+				task = next;
+			}
+		}
+
+		inline bool TaskQueue::push(ErasedTask task)
+		{
+			assert(task);
+			TaskBase* node = task.detach();
+			assert(!node->next());
+			TaskBase* head = head_.load(std::memory_order_relaxed);
+			do
+			{
+				node->set_next(head);
+			}
+			while (!head_.compare_exchange_weak(head, node
+				, std::memory_order_release, std::memory_order_relaxed));
+			return (head == nullptr);
+		}
+
+		inline TaskBase* TaskQueue::pop_all()
+		{
+			if (empty())
+			{
+				return nullptr;
+			}
+			return ReverseTaskList(head_.exchange(nullptr, std::memory_order_acquire));
+		}
+
+		inline bool TaskQueue::empty() const
+		{
+			return (head_.load(std::memory_order_relaxed) == nullptr);
+		}
+
+	} // namespace detail
+} // namespace nn
@@ -0,0 +1,159 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+
+#include <cassert>
+#include <cstddef>
+
+// Threading policy of the library. With NN_SINGLE_THREADED every
+// Scheduler, its tasks and Task<> handles should be used from one
+// thread only (or from several threads that synchronize
+// with each other externally): reference counts, statuses and
+// counters are plain integers and Scheduler takes no locks.
+// ThreadPoolScheduler is not available.
+// Should be the same for the library and the code that uses it
+#if !defined(NN_SINGLE_THREADED)
+#  define NN_SINGLE_THREADED 0
+#endif
+
+// Fields of the task that other threads modify (reference count,
+// list of continuations) are kept on own cache line of this size,
+// apart from the state used by the thread that ticks the task
+// (see TaskBase). 0 (default) packs them together: 80 bytes
+// instead of 192 for the smallest task on x64, but Task<> handles
+// and continuations created on other threads may slow down
+// ticking of the task (false sharing). Opt-in (e.g., 64) when
+// measured with ThreadPoolScheduler on the target machine
+#if !defined(NN_CACHE_LINE_SIZE)
+#  define NN_CACHE_LINE_SIZE 0
+#endif
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Alignment of the data that other threads modify
+		constexpr std::size_t k_shared_alignment =
+			((NN_CACHE_LINE_SIZE > 0) ? NN_CACHE_LINE_SIZE : alignof(void*));
+		// Alignment of the data that workers write at the same time
+		// (see ParallelPartial). Few such objects exist: padded
+		// to the cache line even if tasks are packed
+		constexpr std::size_t k_worker_alignment =
+			((NN_CACHE_LINE_SIZE > 0) ? NN_CACHE_LINE_SIZE
+				: (NN_SINGLE_THREADED ? alignof(void*) : 64));
+
+#if (NN_SINGLE_THREADED)
+		// Plain value with std::atomic<> interface.
+		// Memory orders are ignored
+		template<typename T>
+		class Atomic
+		{
+		public:
+			constexpr Atomic() noexcept = default;
+			constexpr Atomic(T value) noexcept : value_(value) { }
+			Atomic(const Atomic&) = delete;
+			Atomic& operator=(const Atomic&) = delete;
+
+			T operator=(T value) noexcept { value_ = value; return value; }
+			operator T() const noexcept   { return value_; }
+
+			T load(std::memory_order = std::memory_order_seq_cst) const noexcept
+			{
+				return value_;
+			}
+
+			void store(T value, std::memory_order = std::memory_order_seq_cst) noexcept
+			{
+				value_ = value;
+			}
+
+			T exchange(T value, std::memory_order = std::memory_order_seq_cst) noexcept
+			{
+				const T old = value_;
+				value_ = value;
+				return old;
+			}
+
+			bool compare_exchange_strong(T& expected, T desired
+				, std::memory_order = std::memory_order_seq_cst
+				, std::memory_order = std::memory_order_seq_cst) noexcept
+			{
+				if (value_ == expected)
+				{
+					value_ = desired;
+					return true;
+				}
+				expected = value_;
+				return false;
+			}
+
+			bool compare_exchange_weak(T& expected, T desired
+				, std::memory_order success = std::memory_order_seq_cst
+				, std::memory_order failure = std::memory_order_seq_cst) noexcept
+			{
+				return compare_exchange_strong(expected, desired, success, failure);
+			}
+
+			T fetch_add(T value, std::memory_order = std::memory_order_seq_cst) noexcept
+			{
+				const T old = value_;
+				value_ += value;
+				return old;
+			}
+
+			T fetch_sub(T value, std::memory_order = std::memory_order_seq_cst) noexcept
+			{
+				const T old = value_;
+				value_ -= value;
+				return old;
+			}
+
+			T operator++() noexcept    { return ++value_; }
+			T operator--() noexcept    { return --value_; }
+			T operator++(int) noexcept { return value_++; }
+			T operator--(int) noexcept { return value_--; }
+
+		private:
+			T value_{};
+		};
+
+		// Satisfies Lockable, never blocks. Keeps try_lock()
+		// semantic: fails if locked already (e.g., poll() from tick())
+		class Mutex
+		{
+		public:
+			void lock()   { assert(!locked_); locked_ = true; }
+			void unlock() { assert(locked_); locked_ = false; }
+
+			bool try_lock()
+			{
+				if (locked_)
+				{
+					return false;
+				}
+				locked_ = true;
+				return true;
+			}
+
+		private:
+			bool locked_ = false;
+		};
+
+		inline void AtomicFence(std::memory_order)
+		{
+		}
+#else
+		template<typename T>
+		using Atomic = std::atomic<T>;
+
+		using Mutex = std::mutex;
+
+		inline void AtomicFence(std::memory_order order)
+		{
+			std::atomic_thread_fence(order);
+		}
+#endif
+
+	} // namespace detail
+} // namespace nn
@@ -0,0 +1,333 @@
+#pragma once
+#include <rename_me/detail/bits.h>
+#include <rename_me/detail/threading.h>
+
+#include <chrono>
+#include <limits>
+
+#include <cstdint>
+#include <cassert>
+
+namespace nn
+{
+
+	class Scheduler;
+
+	namespace detail
+	{
+
+		class TaskBase;
+		class TimerWheel;
+
+		// Timer that is kept inside the task, see CustomTask::timer().
+		// All the state, except deadline, is owned by the Scheduler
+		class TimerNode
+		{
+		public:
+			using Clock = std::chrono::steady_clock;
+
+			explicit TimerNode(Clock::time_point deadline);
+			TimerNode(TimerNode&& rhs) = delete;
+			TimerNode& operator=(TimerNode&& rhs) = delete;
+			TimerNode(const TimerNode& rhs) = delete;
+			TimerNode& operator=(const TimerNode& rhs) = delete;
+
+			Clock::time_point deadline() const;
+			bool is_scheduled() const;
+
+		private:
+			friend class TimerWheel;
+			friend class nn::Scheduler;
+
+			static constexpr std::uint8_t k_not_scheduled =
+				std::numeric_limits<std::uint8_t>::max();
+
+			const Clock::time_point deadline_;
+			// Owned reference to the task while timer is not expired
+			TaskBase* task_;
+			// Links in the TimerWheel's slot or in the list
+			// of timers posted to the Scheduler
+			TimerNode* prev_;
+			TimerNode* next_;
+			// Link in the list of canceled timers
+			TimerNode* next_canceled_;
+			Atomic<bool> cancel_posted_;
+			bool canceled_;
+			bool expired_;
+			std::uint8_t level_;
+			std::uint64_t tick_;
+		};
+
+		// Hierarchical timer wheel: 6 levels of 64 slots.
+		// Slot of level N covers 64^N ticks, whole wheel
+		// covers 63 * 2^30 ticks (~782 days for 1ms tick).
+		// Schedule and cancel are O(1), expiration is O(1) per timer
+		// with, at most, one cascade to the lower level per level.
+		// Not thread-safe.
+		class TimerWheel
+		{
+		public:
+			static constexpr unsigned k_levels = 6;
+			static constexpr unsigned k_slot_bits = 6;
+			static constexpr unsigned k_slots = (1u << k_slot_bits);
+			static constexpr std::uint64_t k_range =
+				(std::uint64_t(1) << (k_levels * k_slot_bits));
+			// Timer can't be in the same slot of the last level
+			// where the wheel is now (after wrap-around)
+			static constexpr std::uint64_t k_max_ticks =
+				(k_range - (k_range >> k_slot_bits));
+			static constexpr std::uint64_t k_never =
+				std::numeric_limits<std::uint64_t>::max();
+
+			explicit TimerWheel();
+			TimerWheel(TimerWheel&& rhs) = delete;
+			TimerWheel& operator=(TimerWheel&& rhs) = delete;
+			TimerWheel(const TimerWheel& rhs) = delete;
+			TimerWheel& operator=(const TimerWheel& rhs) = delete;
+
+			// `tick` should be greater then elapsed().
+			// Ticks that are too far are clamped
+			void schedule(TimerNode& timer, std::uint64_t tick);
+			void cancel(TimerNode& timer);
+			// Moves wheel to `now` tick and invokes `on_expired(TimerNode&)`
+			// for every expired timer. Timer is not scheduled
+			// when `on_expired` is invoked
+			template<typename F>
+			void advance(std::uint64_t now, F on_expired);
+
+			// Tick when advance() should be invoked next time or k_never.
+			// Note: this may be earlier then real timer's tick
+			// (when timer needs to be moved to lower level)
+			std::uint64_t next_expiration() const;
+			std::uint64_t elapsed() const;
+			bool empty() const;
+
+		private:
+			struct Expiration
+			{
+				unsigned level;
+				unsigned slot;
+				std::uint64_t tick;
+			};
+
+			struct Level
+			{
+				std::uint64_t occupied;
+				TimerNode* slots[k_slots];
+			};
+
+			bool next_expiration(Expiration& expiration) const;
+			void insert(TimerNode& timer);
+			TimerNode* take_slot(unsigned level, unsigned slot);
+
+			static unsigned LevelFor(std::uint64_t elapsed, std::uint64_t tick);
+			static unsigned SlotFor(std::uint64_t tick, unsigned level);
+
+		private:
+			std::uint64_t elapsed_;
+			std::size_t count_;
+			Level levels_[k_levels];
+		};
+
+		/*explicit*/ inline TimerNode::TimerNode(Clock::time_point deadline)
+			: deadline_(deadline)
+			, task_(nullptr)
+			, prev_(nullptr)
+			, next_(nullptr)
+			, next_canceled_(nullptr)
+			, cancel_posted_(false)
+			, canceled_(false)
+			, expired_(false)
+			, level_(k_not_scheduled)
+			, tick_(0)
+		{
+		}
+
+		inline TimerNode::Clock::time_point TimerNode::deadline() const
+		{
+			return deadline_;
+		}
+
+		inline bool TimerNode::is_scheduled() const
+		{
+			return (level_ != k_not_scheduled);
+		}
+
+		/*explicit*/ inline TimerWheel::TimerWheel()
+			: elapsed_(0)
+			, count_(0)
+			, levels_()
+		{
+		}
+
+		inline std::uint64_t TimerWheel::elapsed() const
+		{
+			return elapsed_;
+		}
+
+		inline bool TimerWheel::empty() const
+		{
+			return (count_ == 0);
+		}
+
+		/*static*/ inline unsigned TimerWheel::LevelFor(std::uint64_t elapsed, std::uint64_t tick)
+		{
+			// Highest bit that differs tells how far `tick` is
+			std::uint64_t masked = ((elapsed ^ tick) | (k_slots - 1));
+			if (masked >= k_range)
+			{
+				// Last level wraps around
+				masked = (k_range - 1);
+			}
+			return (HighestBit(masked) / k_slot_bits);
+		}
+
+		/*static*/ inline unsigned TimerWheel::SlotFor(std::uint64_t tick, unsigned level)
+		{
+			return static_cast<unsigned>((tick >> (level * k_slot_bits)) & (k_slots - 1));
+		}
+
+		inline void TimerWheel::schedule(TimerNode& timer, std::uint64_t tick)
+		{
+			assert(!timer.is_scheduled());
+			assert(tick > elapsed_);
+			if ((tick - elapsed_) >= k_max_ticks)
+			{
+				tick = (elapsed_ + k_max_ticks - 1);
+			}
+			timer.tick_ = tick;
+			insert(timer);
+			++count_;
+		}
+
+		inline void TimerWheel::insert(TimerNode& timer)
+		{
+			const unsigned level = LevelFor(elapsed_, timer.tick_);
+			assert(level < k_levels);
+			const unsigned slot = SlotFor(timer.tick_, level);
+			Level& l = levels_[level];
+			TimerNode*& head = l.slots[slot];
+			timer.level_ = static_cast<std::uint8_t>(level);
+			timer.prev_ = nullptr;
+			timer.next_ = head;
+			if (head)
+			{
+				head->prev_ = &timer;
+			}
+			head = &timer;
+			l.occupied |= (std::uint64_t(1) << slot);
+		}
+
+		inline void TimerWheel::cancel(TimerNode& timer)
+		{
+			assert(timer.is_scheduled());
+			const unsigned level = timer.level_;
+			const unsigned slot = SlotFor(timer.tick_, level);
+			Level& l = levels_[level];
+			if (timer.prev_)
+			{
+				timer.prev_->next_ = timer.next_;
+			}
+			else
+			{
+				assert(l.slots[slot] == &timer);
+				l.slots[slot] = timer.next_;
+			}
+			if (timer.next_)
+			{
+				timer.next_->prev_ = timer.prev_;
+			}
+			if (!l.slots[slot])
+			{
+				l.occupied &= ~(std::uint64_t(1) << slot);
+			}
+			timer.prev_ = nullptr;
+			timer.next_ = nullptr;
+			timer.level_ = TimerNode::k_not_scheduled;
+			--count_;
+		}
+
+		inline TimerNode* TimerWheel::take_slot(unsigned level, unsigned slot)
+		{
+			Level& l = levels_[level];
+			TimerNode* head = l.slots[slot];
+			l.slots[slot] = nullptr;
+			l.occupied &= ~(std::uint64_t(1) << slot);
+			return head;
+		}
+
+		inline bool TimerWheel::next_expiration(Expiration& expiration) const
+		{
+			// Slots of the lower level always expire before
+			// slots of the higher level
+			for (unsigned level = 0; level < k_levels; ++level)
+			{
+				const Level& l = levels_[level];
+				if (l.occupied == 0)
+				{
+					continue;
+				}
+				const unsigned shift = (level * k_slot_bits);
+				const std::uint64_t slot_range = (std::uint64_t(1) << shift);
+				const std::uint64_t level_range = (slot_range << k_slot_bits);
+				const unsigned now_slot = SlotFor(elapsed_, level);
+				const unsigned slot = ((CountTrailingZeros(
+					RotateRight(l.occupied, now_slot)) + now_slot) & (k_slots - 1));
+				const std::uint64_t level_start = (elapsed_ & ~(level_range - 1));
+				expiration.level = level;
+				expiration.slot = slot;
+				expiration.tick = (level_start + (slot * slot_range));
+				if (expiration.tick <= elapsed_)
+				{
+					// Last level wrapped around
+					expiration.tick += level_range;
+				}
+				return true;
+			}
+			return false;
+		}
+
+		inline std::uint64_t TimerWheel::next_expiration() const
+		{
+			Expiration expiration{};
+			return (next_expiration(expiration) ? expiration.tick : k_never);
+		}
+
+		template<typename F>
+		void TimerWheel::advance(std::uint64_t now, F on_expired)
+		{
+			Expiration expiration{};
+			while (next_expiration(expiration) && (expiration.tick <= now))
+			{
+				if (expiration.tick > elapsed_)
+				{
+					elapsed_ = expiration.tick;
+				}
+				TimerNode* timer = take_slot(expiration.level, expiration.slot);
+				while (timer)
+				{
+					TimerNode* next = timer->next_;
+					timer->prev_ = nullptr;
+					timer->next_ = nullptr;
+					if (timer->tick_ <= elapsed_)
+					{
+						timer->level_ = TimerNode::k_not_scheduled;
+						--count_;
+						on_expired(*timer);
+					}
+					else
+					{
+						// Cascade to the lower level
+						insert(*timer);
+					}
+					timer = next;
+				}
+			}
+			if (now > elapsed_)
+			{
+				elapsed_ = now;
+			}
+		}
+
+	} // namespace detail
+} // namespace nn
@@ -0,0 +1,107 @@
+#pragma once
+#include <rename_me/custom_task.h>
+
+#include <cstdint>
+
+// Tracing of task's lifetime, see tracing.h.
+// Should be the same for the library and the code that uses it
+#if !defined(NN_ENABLE_TRACING)
+#  define NN_ENABLE_TRACING 0
+#endif
+
+#if (NN_ENABLE_TRACING)
+#  define NN_TRACE(statement) statement
+#else
+#  define NN_TRACE(statement) (void)0
+#endif
+
+namespace nn
+{
+	namespace detail
+	{
+
+		enum class TraceEventType : std::uint8_t
+		{
+			Create,
+			Tick,
+			Cancel,
+			Continuation,
+			Poll,
+		};
+
+		struct TraceEvent
+		{
+			// Nanoseconds of steady_clock
+			std::int64_t time;
+			// Tick and Poll
+			std::int64_t duration;
+			// Task or Scheduler (Poll)
+			const void* object;
+			// Create: type name (const char*).
+			// Continuation: continuation task (`object` is parent)
+			const void* other;
+			// Poll: ticks count
+			std::uint64_t count;
+			TraceEventType type;
+			// Create: initial status. Tick: status returned by tick()
+			Status status;
+		};
+
+		bool IsTracing();
+		std::int64_t TraceNow();
+		// Thread-safe, lock-free. Adds event to the calling thread's buffer
+		void RecordTraceEvent(const TraceEvent& event);
+
+		inline void TraceCreate(const void* task, const char* type_name, Status status)
+		{
+			if (IsTracing())
+			{
+				RecordTraceEvent(TraceEvent{TraceNow(), 0, task, type_name
+					, 0, TraceEventType::Create, status});
+			}
+		}
+
+		inline void TraceTick(const void* task, std::int64_t start, Status status)
+		{
+			if (IsTracing() && (start != 0))
+			{
+				RecordTraceEvent(TraceEvent{start, TraceNow() - start, task, nullptr
+					, 0, TraceEventType::Tick, status});
+			}
+		}
+
+		inline void TraceCancel(const void* task)
+		{
+			if (IsTracing())
+			{
+				RecordTraceEvent(TraceEvent{TraceNow(), 0, task, nullptr
+					, 0, TraceEventType::Cancel, Status::InProgress});
+			}
+		}
+
+		inline void TraceContinuation(const void* parent, const void* continuation)
+		{
+			if (IsTracing())
+			{
+				RecordTraceEvent(TraceEvent{TraceNow(), 0, parent, continuation
+					, 0, TraceEventType::Continuation, Status::InProgress});
+			}
+		}
+
+		inline void TracePoll(const void* scheduler, std::int64_t start, std::uint64_t ticks)
+		{
+			if (IsTracing() && (start != 0) && (ticks != 0))
+			{
+				RecordTraceEvent(TraceEvent{start, TraceNow() - start, scheduler, nullptr
+					, ticks, TraceEventType::Poll, Status::InProgress});
+			}
+		}
+
+		// Start time for TraceTick() and TracePoll(), 0 if tracing is disabled
+		inline std::int64_t TraceStart()
+		{
+			return (IsTracing() ? TraceNow() : 0);
+		}
+
+	} // namespace detail
+} // namespace nn
@@ -0,0 +1,314 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/detail/internal_task.h>
+#include <rename_me/detail/threading.h>
+
+#include <tuple>
+#include <vector>
+#include <variant>
+#include <optional>
+#include <utility>
+#include <limits>
+
+#include <cstddef>
+#include <cassert>
+
+namespace nn
+{
+
+	template<typename Value>
+	struct WhenAnyResult;
+
+	namespace detail
+	{
+
+		class WhenLatch;
+
+		// Continuation of the task that is waited by when_all()
+		// or when_any(). Tells the latch that the task finished,
+		// right on the thread that finished it (inline continuation).
+		// Keeps the task that owns the latch alive
+		class WhenWaiter final : public TaskBase
+		{
+		public:
+			// Allocates the waiter from `scheduler`'s TaskAllocator
+			static ErasedTask Make(Scheduler& scheduler, WhenLatch& latch, std::size_t index);
+
+			explicit WhenWaiter(Scheduler& scheduler, WhenLatch& latch, std::size_t index);
+
+			virtual Status update() override;
+			virtual void destroy() noexcept override;
+
+		private:
+			WhenLatch& latch_;
+			const std::size_t index_;
+		};
+
+		// Completion of when_all()/when_any(). Waited tasks are not
+		// polled: every task decrements the counter once it finishes
+		// (see WhenWaiter). Task that owns the latch is not posted
+		// to the scheduler until the latch opens
+		class WhenLatch
+		{
+		public:
+			static constexpr std::size_t k_none = (std::numeric_limits<std::size_t>::max)();
+
+			// Opens once all `count` tasks finish or, if `any`,
+			// once the first of them finishes
+			explicit WhenLatch(Scheduler& scheduler, std::size_t count, bool any);
+			WhenLatch(const WhenLatch&) = delete;
+			WhenLatch& operator=(const WhenLatch&) = delete;
+
+			// Creates not posted task that owns the latch and waits
+			// for every task of `WhenTask::children()`.
+			// `WhenTask` is constructed from `scheduler`, `children`
+			// and `args`
+			template<typename T, typename E, typename WhenTask, typename Children, typename... Args>
+			static Task<T, E> Make(Scheduler& scheduler, Children&& children, Args&&... args);
+
+			// Index of the task that finished first or k_none
+			std::size_t first() const;
+			// Thread-safe. True if the task that owns the latch
+			// is canceled, but not ticked yet
+			bool cancel_requested() const;
+
+		private:
+			friend class WhenWaiter;
+
+			template<typename T, typename E>
+			void wait(std::size_t index, Task<T, E>& task);
+			// Null `task` is finished already
+			void wait_task(std::size_t index, TaskBase* task);
+			void start(TaskBase& owner);
+			void arrive(std::size_t index);
+			// Reference to the owner that is kept by every waiter
+			void release() noexcept;
+
+		private:
+			Scheduler& scheduler_;
+			// Read by waited tasks (see ParallelLoop)
+			Atomic<TaskBase*> owner_;
+			const std::size_t count_;
+			const bool any_;
+			Atomic<std::size_t> remaining_;
+			Atomic<std::size_t> first_;
+		};
+
+		template<typename... Ts, typename... Es, typename F>
+		void ForEachTask(std::tuple<Task<Ts, Es>...>& tasks, F&& f)
+		{
+			std::size_t index = 0;
+			std::apply([&](auto&... task)
+			{
+				(f(index++, task), ...);
+			}, tasks);
+		}
+
+		template<typename T, typename E, typename Allocator, typename F>
+		void ForEachTask(std::vector<Task<T, E>, Allocator>& tasks, F&& f)
+		{
+			for (std::size_t i = 0, count = tasks.size(); i < count; ++i)
+			{
+				f(i, tasks[i]);
+			}
+		}
+
+		template<typename... Ts, typename... Es>
+		std::size_t TasksCount(const std::tuple<Task<Ts, Es>...>&)
+		{
+			return sizeof...(Ts);
+		}
+
+		template<typename T, typename E>
+		std::size_t TasksCount(const std::vector<Task<T, E>>& tasks)
+		{
+			return tasks.size();
+		}
+
+		template<typename... Ts, typename... Es>
+		std::tuple<expected<Ts, Es>...> TakeAll(std::tuple<Task<Ts, Es>...>& tasks)
+		{
+			return std::apply([](auto&... task)
+			{
+				return std::tuple<expected<Ts, Es>...>(std::move(task).get()...);
+			}, tasks);
+		}
+
+		template<typename T, typename E>
+		std::vector<expected<T, E>> TakeAll(std::vector<Task<T, E>>& tasks)
+		{
+			std::vector<expected<T, E>> values;
+			values.reserve(tasks.size());
+			for (Task<T, E>& task : tasks)
+			{
+				values.push_back(std::move(task).get());
+			}
+			return values;
+		}
+
+		template<typename... Ts, typename... Es, std::size_t... Is>
+		std::variant<expected<Ts, Es>...> TakeOne(std::tuple<Task<Ts, Es>...>& tasks
+			, std::size_t index, std::index_sequence<Is...>)
+		{
+			using Value = std::variant<expected<Ts, Es>...>;
+			std::optional<Value> value;
+			(void)((Is == index
+				? (value.emplace(std::in_place_index<Is>, std::move(std::get<Is>(tasks)).get()), true)
+				: false) || ...);
+			assert(value);
+			return std::move(*value);
+		}
+
+		template<typename... Ts, typename... Es>
+		std::variant<expected<Ts, Es>...> TakeOne(std::tuple<Task<Ts, Es>...>& tasks
+			, std::size_t index)
+		{
+			return TakeOne(tasks, index, std::index_sequence_for<Ts...>());
+		}
+
+		template<typename T, typename E>
+		expected<T, E> TakeOne(std::vector<Task<T, E>>& tasks, std::size_t index)
+		{
+			return std::move(tasks[index]).get();
+		}
+
+		// Ticked once, when all tasks finished.
+		// `Children` is std::tuple<> or std::vector<> of tasks
+		template<typename Children>
+		class WhenAllTask
+		{
+		public:
+			using Value = decltype(TakeAll(std::declval<Children&>()));
+
+			explicit WhenAllTask(Scheduler& scheduler, Children&& children)
+				: children_(std::move(children))
+				, latch_(scheduler, TasksCount(children_), false/*any*/)
+				, data_()
+			{
+			}
+
+			WhenAllTask(const WhenAllTask&) = delete;
+			WhenAllTask(WhenAllTask&&) = delete;
+
+			Status tick(const ExecutionContext& context)
+			{
+				if (context.cancel_requested)
+				{
+					data_ = MakeExpectedWithDefaultError<expected<Value, void>>();
+					return Status::Canceled;
+				}
+				data_.emplace(TakeAll(children_));
+				return Status::Successful;
+			}
+
+			expected<Value, void>& get()
+			{
+				return data_;
+			}
+
+			Children& children()
+			{
+				return children_;
+			}
+
+			WhenLatch& latch()
+			{
+				return latch_;
+			}
+
+		private:
+			Children children_;
+			WhenLatch latch_;
+			expected<Value, void> data_;
+		};
+
+		// Ticked once, when first task finished. Cancels the rest
+		template<typename Children>
+		class WhenAnyTask
+		{
+		public:
+			using Value = WhenAnyResult<decltype(
+				TakeOne(std::declval<Children&>(), std::size_t()))>;
+
+			explicit WhenAnyTask(Scheduler& scheduler, Children&& children)
+				: children_(std::move(children))
+				, latch_(scheduler, TasksCount(children_), true/*any*/)
+				, data_()
+			{
+			}
+
+			WhenAnyTask(const WhenAnyTask&) = delete;
+			WhenAnyTask(WhenAnyTask&&) = delete;
+
+			Status tick(const ExecutionContext& context)
+			{
+				const std::size_t first = latch_.first();
+				ForEachTask(children_, [first](std::size_t index, auto& task)
+				{
+					if ((index != first) && task.is_in_progress())
+					{
+						task.try_cancel();
+					}
+				});
+				if (context.cancel_requested)
+				{
+					data_ = MakeExpectedWithDefaultError<expected<Value, void>>();
+					return Status::Canceled;
+				}
+				if (first == WhenLatch::k_none)
+				{
+					// Nothing to wait for
+					data_ = MakeExpectedWithDefaultError<expected<Value, void>>();
+					return Status::Failed;
+				}
+				data_.emplace(Value{first, TakeOne(children_, first)});
+				return Status::Successful;
+			}
+
+			expected<Value, void>& get()
+			{
+				return data_;
+			}
+
+			Children& children()
+			{
+				return children_;
+			}
+
+			WhenLatch& latch()
+			{
+				return latch_;
+			}
+
+		private:
+			Children children_;
+			WhenLatch latch_;
+			expected<Value, void> data_;
+		};
+
+		template<typename T, typename E, typename WhenTask, typename Children, typename... Args>
+		/*static*/ Task<T, E> WhenLatch::Make(Scheduler& scheduler, Children&& children, Args&&... args)
+		{
+			using FullTask = InternalCustomTask<T, E, WhenTask>;
+			auto full_task = FullTask::Make(scheduler, scheduler, std::move(children)
+				, std::forward<Args>(args)...);
+			WhenTask& when_task = full_task->task();
+			WhenLatch& latch = when_task.latch();
+			latch.start(*full_task);
+			ForEachTask(when_task.children(), [&latch](std::size_t index, auto& task)
+			{
+				latch.wait(index, task);
+			});
+			return Task<T, E>(full_task.template to_base<InternalTask<T, E>>());
+		}
+
+		template<typename T, typename E>
+		void WhenLatch::wait(std::size_t index, Task<T, E>& task)
+		{
+			assert(task.is_valid());
+			// Ready task (see Task<>::make_ready()) has no internals
+			wait_task(index, task.task_.get());
+		}
+
+	} // namespace detail
+} // namespace nn
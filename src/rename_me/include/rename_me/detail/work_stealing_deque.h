@@ -0,0 +1,197 @@
+#pragma once
+#include <rename_me/detail/internal_task.h>
+
+#include <vector>
+#include <list>
+#include <memory_resource>
+#include <atomic>
+
+#include <cstdint>
+#include <cassert>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		// Chase-Lev work-stealing deque of tasks.
+		// Owner thread push()-es and pop()-s tasks from the bottom
+		// (LIFO), any other thread may steal() from the top (FIFO).
+		// Grows when full. Deque owns reference to every pushed task.
+		// Buffers are allocated from `resource`, that should outlive the deque.
+		// See "Correct and Efficient Work-Stealing for Weak Memory
+		// Models", N. M. Le, A. Pop, A. Cohen, F. Z. Nardelli
+		class WorkStealingDeque
+		{
+		public:
+			explicit WorkStealingDeque(std::pmr::memory_resource& resource
+				, std::size_t capacity = 256);
+			~WorkStealingDeque();
+			WorkStealingDeque(WorkStealingDeque&& rhs) = delete;
+			WorkStealingDeque& operator=(WorkStealingDeque&& rhs) = delete;
+			WorkStealingDeque(const WorkStealingDeque& rhs) = delete;
+			WorkStealingDeque& operator=(const WorkStealingDeque& rhs) = delete;
+
+			// Owner thread only
+			void push(ErasedTask task);
+			// Owner thread only. Returns null task if deque is empty
+			ErasedTask pop();
+			// Thread-safe. Returns null task if deque is empty
+			// or other thread won the race for the same task
+			ErasedTask steal();
+			// Thread-safe, approximate
+			bool empty() const;
+
+		private:
+			class Buffer
+			{
+			public:
+				explicit Buffer(std::size_t capacity, std::pmr::memory_resource& resource);
+
+				std::size_t capacity() const;
+				TaskBase* get(std::int64_t index) const;
+				void put(std::int64_t index, TaskBase* task);
+				// Copies tasks of [top, bottom) to the bigger `buffer`
+				void grow(Buffer& buffer, std::int64_t bottom, std::int64_t top) const;
+
+			private:
+				const std::size_t mask_;
+				std::pmr::vector<std::atomic<TaskBase*>> slots_;
+			};
+
+		private:
+			std::atomic<std::int64_t> top_;
+			std::atomic<std::int64_t> bottom_;
+			std::atomic<Buffer*> buffer_;
+			std::pmr::memory_resource& resource_;
+			// Thieves may still read from old buffers.
+			// Keep them alive until deque is destroyed
+			std::pmr::list<Buffer> buffers_;
+		};
+
+		/*explicit*/ inline WorkStealingDeque::Buffer::Buffer(std::size_t capacity
+			, std::pmr::memory_resource& resource)
+			: mask_(capacity - 1)
+			, slots_(capacity, &resource)
+		{
+			assert((capacity != 0) && ((capacity & mask_) == 0)
+				&& "Capacity should be power of 2");
+		}
+
+		inline std::size_t WorkStealingDeque::Buffer::capacity() const
+		{
+			return (mask_ + 1);
+		}
+
+		inline TaskBase* WorkStealingDeque::Buffer::get(std::int64_t index) const
+		{
+			return slots_[static_cast<std::size_t>(index) & mask_].load(std::memory_order_relaxed);
+		}
+
+		inline void WorkStealingDeque::Buffer::put(std::int64_t index, TaskBase* task)
+		{
+			slots_[static_cast<std::size_t>(index) & mask_].store(task, std::memory_order_relaxed);
+		}
+
+		inline void WorkStealingDeque::Buffer::grow(Buffer& buffer
+			, std::int64_t bottom, std::int64_t top) const
+		{
+			assert(buffer.capacity() > capacity());
+			for (std::int64_t i = top; i != bottom; ++i)
+			{
+				buffer.put(i, get(i));
+			}
+		}
+
+		/*explicit*/ inline WorkStealingDeque::WorkStealingDeque(std::pmr::memory_resource& resource
+			, std::size_t capacity /*= 256*/)
+			: top_(0)
+			, bottom_(0)
+			, buffer_(nullptr)
+			, resource_(resource)
+			, buffers_(&resource)
+		{
+			buffers_.emplace_back(capacity, resource_);
+			buffer_.store(&buffers_.back(), std::memory_order_relaxed);
+		}
+
+		inline WorkStealingDeque::~WorkStealingDeque()
+		{
+			while (ErasedTask task = pop())
+			{
+			}
+		}
+
+		inline void WorkStealingDeque::push(ErasedTask task)
+		{
+			assert(task);
+			const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+			const std::int64_t top = top_.load(std::memory_order_acquire);
+			Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+			if ((bottom - top) > static_cast<std::int64_t>(buffer->capacity() - 1))
+			{
+				Buffer& grown = buffers_.emplace_back(2 * buffer->capacity(), resource_);
+				buffer->grow(grown, bottom, top);
+				buffer = &grown;
+				buffer_.store(buffer, std::memory_order_release);
+			}
+			buffer->put(bottom, task.detach());
+			// Task is visible to steal() that sees new bottom
+			bottom_.store(bottom + 1, std::memory_order_release);
+		}
+
+		inline ErasedTask WorkStealingDeque::pop()
+		{
+			const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+			Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+			bottom_.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			std::int64_t top = top_.load(std::memory_order_relaxed);
+			if (top > bottom)
+			{
+				// Empty
+				bottom_.store(bottom + 1, std::memory_order_relaxed);
+				return ErasedTask();
+			}
+			TaskBase* task = buffer->get(bottom);
+			if (top == bottom)
+			{
+				// Last task. Race with thieves
+				if (!top_.compare_exchange_strong(top, top + 1
+					, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					task = nullptr;
+				}
+				bottom_.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return (task ? ErasedTask::attach(task) : ErasedTask());
+		}
+
+		inline ErasedTask WorkStealingDeque::steal()
+		{
+			std::int64_t top = top_.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+			if (top >= bottom)
+			{
+				return ErasedTask();
+			}
+			Buffer* buffer = buffer_.load(std::memory_order_acquire);
+			TaskBase* task = buffer->get(top);
+			if (!top_.compare_exchange_strong(top, top + 1
+				, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return ErasedTask();
+			}
+			return ErasedTask::attach(task);
+		}
+
+		inline bool WorkStealingDeque::empty() const
+		{
+			const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+			const std::int64_t top = top_.load(std::memory_order_relaxed);
+			return (bottom <= top);
+		}
+
+	} // namespace detail
+} // namespace nn
@@ -13,10 +13,9 @@ namespace nn
 		typename Return::type InvokeError(Scheduler& scheduler, const Task<T, E>& task)
 		{
 			using type = typename Return::type;
-			using Noop = detail::NoopTask<typename type::value_type, typename type::error_type>;
 			using Expected = typename type::value;
 
-			return type::template make<Noop>(scheduler
+			return type::make_ready(scheduler
 				, MakeExpectedWithError<Expected>(std::move(task.get().error())));
 		}
 
@@ -26,10 +25,9 @@ namespace nn
 			(void)task;
 
 			using type = typename Return::type;
-			using Noop = detail::NoopTask<typename type::value_type, void>;
 			using Expected = typename type::value;
 
-			return type::template make<Noop>(scheduler
+			return type::make_ready(scheduler
 				, MakeExpectedWithDefaultError<Expected>());
 		}
 
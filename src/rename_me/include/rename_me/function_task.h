@@ -18,9 +18,11 @@ namespace nn
 	// #TODO: probably, if function returns T&, reference should not be discarded.
 	// Looks like it depends on std::expected: if it supports references - they can 
 	// be added easily.
+	// 
+	// Task is ticked in the lane of given `priority` (see Scheduler::poll())
 	template<typename F, typename... Args>
 	detail::FunctionTaskReturnT<F, detail::remove_cvref_t<Args>...>
-		make_task(Scheduler& scheduler, F&& f, Args&&... args)
+		make_task(Priority priority, Scheduler& scheduler, F&& f, Args&&... args)
 	{
 		using Function = detail::remove_cvref_t<F>;
 		using ArgsTuple = std::tuple<detail::remove_cvref_t<Args>...>;
@@ -58,8 +60,17 @@ namespace nn
 		};
 
 		using FunctionTask = detail::FunctionTask<FunctionTaskReturn, Invoker>;
-		return ReturnTask::template make<FunctionTask>(scheduler
+		return ReturnTask::template make<FunctionTask>(priority, scheduler
 			, Invoker(std::forward<F>(f), ArgsTuple(std::forward<Args>(args)...)));
 	}
 
+	// Same as above, with Priority::Normal
+	template<typename F, typename... Args>
+	detail::FunctionTaskReturnT<F, detail::remove_cvref_t<Args>...>
+		make_task(Scheduler& scheduler, F&& f, Args&&... args)
+	{
+		return make_task(Priority::Normal, scheduler
+			, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
 } // namespace nn
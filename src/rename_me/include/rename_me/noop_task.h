@@ -15,13 +15,13 @@ namespace nn
 	template<typename T, typename E>
 	Task<T, E> make_task(Scheduler& scheduler, expected<T, E>&& v)
 	{
-		return Task<T, E>::template make<detail::NoopTask<T, E>>(scheduler, std::move(v));
+		return Task<T, E>::make_ready(scheduler, std::move(v));
 	}
 
 	template<typename T, typename E>
 	Task<T, E> make_task(Scheduler& scheduler, const expected<T, E>& v)
 	{
-		return Task<T, E>::template make<detail::NoopTask<T, E>>(scheduler, v);
+		return Task<T, E>::make_ready(scheduler, v);
 	}
 
 	template<typename T, typename E = void>
@@ -31,10 +31,9 @@ namespace nn
 			"Error should not be reference/const/volatile");
 
 		using DerivedTask = Task<detail::remove_cvref_t<T>, E>;
-		using Noop = detail::NoopTask<typename DerivedTask::value_type, E>;
 		using Expected = typename DerivedTask::value;
 		
-		return DerivedTask::template make<Noop>(scheduler
+		return DerivedTask::make_ready(scheduler
 			, Expected(std::move(v)));
 	}
 
@@ -45,10 +44,9 @@ namespace nn
 			"Error should not be reference/const/volatile");
 
 		using DerivedTask = Task<void, E>;
-		using Noop = detail::NoopTask<void, E>;
 		using Expected = typename DerivedTask::value;
 
-		return DerivedTask::template make<Noop>(scheduler
+		return DerivedTask::make_ready(scheduler
 			, Expected());
 	}
 
@@ -59,10 +57,9 @@ namespace nn
 			"Value should not be reference/const/volatile");
 
 		using DerivedTask = Task<T, detail::remove_cvref_t<E>>;
-		using Noop = detail::NoopTask<T, typename DerivedTask::error_type>;
 		using Expected = typename DerivedTask::value;
 
-		return DerivedTask::template make<Noop>(scheduler
+		return DerivedTask::make_ready(scheduler
 			, MakeExpectedWithError<Expected>(std::move(v)));
 	}
 
@@ -73,10 +70,9 @@ namespace nn
 			"Value should not be reference/const/volatile");
 
 		using DerivedTask = Task<T, void>;
-		using Noop = detail::NoopTask<T, void>;
 		using Expected = typename DerivedTask::value;
 
-		return DerivedTask::template make<Noop>(scheduler
+		return DerivedTask::make_ready(scheduler
 			, Expected());
 	}
 	
@@ -84,10 +80,9 @@ namespace nn
 	inline auto make_task<void>(ErrorTag, Scheduler& scheduler)
 	{
 		using DerivedTask = Task<void, void>;
-		using Noop = detail::NoopTask<void, void>;
 		using Expected = typename DerivedTask::value;
 
-		return DerivedTask::template make<Noop>(scheduler
+		return DerivedTask::make_ready(scheduler
 			, MakeExpectedWithDefaultError<Expected>());
 	}
 
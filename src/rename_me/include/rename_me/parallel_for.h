@@ -0,0 +1,104 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/detail/parallel_task_base.h>
+
+#include <vector>
+#include <memory_resource>
+#include <iterator>
+#include <type_traits>
+
+#include <cstddef>
+
+namespace nn
+{
+
+	// Invokes `f(*it)` for every element of [first, last) on the worker
+	// tasks of the `scheduler`, one per thread that ticks its tasks
+	// (see Scheduler::concurrency()). Workers claim chunks of `grain`
+	// elements until the range is done, so faster worker processes more
+	// chunks. 0 `grain` splits the range into ~8 chunks per worker.
+	// `f` returns void or expected<void, E>: first error fails returned
+	// task, chunks that are not claimed yet are not run.
+	// try_cancel() of returned task stops workers after current chunk.
+	// `f` is invoked concurrently; the range should outlive returned task.
+	// Only O(workers) tasks are allocated for the whole range
+	//
+	//   auto task = parallel_for(scheduler, pixels.begin(), pixels.end()
+	//       , [](Pixel& pixel) { pixel = Blur(pixel); });
+	template<typename RandomIt, typename F>
+	Task<void, typename detail::ParallelResultOf<RandomIt, F>::error_type>
+		parallel_for(Scheduler& scheduler, RandomIt first, RandomIt last
+			, F&& f, std::size_t grain = 0)
+	{
+		static_assert(std::is_void_v<typename detail::ParallelResultOf<RandomIt, F>::value_type>
+			, "parallel_for() function should return void or expected<void, E>");
+		using Body = detail::ParallelForBody<RandomIt, std::decay_t<F>, detail::ParallelNone>;
+		const auto split = detail::SplitParallelRange(scheduler
+			, static_cast<std::size_t>(std::distance(first, last)), grain);
+		return detail::MakeParallelTask(scheduler, first, split
+			, Body(std::decay_t<F>(std::forward<F>(f)), detail::ParallelNone()));
+	}
+
+	// Same as parallel_for(), but keeps values returned by `f`: value
+	// of returned task has one value per element, in the same order.
+	// `f` returns U or expected<U, E>; U should be default-constructible,
+	// the vector of the values is allocated once from the
+	// Scheduler's memory_resource()
+	template<typename RandomIt, typename F>
+	Task<std::pmr::vector<typename detail::ParallelResultOf<RandomIt, F>::value_type>
+		, typename detail::ParallelResultOf<RandomIt, F>::error_type>
+		parallel_transform(Scheduler& scheduler, RandomIt first, RandomIt last
+			, F&& f, std::size_t grain = 0)
+	{
+		using U = typename detail::ParallelResultOf<RandomIt, F>::value_type;
+		static_assert(!std::is_void_v<U>
+			, "parallel_transform() function should return the value, use parallel_for()");
+		using Body = detail::ParallelForBody<RandomIt, std::decay_t<F>, U>;
+		const auto split = detail::SplitParallelRange(scheduler
+			, static_cast<std::size_t>(std::distance(first, last)), grain);
+		return detail::MakeParallelTask(scheduler, first, split
+			, Body(std::decay_t<F>(std::forward<F>(f))
+				, typename Body::Values(split.size
+					, typename Body::Values::allocator_type(&scheduler.memory_resource()))));
+	}
+
+	// Reduces `map_op(*it)` of every element of [first, last) with
+	// `reduce_op(R, R) -> R`, starting from `identity`. The range is
+	// split as by parallel_for(): every worker reduces its chunks into
+	// own partial result (on its own cache line) and partial results
+	// are combined pairwise once all workers finished.
+	// `reduce_op` should be associative and commutative, chunks are
+	// reduced in any order; `identity` is the start of every worker.
+	// `map_op` returns the value or expected<M, E>: first error fails
+	// returned task. Same as std::transform_reduce(), but as the task
+	//
+	//   auto total = parallel_reduce(scheduler, orders.begin(), orders.end()
+	//       , 0.0, std::plus<>(), [](const Order& o) { return o.price; });
+	template<typename RandomIt, typename R, typename Reduce, typename Map>
+	Task<std::decay_t<R>, typename detail::ParallelResultOf<RandomIt, Map>::error_type>
+		parallel_reduce(Scheduler& scheduler, RandomIt first, RandomIt last
+			, R&& identity, Reduce&& reduce_op, Map&& map_op, std::size_t grain = 0)
+	{
+		using Body = detail::ParallelReduceBody<RandomIt, std::decay_t<R>
+			, std::decay_t<Reduce>, std::decay_t<Map>>;
+		const auto split = detail::SplitParallelRange(scheduler
+			, static_cast<std::size_t>(std::distance(first, last)), grain);
+		return detail::MakeParallelTask(scheduler, first, split
+			, Body(std::decay_t<R>(std::forward<R>(identity))
+				, std::decay_t<Reduce>(std::forward<Reduce>(reduce_op))
+				, std::decay_t<Map>(std::forward<Map>(map_op))
+				, split.workers_count, scheduler.memory_resource()));
+	}
+
+	// Same as parallel_reduce() with `map_op` that returns the element.
+	// Same as std::reduce(), but as the task
+	template<typename RandomIt, typename R, typename Reduce>
+	Task<std::decay_t<R>, void>
+		parallel_reduce(Scheduler& scheduler, RandomIt first, RandomIt last
+			, R&& identity, Reduce&& reduce_op)
+	{
+		return parallel_reduce(scheduler, first, last, std::forward<R>(identity)
+			, std::forward<Reduce>(reduce_op), detail::ParallelIdentity());
+	}
+
+} // namespace nn
@@ -1,42 +1,274 @@
 #pragma once
 #include <rename_me/detail/internal_task.h>
+#include <rename_me/detail/task_queue.h>
+#include <rename_me/detail/task_list.h>
+#include <rename_me/detail/atomic_histogram.h>
+#include <rename_me/detail/threading.h>
+#include <rename_me/scheduler_stats.h>
+#include <rename_me/task_allocator.h>
 
-#include <vector>
 #include <mutex>
-#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
 
 namespace nn
 {
 
+	template<typename T, typename E>
+	class Task;
+
+	// With NN_SINGLE_THREADED (see detail/threading.h) Scheduler
+	// and its tasks should be used from one thread, nothing is thread-safe.
+	// 
+	// Task internals are allocated from the Scheduler's allocator and
+	// are returned there thru the Scheduler: Scheduler should outlive
+	// all Task<> handles (and continuations) of its tasks, even finished
+	// ones. Only ready tasks (see Task<>::make_ready()) have no internals.
+	// Debug build asserts in ~Scheduler() if task internals are alive
 	class Scheduler
 	{
 	public:
+		// Tasks are allocated from own PoolTaskAllocator
 		explicit Scheduler();
-		~Scheduler();
+		// `allocator` should outlive the Scheduler and all its tasks
+		explicit Scheduler(TaskAllocator& allocator);
+		// Tasks are allocated from `resource` (see MemoryResourceTaskAllocator),
+		// that should outlive the Scheduler and all its tasks.
+		// Scheduler makes no other allocations after construction
+		explicit Scheduler(std::pmr::memory_resource& resource);
+		virtual ~Scheduler();
 		Scheduler(Scheduler&& rhs) = delete;
 		Scheduler& operator=(Scheduler&& rhs) = delete;
 		Scheduler(const Scheduler& rhs) = delete;
 		Scheduler& operator=(const Scheduler& rhs) = delete;
 
+		// Only one thread polls at a time. poll() returns 0
+		// immediately if invoked while other thread is polling.
+		// 
+		// Tasks are kept in separate lanes, one per Priority.
+		// poll() ticks all tasks of higher lane before going to lower
+		// one, including tasks that become ready during the poll.
+		// If poll() stops because of `tasks_count` limit, tasks of
+		// lower lanes may be not ticked; lane that was not ticked
+		// for several polls in a row goes first. Next poll resumes
+		// from the task where previous poll stopped
 		std::size_t poll(std::size_t tasks_count = 0);
+		// Same as poll(), but stops once `budget` is spent.
+		// Task's tick() is never interrupted: poll_for() checks the
+		// time after every tick and may overrun the budget by the
+		// duration of single tick(). At least one task is ticked.
+		// Next poll() or poll_for() resumes ticking from the task
+		// where previous poll stopped (round-robin)
+		std::size_t poll_for(std::chrono::nanoseconds budget);
+		BudgetStats budget_stats() const;
+		// Thread-safe snapshot of the counters. Cheap enough
+		// to be scraped periodically: copies ~16KB of histograms
+		SchedulerStats stats() const;
 		std::size_t tasks_count() const;
 		bool has_tasks() const;
+		// Posted (or ready) and not yet finished tasks of the lane.
+		// Tasks that wait for other task or for timer are not counted
+		std::size_t queue_depth(Priority priority) const;
+		TaskAllocator& allocator();
+		// Resource for the containers of tasks and results (e.g.,
+		// std::pmr::vector<Task<T>>), draws from allocator().
+		// Same as resource of the Scheduler, if any
+		std::pmr::memory_resource& memory_resource();
+		// Number of threads that tick tasks at the same time.
+		// Scheduler is ticked by the thread that polls it: 1
+		virtual std::size_t concurrency() const;
+
+		// Blocks calling thread until new task is posted, wake_up() is
+		// called or `timeout` expires. Returns false on timeout.
+		// Returns immediately if there are posted, but not polled tasks.
+		// With NN_SINGLE_THREADED just sleeps for `timeout`
+		// (or until the closest timer) when there is no work
+		bool wait_for_work(std::chrono::nanoseconds timeout);
+		// Thread-safe. Wakes up thread that waits in wait_for_work().
+		// Custom task that knows when it's ready (e.g., on I/O completion)
+		// may call it to be polled without delay
+		void wake_up();
+
+		// Polls until `task` finishes. Instead of busy spinning, sleeps
+		// when tasks are not finished for a while. Tasks that do not
+		// wake_up() the scheduler (e.g., std::future<> wrapper) are
+		// polled with growing interval, but at least once per 1ms
+		template<typename T, typename E>
+		void run_until(const Task<T, E>& task);
+		// Same as run_until(), but polls until there are no tasks
+		void run_until_idle();
+
+	protected:
+		// Customization points for schedulers that tick tasks
+		// in other way then poll() does (see ThreadPoolScheduler).
+		// 
+		// Stores posted task to be ticked later. Thread-safe.
+		// Default implementation keeps task for the next poll()
+		virtual void enqueue(detail::ErasedTask task);
+		// Stores task that became ready while polling: continuation
+		// of the task that just finished on this scheduler or task
+		// which timer expired. Invoked from the polling thread.
+		// Default implementation adds task to the tasks that are polled now
+		virtual void enqueue_ready(detail::ErasedTask task);
+		// Invoked when timer is posted or canceled (see poll_timers()).
+		// Default implementation wakes up wait_for_work()
+		virtual void notify_timers();
+		// True if there are timers posted or canceled since the last
+		// poll_timers(): next_timer() does not know about them yet
+		bool has_posted_timers() const;
+		// Statistics collected by the thread that ticks tasks,
+		// see flush_counters()
+		struct TickCounters
+		{
+			std::uint64_t ticks = 0;
+			std::uint64_t successful = 0;
+			std::uint64_t failed = 0;
+			std::uint64_t canceled = 0;
+		};
+		// Ticks the task (TaskBase::update()) and records statistics
+		Status tick_task(detail::TaskBase& task, TickCounters& counters);
+		// Adds `counters` to the Scheduler's statistics and resets them
+		void flush_counters(TickCounters& counters);
+		// Should be invoked once `task` finishes
+		void finish_task(detail::TaskBase& task);
+		// Should be invoked instead of keeping `task` for the next
+		// tick if the task requested to park (see TaskBase::request_park())
+		void park_task(detail::ErasedTask task);
+		// Passes tasks which timers expired (or were canceled)
+		// to enqueue_ready(). Thread-safe: returns immediately
+		// if other thread handles timers now
+		void poll_timers();
+		// Deadline of the closest timer or time_point::max()
+		std::chrono::steady_clock::time_point next_timer() const;
 
 	private:
 		template<typename T, typename E>
 		friend class Task;
+		friend void detail::CancelTimer(Scheduler& scheduler, detail::TimerNode& timer);
+		friend void detail::PostTask(Scheduler& scheduler, detail::ErasedTask task);
+		friend void detail::PostTaskAfter(Scheduler& scheduler
+			, detail::TaskBase& parent, detail::ErasedTask task);
+		friend void detail::CountWaitingTask(Scheduler& scheduler);
+		friend void detail::PostWaitingTask(Scheduler& scheduler, detail::ErasedTask task);
+		friend void detail::ReleaseWaitingTask(Scheduler& scheduler, detail::ErasedTask task);
+		friend void* detail::AllocateTask(Scheduler& scheduler
+			, std::size_t size, std::size_t alignment);
+		friend void detail::DeallocateTask(Scheduler& scheduler, void* ptr
+			, std::size_t size, std::size_t alignment) noexcept;
+		using Clock = std::chrono::steady_clock;
 
+		static constexpr std::size_t k_lanes = std::size_t(Priority::Low) + 1;
+
+		// Tasks are allocated from `allocator`, if set. Otherwise
+		// from `resource`, if set. Otherwise from `own_allocator`
+		explicit Scheduler(std::unique_ptr<TaskAllocator> own_allocator
+			, TaskAllocator* allocator, std::pmr::memory_resource* resource);
+
+		struct Lane
+		{
+			detail::TaskList tasks;
+			detail::Atomic<std::size_t> depth{0};
+			// Last ticked, but not finished task of the current round.
+			// Tasks after it are not ticked yet. Null if the round
+			// starts from the front of the lane
+			detail::TaskBase* cursor = nullptr;
+			// Number of polls in a row that did not tick any task of the lane
+			std::size_t starved_polls = 0;
+		};
+
+		// Thread-safe, lock-free
 		void post(detail::ErasedTask task);
+		// Posts `task` only when `parent` finishes.
+		// Until then `task` is not polled, but it's counted by tasks_count()
+		void post_after(detail::TaskBase& parent, detail::ErasedTask task);
+		void post_continuations(detail::TaskBase& task);
+		// Posts `task` only when `timer` expires.
+		// Until then `task` is not polled, but it's counted by tasks_count()
+		void post_at(detail::TimerNode& timer, detail::ErasedTask task);
+		void cancel_timer(detail::TimerNode& timer);
+		void make_timer_ready(detail::TimerNode& timer);
+		bool has_posted_work() const;
+		std::uint64_t to_tick(Clock::time_point time) const;
+		std::uint64_t now_tick() const;
+		// Task is about to be enqueued for the poll
+		void count_ready(detail::TaskBase& task);
+		Lane& lane(detail::TaskBase& task);
+		// Moves posted tasks in front of the lanes
+		void take_posted();
+		void record_budget(std::chrono::nanoseconds budget
+			, std::chrono::nanoseconds elapsed, bool out_of_budget);
+		// Implementation of poll() and poll_for(), poll_guard_ is locked
+		std::size_t poll_lanes(std::size_t tasks_count
+			, Clock::time_point deadline, bool& out_of_budget);
 
-		std::vector<detail::ErasedTask> get_tasks();
-		void add_tasks(std::vector<detail::ErasedTask> tasks);
+		// Single step of run_until(): polls or waits for the work
+		// if nothing was finished for last `idle_polls` polls
+		void poll_or_wait(std::size_t& idle_polls);
+		// Wakes up waiting thread, if any
+		void notify_waiting();
 
 	private:
-		std::mutex guard_;
-		std::vector<detail::ErasedTask> tasks_;
-		std::atomic<std::size_t> tasks_count_;
-		std::atomic<std::size_t> tick_tasks_count_;
+		// Goes first: tasks that are destroyed with other members
+		// return memory there
+		std::unique_ptr<TaskAllocator> own_allocator_;
+		MemoryResourceTaskAllocator resource_allocator_;
+		TaskAllocator& allocator_;
+		TaskAllocatorResource memory_resource_;
+		// Submissions from any thread
+		detail::TaskQueue queue_;
+		// Owned by polling thread
+		detail::Mutex poll_guard_;
+		Lane lanes_[k_lanes];
+		// Statistics
+		struct Counters
+		{
+			detail::Atomic<std::uint64_t> successful{0};
+			detail::Atomic<std::uint64_t> failed{0};
+			detail::Atomic<std::uint64_t> canceled{0};
+			detail::Atomic<std::uint64_t> ticks{0};
+			detail::Atomic<std::uint64_t> polls{0};
+			detail::AtomicHistogram ticks_per_poll;
+			detail::AtomicHistogram poll_duration;
+			detail::AtomicHistogram first_tick_latency;
+			detail::AtomicHistogram completion_latency;
+		};
+		Counters counters_;
+		mutable detail::Mutex budget_guard_;
+		BudgetStats budget_stats_;
+		// Posted, but not yet finished tasks
+		detail::Atomic<std::size_t> tasks_count_;
+		detail::Atomic<std::size_t> waiting_tasks_count_;
+#if !defined(NDEBUG)
+		// Allocated and not yet destroyed task internals
+		detail::Atomic<std::size_t> alive_tasks_count_;
+#endif
+		// wait_for_work() support
+#if !(NN_SINGLE_THREADED)
+		std::mutex wait_guard_;
+		std::condition_variable wake_up_;
+#endif
+		detail::Atomic<std::size_t> waiting_threads_count_;
+		bool wake_requested_;
+		// Timers, 1ms tick
+		const Clock::time_point timers_start_;
+		detail::Mutex timers_guard_;
+		detail::TimerWheel timers_;
+		detail::Atomic<detail::TimerNode*> posted_timers_;
+		detail::Atomic<detail::TimerNode*> canceled_timers_;
+		detail::Atomic<std::uint64_t> next_timer_tick_;
 	};
 
+	template<typename T, typename E>
+	void Scheduler::run_until(const Task<T, E>& task)
+	{
+		std::size_t idle_polls = 0;
+		while (task.is_in_progress())
+		{
+			poll_or_wait(idle_polls);
+		}
+	}
+
 } // namespace nn
 
@@ -0,0 +1,200 @@
+#pragma once
+#include <rename_me/custom_task.h>
+#include <rename_me/detail/bits.h>
+
+#include <chrono>
+#include <limits>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace nn
+{
+
+	// Log-linear (HDR-like) histogram of non-negative values.
+	// Values are grouped by the power of two, every group is split
+	// into 8 buckets. Values less then 16 are exact, for others
+	// relative error of the bucket's bounds is less then 12.5%
+	class Histogram
+	{
+	public:
+		static constexpr std::size_t k_sub_bucket_bits = 3;
+		static constexpr std::size_t k_sub_buckets = (std::size_t(1) << k_sub_bucket_bits);
+		static constexpr std::size_t k_buckets =
+			((64 - k_sub_bucket_bits + 1) * k_sub_buckets);
+
+		explicit Histogram();
+
+		void record(std::uint64_t value);
+		// For merging or copying of histograms
+		void add(std::size_t bucket, std::uint64_t count, std::uint64_t sum);
+
+		std::uint64_t count() const;
+		std::uint64_t sum() const;
+		double mean() const;
+		// Upper bound of the bucket where `percentile` (0..100)
+		// of recorded values lie. 0 if there are no values
+		std::uint64_t value_at_percentile(double percentile) const;
+
+		std::uint64_t bucket_count(std::size_t bucket) const;
+		// Range of values [lower, upper] of the bucket
+		static std::uint64_t BucketLowerBound(std::size_t bucket);
+		static std::uint64_t BucketUpperBound(std::size_t bucket);
+		static std::size_t BucketFor(std::uint64_t value);
+
+	private:
+		std::uint64_t counts_[k_buckets];
+		std::uint64_t count_;
+		std::uint64_t sum_;
+	};
+
+	// Statistics of Scheduler::poll_for() calls
+	struct BudgetStats
+	{
+		std::size_t polls = 0;
+		// Polls that stopped because budget was spent
+		std::size_t exhausted = 0;
+		// Polls that took longer then budget (e.g., because of long tick())
+		std::size_t overruns = 0;
+		std::chrono::nanoseconds last_overrun{0};
+		std::chrono::nanoseconds max_overrun{0};
+		std::chrono::nanoseconds total_overrun{0};
+	};
+
+	// Snapshot of Scheduler's counters, see Scheduler::stats().
+	// Counters are cumulative since Scheduler's creation.
+	// Snapshot is not atomic: counters of the tasks that are ticked
+	// by other thread now may be added later
+	struct SchedulerStats
+	{
+		// Histograms are recorded for one of this number
+		// of tasks or polls (sampled), counters are exact
+		static constexpr std::uint32_t k_latency_sample_period = 16;
+
+		// Tasks that became ready to be ticked: posted tasks,
+		// continuations and tasks which timer expired
+		std::uint64_t posted = 0;
+		std::uint64_t successful = 0;
+		std::uint64_t failed = 0;
+		std::uint64_t canceled = 0;
+		std::uint64_t ticks = 0;
+		// Calls of poll() and poll_for(). ThreadPoolScheduler's
+		// workers tick tasks without polls
+		std::uint64_t polls = 0;
+
+		// Current values, same as tasks_count() and queue_depth()
+		std::size_t tasks_count = 0;
+		std::size_t queue_depth[std::size_t(Priority::Low) + 1] = {};
+
+		// Number of ticks per poll, polls without ticks are not recorded.
+		Histogram ticks_per_poll;
+		// Nanoseconds from the first to the last tick of the poll
+		Histogram poll_duration;
+		// Nanoseconds from the time task became ready to its first tick
+		Histogram first_tick_latency;
+		// Nanoseconds from task's post (or on_finish()) to its finish
+		Histogram completion_latency;
+
+		BudgetStats budget;
+
+		std::uint64_t finished() const
+		{
+			return (successful + failed + canceled);
+		}
+	};
+
+	/*explicit*/ inline Histogram::Histogram()
+		: counts_()
+		, count_(0)
+		, sum_(0)
+	{
+	}
+
+	/*static*/ inline std::size_t Histogram::BucketFor(std::uint64_t value)
+	{
+		if (value < (2 * k_sub_buckets))
+		{
+			return static_cast<std::size_t>(value);
+		}
+		const std::size_t highest_bit = detail::HighestBit(value);
+		const std::size_t shift = (highest_bit - k_sub_bucket_bits);
+		const std::size_t sub_bucket = static_cast<std::size_t>(
+			(value >> shift) & (k_sub_buckets - 1));
+		return (((shift + 1) * k_sub_buckets) + sub_bucket);
+	}
+
+	/*static*/ inline std::uint64_t Histogram::BucketLowerBound(std::size_t bucket)
+	{
+		if (bucket < (2 * k_sub_buckets))
+		{
+			return bucket;
+		}
+		const std::size_t shift = ((bucket / k_sub_buckets) - 1);
+		const std::uint64_t sub_bucket = (bucket % k_sub_buckets);
+		return ((k_sub_buckets + sub_bucket) << shift);
+	}
+
+	/*static*/ inline std::uint64_t Histogram::BucketUpperBound(std::size_t bucket)
+	{
+		if ((bucket + 1) >= k_buckets)
+		{
+			return std::numeric_limits<std::uint64_t>::max();
+		}
+		return (BucketLowerBound(bucket + 1) - 1);
+	}
+
+	inline void Histogram::record(std::uint64_t value)
+	{
+		add(BucketFor(value), 1, value);
+	}
+
+	inline void Histogram::add(std::size_t bucket, std::uint64_t count, std::uint64_t sum)
+	{
+		counts_[bucket] += count;
+		count_ += count;
+		sum_ += sum;
+	}
+
+	inline std::uint64_t Histogram::count() const
+	{
+		return count_;
+	}
+
+	inline std::uint64_t Histogram::sum() const
+	{
+		return sum_;
+	}
+
+	inline double Histogram::mean() const
+	{
+		return ((count_ == 0) ? 0.0
+			: (static_cast<double>(sum_) / static_cast<double>(count_)));
+	}
+
+	inline std::uint64_t Histogram::bucket_count(std::size_t bucket) const
+	{
+		return counts_[bucket];
+	}
+
+	inline std::uint64_t Histogram::value_at_percentile(double percentile) const
+	{
+		if (count_ == 0)
+		{
+			return 0;
+		}
+		std::uint64_t rank = static_cast<std::uint64_t>(
+			(percentile / 100.0) * static_cast<double>(count_) + 0.5);
+		rank = ((rank == 0) ? 1 : ((rank > count_) ? count_ : rank));
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < k_buckets; ++i)
+		{
+			seen += counts_[i];
+			if (seen >= rank)
+			{
+				return BucketUpperBound(i);
+			}
+		}
+		return BucketUpperBound(k_buckets - 1);
+	}
+
+} // namespace nn
@@ -0,0 +1,720 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/scheduler.h>
+#include <rename_me/detail/stream_task_base.h>
+#include <rename_me/detail/threading.h>
+
+#include <vector>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <type_traits>
+
+#include <cstddef>
+#include <cassert>
+
+namespace nn
+{
+
+	template<typename T, typename E>
+	class StreamTask;
+
+	// Passed to the source of the StreamTask on every tick
+	template<typename T, typename E = void>
+	class StreamWriter
+	{
+	public:
+		void push(T value);
+		// How many items can be pushed before the stream's buffer
+		// is full. Source may push more, it's not invoked while
+		// the buffer is full (see StreamTask about parking)
+		std::size_t room() const;
+		// Sets the error of the stream (default one if E is not
+		// given). Returns Status::Failed, to return from the source:
+		//   return writer.fail(error);
+		template<typename... Error>
+		Status fail(Error&&... error);
+
+	protected:
+		explicit StreamWriter(Scheduler& scheduler, std::size_t capacity);
+		~StreamWriter() = default;
+
+	protected:
+		// Items pushed on the current tick.
+		// Touched only by the source's tick
+		std::pmr::vector<T> written_;
+		std::size_t capacity_;
+		// Capacity minus buffered items on the start of the tick
+		std::size_t room_;
+		expected<void, E> data_;
+	};
+
+	namespace detail
+	{
+
+		// Buffer and consumers of the StreamTask. Lives in the
+		// task of the source: allocated once for the stream
+		template<typename T, typename E>
+		class StreamState : public StreamWriter<T, E>
+		{
+		public:
+			explicit StreamState(Scheduler& scheduler, std::size_t capacity);
+			// Releases receivers, if the source did not finish
+			~StreamState();
+
+			// Invoked on the source's tick, returns false if the
+			// source should not be invoked: buffer is full.
+			// The task is parked until consumer takes items
+			bool begin_tick();
+			// Gives items of the tick (and buffered ones) to waiting
+			// receivers, the rest - to the sink or to the buffer.
+			// Fails waiting receivers if `status` is finish status
+			void end_tick(Status status);
+			// Invoked by the sink once the source finishes
+			// to take items the source did not deliver
+			void drain();
+			// True if try_cancel() was requested for the sink
+			bool is_sink_canceled() const;
+
+		private:
+			template<typename, typename>
+			friend class nn::StreamTask;
+			using Receiver = StreamReceiver<T>;
+			using Lock = std::unique_lock<Mutex>;
+
+			std::size_t buffered() const;
+			// Moves items of the `sink_` to the `written_`
+			void take_for_sink();
+			// Drops taken items from the front of the buffer
+			void compact();
+			void push_receiver(Receiver& receiver);
+			Receiver* pop_receiver();
+			void post(Receiver* receivers);
+
+		private:
+			Scheduler& scheduler_;
+			// Task of the source. Parked while the buffer is full
+			TaskBase* source_task_;
+			mutable Mutex guard_;
+			// Buffered items are [head_, items_.size())
+			std::pmr::vector<T> items_;
+			std::size_t head_;
+			bool finished_;
+			// Non-empty only if nothing is buffered
+			Receiver* receivers_head_;
+			Receiver* receivers_tail_;
+			// Set by for_each(). Alive while the source is in progress
+			// (posted after the source, see PostTaskAfter())
+			StreamSink<T>* sink_;
+			Atomic<TaskBase*> sink_task_;
+		};
+
+		// F is Status (StreamWriter<T, E>&)
+		template<typename T, typename E, typename F>
+		class StreamSourceTask : public StreamState<T, E>
+		{
+		public:
+			using State = StreamState<T, E>;
+
+			explicit StreamSourceTask(Scheduler& scheduler, std::size_t capacity, F source)
+				: State(scheduler, capacity)
+				, source_(std::move(source))
+			{
+			}
+
+			Status tick(const ExecutionContext& context)
+			{
+				Status status = Status::InProgress;
+				if (context.cancel_requested || State::is_sink_canceled())
+				{
+					status = Status::Canceled;
+				}
+				else if (State::begin_tick())
+				{
+					status = source_(static_cast<StreamWriter<T, E>&>(*this));
+				}
+				State::end_tick(status);
+				return status;
+			}
+
+			expected<void, E>& get()
+			{
+				return State::data_;
+			}
+
+		private:
+			F source_;
+		};
+
+		// Posted once the source finishes. Until then,
+		// `f` is invoked with the items on the source's tick
+		template<typename T, typename E, typename F>
+		class StreamForEachTask final : public StreamSink<T>
+		{
+		public:
+			explicit StreamForEachTask(StreamState<T, E>& state, Task<void, E> stream, F f)
+				: state_(state)
+				, stream_(std::move(stream))
+				, f_(std::move(f))
+				, data_(MakeExpectedWithDefaultError<expected<void, E>>())
+			{
+			}
+
+			virtual void consume(T* first, T* last) override
+			{
+				for (; first != last; ++first)
+				{
+					f_(std::move(*first));
+				}
+			}
+
+			Status tick(const ExecutionContext&)
+			{
+				assert(stream_.is_finished());
+				state_.drain();
+				const Status status = stream_.status();
+				if (status == Status::Successful)
+				{
+					data_ = expected<void, E>();
+				}
+				else
+				{
+					data_ = std::move(stream_).get();
+				}
+				return status;
+			}
+
+			expected<void, E>& get()
+			{
+				return data_;
+			}
+
+		private:
+			StreamState<T, E>& state_;
+			Task<void, E> stream_;
+			F f_;
+			expected<void, E> data_;
+		};
+
+	} // namespace detail
+
+	// Task that yields many items: the source (F) is ticked by the
+	// scheduler as any other task and pushes items to the StreamWriter
+	// until it returns finish status. Items are buffered inside
+	// the stream (up to `capacity`) and are consumed with:
+	//  (1) next() - ready task (nothing is allocated and posted)
+	//      if there are buffered items; otherwise the task that waits
+	//      for the source's tick. Fails once the stream ends.
+	//  (2) next_many() - same as next(), but takes up to `count` items
+	//      (up to `count` items of the source's tick for the waiting task).
+	//  (3) for_each() - `f` is invoked for every item on the source's
+	//      tick; single task for the whole stream.
+	// Only the source and the waiting next() tasks are allocated:
+	// consumers that keep up with the source (for_each(), or next_many()
+	// called from the continuation) cost O(1) allocations per stream,
+	// not per item.
+	// Waiting next() tasks are completed by the source, try_cancel()
+	// of them has no effect; try_cancel() the stream instead.
+	// Until completed, they are counted by Scheduler::tasks_count().
+	// Thread-safe: next() can be invoked from any thread.
+	// While the buffer is full, the source's task is parked (as Channel
+	// parks senders): it's not polled, but it's counted by
+	// Scheduler::tasks_count(), and is posted again once consumer
+	// takes items (or try_cancel() is invoked)
+	//
+	//   auto rows = StreamTask<Row>::make(scheduler, [&](StreamWriter<Row>& out)
+	//   {
+	//       while (file.has_row()) { out.push(file.read_row()); }
+	//       return (file.eof() ? Status::Successful : Status::InProgress);
+	//   });
+	//   std::move(rows).for_each([](Row row) { ... });
+	template<typename T, typename E = void>
+	class StreamTask
+	{
+	public:
+		static constexpr std::size_t k_default_capacity = 1024;
+
+		// `source` is Status (StreamWriter<T, E>&): returns
+		// Status::InProgress to be ticked again, other status
+		// ends the stream
+		template<typename F>
+		static StreamTask make(Scheduler& scheduler, F&& source
+			, std::size_t capacity = k_default_capacity);
+
+		explicit StreamTask();
+		StreamTask(StreamTask&& rhs) noexcept;
+		StreamTask& operator=(StreamTask&& rhs) noexcept;
+		StreamTask(const StreamTask& rhs) = delete;
+		StreamTask& operator=(const StreamTask& rhs) = delete;
+
+		// Takes the next item. Fails if the stream ended
+		// and nothing is buffered
+		Task<T, E> next();
+		// Same as next(), but takes up to `count` items at once
+		Task<std::vector<T>, E> next_many(std::size_t count);
+		// Invokes `f` (void (T&&)) for every item, buffered ones first.
+		// Returned task finishes with the status (and error) of the
+		// stream once all items are consumed.
+		// The StreamTask is empty (!is_valid()) after
+		template<typename F>
+		Task<void, E> for_each(F&& f) &&;
+
+		// Cancels the source. Waiting next() tasks fail
+		void try_cancel();
+		// Status of the source: InProgress until the stream ends.
+		// Buffered items still can be taken after
+		Status status() const;
+		bool is_in_progress() const;
+		// Result of the source. See Task::get()
+		expected<void, E>& get() const &;
+		// Buffered items
+		std::size_t size() const;
+
+		Scheduler& scheduler() const;
+		bool is_valid() const;
+
+	private:
+		using State = detail::StreamState<T, E>;
+
+		explicit StreamTask(Task<void, E> stream, State& state);
+
+		template<typename Value>
+		Task<Value, E> receive(std::size_t count);
+
+	private:
+		Task<void, E> stream_;
+		State* state_;
+	};
+
+	template<typename T, typename E>
+	/*explicit*/ StreamWriter<T, E>::StreamWriter(Scheduler& scheduler, std::size_t capacity)
+		: written_(&scheduler.memory_resource())
+		, capacity_(capacity)
+		, room_(capacity)
+		, data_(MakeExpectedWithDefaultError<expected<void, E>>())
+	{
+		assert((capacity > 0) && "Stream should buffer at least one item");
+	}
+
+	template<typename T, typename E>
+	void StreamWriter<T, E>::push(T value)
+	{
+		written_.push_back(std::move(value));
+	}
+
+	template<typename T, typename E>
+	std::size_t StreamWriter<T, E>::room() const
+	{
+		return ((room_ > written_.size()) ? (room_ - written_.size()) : 0);
+	}
+
+	template<typename T, typename E>
+	template<typename... Error>
+	Status StreamWriter<T, E>::fail(Error&&... error)
+	{
+		static_assert(sizeof...(Error) <= 1, "Expecting single error");
+		if constexpr (sizeof...(Error) == 0)
+		{
+			data_ = MakeExpectedWithDefaultError<expected<void, E>>();
+		}
+		else
+		{
+			data_ = expected<void, E>(unexpected<E>(E(std::forward<Error>(error)...)));
+		}
+		return Status::Failed;
+	}
+
+	namespace detail
+	{
+
+		template<typename T, typename E>
+		/*explicit*/ StreamState<T, E>::StreamState(Scheduler& scheduler, std::size_t capacity)
+			: StreamWriter<T, E>(scheduler, capacity)
+			, scheduler_(scheduler)
+			, source_task_(nullptr)
+			, guard_()
+			, items_(&scheduler.memory_resource())
+			, head_(0)
+			, finished_(false)
+			, receivers_head_(nullptr)
+			, receivers_tail_(nullptr)
+			, sink_(nullptr)
+			, sink_task_(nullptr)
+		{
+		}
+
+		template<typename T, typename E>
+		StreamState<T, E>::~StreamState()
+		{
+			while (Receiver* receiver = pop_receiver())
+			{
+				ReleaseWaitingTask(scheduler_, ErasedTask::attach(receiver->task()));
+			}
+		}
+
+		template<typename T, typename E>
+		bool StreamState<T, E>::begin_tick()
+		{
+			Lock lock(guard_);
+			const std::size_t count = buffered();
+			this->room_ = ((this->capacity_ > count) ? (this->capacity_ - count) : 0);
+			if (this->room_ == 0)
+			{
+				// Under the lock: receive() that takes items
+				// after that sees the park request
+				source_task_->request_park();
+				return false;
+			}
+			return true;
+		}
+
+		template<typename T, typename E>
+		void StreamState<T, E>::end_tick(Status status)
+		{
+			if (status == Status::Successful)
+			{
+				this->data_ = expected<void, E>();
+			}
+			else if (status == Status::Canceled)
+			{
+				this->data_ = MakeExpectedWithDefaultError<expected<void, E>>();
+			}
+
+			std::pmr::vector<T>& written = this->written_;
+			Receiver* ready = nullptr;
+			Receiver* ready_tail = nullptr;
+			StreamSink<T>* sink = nullptr;
+			{
+				Lock lock(guard_);
+				if (items_.empty())
+				{
+					items_.swap(written);
+				}
+				else
+				{
+					for (T& item : written)
+					{
+						items_.push_back(std::move(item));
+					}
+					written.clear();
+				}
+				while ((head_ < items_.size()) && receivers_head_)
+				{
+					Receiver* receiver = pop_receiver();
+					head_ += receiver->take(items_.data() + head_, items_.data() + items_.size());
+					if (ready_tail)
+					{
+						ready_tail->set_next(receiver);
+					}
+					else
+					{
+						ready = receiver;
+					}
+					ready_tail = receiver;
+				}
+				if (sink_ && (head_ < items_.size()))
+				{
+					take_for_sink();
+					sink = sink_;
+				}
+				compact();
+				if (status != Status::InProgress)
+				{
+					finished_ = true;
+					// Without items: tasks fail once ticked
+					if (ready_tail)
+					{
+						ready_tail->set_next(receivers_head_);
+					}
+					else
+					{
+						ready = receivers_head_;
+					}
+					receivers_head_ = nullptr;
+					receivers_tail_ = nullptr;
+				}
+			}
+			if (sink)
+			{
+				sink->consume(written.data(), written.data() + written.size());
+				written.clear();
+			}
+			post(ready);
+		}
+
+		template<typename T, typename E>
+		void StreamState<T, E>::drain()
+		{
+			StreamSink<T>* sink = nullptr;
+			{
+				Lock lock(guard_);
+				assert(finished_);
+				if (sink_ && (head_ < items_.size()))
+				{
+					take_for_sink();
+					sink = sink_;
+				}
+			}
+			if (sink)
+			{
+				std::pmr::vector<T>& written = this->written_;
+				sink->consume(written.data(), written.data() + written.size());
+				written.clear();
+			}
+		}
+
+		template<typename T, typename E>
+		bool StreamState<T, E>::is_sink_canceled() const
+		{
+			TaskBase* sink = sink_task_.load(std::memory_order_acquire);
+			return (sink && sink->cancel_requested());
+		}
+
+		template<typename T, typename E>
+		std::size_t StreamState<T, E>::buffered() const
+		{
+			return (items_.size() - head_);
+		}
+
+		template<typename T, typename E>
+		void StreamState<T, E>::take_for_sink()
+		{
+			// Invoked under the lock
+			std::pmr::vector<T>& written = this->written_;
+			assert(written.empty());
+			if (head_ > 0)
+			{
+				items_.erase(items_.begin(), items_.begin() + head_);
+				head_ = 0;
+			}
+			items_.swap(written);
+		}
+
+		template<typename T, typename E>
+		void StreamState<T, E>::compact()
+		{
+			if (head_ == items_.size())
+			{
+				items_.clear();
+				head_ = 0;
+			}
+			else if (head_ > (items_.size() / 2))
+			{
+				items_.erase(items_.begin(), items_.begin() + head_);
+				head_ = 0;
+			}
+		}
+
+		template<typename T, typename E>
+		void StreamState<T, E>::push_receiver(Receiver& receiver)
+		{
+			assert(!receiver.next());
+			if (receivers_tail_)
+			{
+				receivers_tail_->set_next(&receiver);
+			}
+			else
+			{
+				receivers_head_ = &receiver;
+			}
+			receivers_tail_ = &receiver;
+		}
+
+		template<typename T, typename E>
+		typename StreamState<T, E>::Receiver* StreamState<T, E>::pop_receiver()
+		{
+			Receiver* receiver = receivers_head_;
+			if (!receiver)
+			{
+				return nullptr;
+			}
+			receivers_head_ = receiver->next();
+			if (!receivers_head_)
+			{
+				receivers_tail_ = nullptr;
+			}
+			receiver->set_next(nullptr);
+			return receiver;
+		}
+
+		template<typename T, typename E>
+		void StreamState<T, E>::post(Receiver* receivers)
+		{
+			while (receivers)
+			{
+				Receiver* next = receivers->next();
+				receivers->set_next(nullptr);
+				// Reference is owned by the stream while receiver waits
+				PostWaitingTask(scheduler_, ErasedTask::attach(receivers->task()));
+				receivers = next;
+			}
+		}
+
+	} // namespace detail
+
+	template<typename T, typename E>
+	template<typename F>
+	/*static*/ StreamTask<T, E> StreamTask<T, E>::make(Scheduler& scheduler, F&& source
+		, std::size_t capacity /*= k_default_capacity*/)
+	{
+		using Source = detail::StreamSourceTask<T, E, std::decay_t<F>>;
+		using FullTask = detail::InternalCustomTask<void, E, Source>;
+		auto task = FullTask::Make(scheduler, scheduler, capacity, std::forward<F>(source));
+		State& state = task->task();
+		state.source_task_ = task.get();
+		detail::PostTask(scheduler, task.template to_base<detail::TaskBase>());
+		return StreamTask(Task<void, E>(task.template to_base<detail::InternalTask<void, E>>()), state);
+	}
+
+	template<typename T, typename E>
+	/*explicit*/ StreamTask<T, E>::StreamTask()
+		: stream_()
+		, state_(nullptr)
+	{
+	}
+
+	template<typename T, typename E>
+	/*explicit*/ StreamTask<T, E>::StreamTask(Task<void, E> stream, State& state)
+		: stream_(std::move(stream))
+		, state_(&state)
+	{
+	}
+
+	template<typename T, typename E>
+	StreamTask<T, E>::StreamTask(StreamTask&& rhs) noexcept
+		: stream_(std::move(rhs.stream_))
+		, state_(std::exchange(rhs.state_, nullptr))
+	{
+	}
+
+	template<typename T, typename E>
+	StreamTask<T, E>& StreamTask<T, E>::operator=(StreamTask&& rhs) noexcept
+	{
+		if (this != &rhs)
+		{
+			stream_ = std::move(rhs.stream_);
+			state_ = std::exchange(rhs.state_, nullptr);
+		}
+		return *this;
+	}
+
+	template<typename T, typename E>
+	Task<T, E> StreamTask<T, E>::next()
+	{
+		return receive<T>(1);
+	}
+
+	template<typename T, typename E>
+	Task<std::vector<T>, E> StreamTask<T, E>::next_many(std::size_t count)
+	{
+		assert(count > 0);
+		return receive<std::vector<T>>(count);
+	}
+
+	template<typename T, typename E>
+	template<typename Value>
+	Task<Value, E> StreamTask<T, E>::receive(std::size_t count)
+	{
+		assert(is_valid());
+		using ReceiveTask = detail::StreamReceiveTask<T, E, Value>;
+		Scheduler& scheduler = stream_.scheduler();
+		State& state = *state_;
+		typename State::Lock lock(state.guard_);
+		if (state.buffered() > 0)
+		{
+			const bool was_full = (state.buffered() >= state.capacity_);
+			ReceiveTask ready(count);
+			state.head_ += ready.take(state.items_.data() + state.head_
+				, state.items_.data() + state.items_.size());
+			state.compact();
+			lock.unlock();
+			if (was_full)
+			{
+				// There is a room now
+				state.source_task_->unpark();
+			}
+			return Task<Value, E>::make_ready(scheduler, std::move(ready.get()));
+		}
+		if (state.finished_)
+		{
+			return Task<Value, E>::make_ready(scheduler
+				, MakeExpectedWithDefaultError<expected<Value, E>>());
+		}
+		using FullTask = detail::InternalCustomTask<Value, E, ReceiveTask>;
+		auto task = FullTask::Make(scheduler, count);
+		typename State::Receiver& receiver = task->task();
+		receiver.set_task(task.template to_base<detail::TaskBase>().detach());
+		detail::CountWaitingTask(scheduler);
+		state.push_receiver(receiver);
+		return Task<Value, E>(task.template to_base<detail::InternalTask<Value, E>>());
+	}
+
+	template<typename T, typename E>
+	template<typename F>
+	Task<void, E> StreamTask<T, E>::for_each(F&& f) &&
+	{
+		assert(is_valid());
+		using Sink = detail::StreamForEachTask<T, E, std::decay_t<F>>;
+		using FullTask = detail::InternalCustomTask<void, E, Sink>;
+		Scheduler& scheduler = stream_.scheduler();
+		State& state = *std::exchange(state_, nullptr);
+		detail::TaskBase& source = *stream_.task_;
+		auto task = FullTask::Make(scheduler, state, std::move(stream_), std::forward<F>(f));
+		task->set_priority(source.priority());
+		{
+			typename State::Lock lock(state.guard_);
+			assert(!state.sink_ && "for_each() is invoked once");
+			state.sink_ = &task->task();
+		}
+		state.sink_task_.store(task.get(), std::memory_order_release);
+		// Sink takes all items on the source's tick
+		source.unpark();
+		detail::PostTaskAfter(scheduler, source, task.template to_base<detail::TaskBase>());
+		return Task<void, E>(task.template to_base<detail::InternalTask<void, E>>());
+	}
+
+	template<typename T, typename E>
+	void StreamTask<T, E>::try_cancel()
+	{
+		stream_.try_cancel();
+	}
+
+	template<typename T, typename E>
+	Status StreamTask<T, E>::status() const
+	{
+		return stream_.status();
+	}
+
+	template<typename T, typename E>
+	bool StreamTask<T, E>::is_in_progress() const
+	{
+		return stream_.is_in_progress();
+	}
+
+	template<typename T, typename E>
+	expected<void, E>& StreamTask<T, E>::get() const &
+	{
+		return stream_.get();
+	}
+
+	template<typename T, typename E>
+	std::size_t StreamTask<T, E>::size() const
+	{
+		assert(is_valid());
+		typename State::Lock lock(state_->guard_);
+		return state_->buffered();
+	}
+
+	template<typename T, typename E>
+	Scheduler& StreamTask<T, E>::scheduler() const
+	{
+		return stream_.scheduler();
+	}
+
+	template<typename T, typename E>
+	bool StreamTask<T, E>::is_valid() const
+	{
+		return (state_ != nullptr);
+	}
+
+} // namespace nn
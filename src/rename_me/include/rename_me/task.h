@@ -5,6 +5,7 @@
 #include <rename_me/detail/function_task_base.h>
 
 #include <type_traits>
+#include <optional>
 
 #include <cassert>
 
@@ -13,6 +14,17 @@ namespace nn
 
 	class Scheduler;
 
+	template<typename T>
+	class Channel;
+
+	template<typename T, typename E>
+	class StreamTask;
+
+	namespace detail
+	{
+		class WhenLatch;
+	} // namespace detail
+
 	template<typename>
 	struct is_task;
 
@@ -34,6 +46,11 @@ namespace nn
 
 		template<typename OtherT, typename OtherE>
 		friend class Task;
+		friend class detail::WhenLatch;
+		template<typename>
+		friend class Channel;
+		template<typename, typename>
+		friend class StreamTask;
 
 	public:
 		using value_type = T;
@@ -45,6 +62,26 @@ namespace nn
 		static
 			typename std::enable_if<IsCustomTask<CustomTask, T, E>::value, Task>::type
 				make(Scheduler& scheduler, Args&&... args);
+		// Same as make(), but task is ticked in the lane of given `priority`.
+		// Tasks created by make() have Priority::Normal.
+		// Continuations (see on_finish()) inherit priority of the parent task
+		template<typename CustomTask, typename... Args>
+		static
+			typename std::enable_if<IsCustomTask<CustomTask, T, E>::value, Task>::type
+				make(Priority priority, Scheduler& scheduler, Args&&... args);
+		// Finished task that keeps `value` inline: nothing is allocated
+		// and posted to the `scheduler`. Task is successful or failed
+		// depending on `value` (see make_task(success, ...)).
+		// on_finish() of such task with the same scheduler invokes
+		// the functor immediately, on the calling thread, only if it's
+		// invoked from the tick of other task of this scheduler (and
+		// the stack is not too deep already, see
+		// detail::EnterInlineContinuation()). Otherwise, if the value
+		// is cheap to copy (trivially copyable and small), continuation
+		// is posted with own copy of it: only the continuation is
+		// allocated. Other values are moved to the task internals,
+		// allocated once, to be shared with all continuations
+		static Task make_ready(Scheduler& scheduler, value v);
 		explicit Task();
 		~Task();
 		Task(Task&& rhs) noexcept;
@@ -81,6 +118,7 @@ namespace nn
 		bool is_successful() const;
 
 		Scheduler& scheduler() const;
+		Priority priority() const;
 
 		// Let's R = f(*this). If R is:
 		//  1. Task<U, O> then returns Task<U, O>.
@@ -157,6 +195,24 @@ namespace nn
 
 	private:
 		explicit Task(InternalTask task);
+		explicit Task(Scheduler& scheduler, Status status, value&& v);
+
+		bool is_ready() const;
+		// Moves inline value of ready task to task internals
+		void make_internal();
+
+		template<typename FullTask>
+		static void post(Scheduler& scheduler
+			, detail::RefCountPtr<FullTask>& task, std::false_type /*has timer*/);
+		template<typename FullTask>
+		static void post(Scheduler& scheduler
+			, detail::RefCountPtr<FullTask>& task, std::true_type /*has timer*/);
+
+		// Same as make(), but created task is posted to the scheduler
+		// only when `parent` finishes
+		template<typename CustomTask, typename... Args>
+		static Task make_after(detail::TaskBase& parent
+			, Scheduler& scheduler, Args&&... args);
 
 		template<typename F, typename CallPredicate
 			, typename ReturnWithTaskArg = detail::FunctionTaskReturn<F, const Task<T, E>&>
@@ -167,11 +223,19 @@ namespace nn
 		static decltype(auto) invoke(std::false_type, F& f, const Task&);
 		template<typename F>
 		static decltype(auto) invoke(std::true_type, F& f, const Task& self);
+		template<typename Return, typename F>
+		static auto invoke_ready(std::false_type, Scheduler& scheduler, F&& f, const Task&);
+		template<typename Return, typename F>
+		static auto invoke_ready(std::true_type, Scheduler& scheduler, F&& f, const Task& self);
 
 		void remove();
 
 	private:
 		InternalTask task_;
+		// Ready task (see make_ready()) has no internals
+		Scheduler* ready_scheduler_;
+		Status ready_status_;
+		mutable std::optional<value> ready_;
 	};
 
 } // namespace nn
@@ -189,7 +253,43 @@ namespace nn
 	template<typename T, typename E>
 	/*explicit*/ Task<T, E>::Task(InternalTask task)
 		: task_(std::move(task))
+		, ready_scheduler_(nullptr)
+		, ready_status_(Status::InProgress)
+		, ready_()
+	{
+	}
+
+	template<typename T, typename E>
+	/*explicit*/ Task<T, E>::Task(Scheduler& scheduler, Status status, value&& v)
+		: task_()
+		, ready_scheduler_(&scheduler)
+		, ready_status_(status)
+		, ready_(std::in_place, std::move(v))
+	{
+		assert(status != Status::InProgress);
+	}
+
+	template<typename T, typename E>
+	/*static*/ Task<T, E> Task<T, E>::make_ready(Scheduler& scheduler, value v)
+	{
+		const Status status = (v.has_value() ? Status::Successful : Status::Failed);
+		return Task(scheduler, status, std::move(v));
+	}
+
+	template<typename T, typename E>
+	bool Task<T, E>::is_ready() const
+	{
+		return (ready_scheduler_ != nullptr);
+	}
+
+	template<typename T, typename E>
+	void Task<T, E>::make_internal()
 	{
+		assert(is_ready());
+		using FullTask = detail::InternalCustomTask<T, E, detail::NoopTask<T, E>>;
+		auto full_task = FullTask::Make(*ready_scheduler_, ready_status_, std::move(*ready_));
+		remove();
+		task_ = full_task.template to_base<typename InternalTask::type>();
 	}
 
 	template<typename T, typename E>
@@ -197,13 +297,54 @@ namespace nn
 	/*static*/
 		typename std::enable_if<IsCustomTask<CustomTask, T, E>::value, Task<T, E>>::type
 			Task<T, E>::make(Scheduler& scheduler, Args&&... args)
+	{
+		return make<CustomTask>(Priority::Normal, scheduler, std::forward<Args>(args)...);
+	}
+
+	template<typename T, typename E>
+	template<typename CustomTask, typename... Args>
+	/*static*/
+		typename std::enable_if<IsCustomTask<CustomTask, T, E>::value, Task<T, E>>::type
+			Task<T, E>::make(Priority priority, Scheduler& scheduler, Args&&... args)
+	{
+		using FullTask = detail::InternalCustomTask<T, E, CustomTask>;
+		auto full_task = FullTask::Make(scheduler, std::forward<Args>(args)...);
+		full_task->set_priority(priority);
+		if (full_task->status() == Status::InProgress)
+		{
+			post(scheduler, full_task, HasTimer<CustomTask>());
+		}
+		return Task(full_task.template to_base<typename InternalTask::type>());
+	}
+
+	template<typename T, typename E>
+	template<typename FullTask>
+	/*static*/ void Task<T, E>::post(Scheduler& scheduler
+		, detail::RefCountPtr<FullTask>& task, std::false_type /*has timer*/)
+	{
+		scheduler.post(task.template to_base<detail::TaskBase>());
+	}
+
+	template<typename T, typename E>
+	template<typename FullTask>
+	/*static*/ void Task<T, E>::post(Scheduler& scheduler
+		, detail::RefCountPtr<FullTask>& task, std::true_type /*has timer*/)
+	{
+		scheduler.post_at(task->task().timer()
+			, task.template to_base<detail::TaskBase>());
+	}
+
+	template<typename T, typename E>
+	template<typename CustomTask, typename... Args>
+	/*static*/ Task<T, E> Task<T, E>::make_after(detail::TaskBase& parent
+		, Scheduler& scheduler, Args&&... args)
 	{
 		using FullTask = detail::InternalCustomTask<T, E, CustomTask>;
-		auto full_task = detail::RefCountPtr<FullTask>::make(
-			scheduler, std::forward<Args>(args)...);
+		auto full_task = FullTask::Make(scheduler, std::forward<Args>(args)...);
+		full_task->set_priority(parent.priority());
 		if (full_task->status() == Status::InProgress)
 		{
-			scheduler.post(full_task.template to_base<detail::TaskBase>());
+			scheduler.post_after(parent, full_task.template to_base<detail::TaskBase>());
 		}
 		return Task(full_task.template to_base<typename InternalTask::type>());
 	}
@@ -211,13 +352,16 @@ namespace nn
 	template<typename T, typename E>
 	/*explicit*/ Task<T, E>::Task()
 		: task_()
+		, ready_scheduler_(nullptr)
+		, ready_status_(Status::InProgress)
+		, ready_()
 	{
 	}
 
 	template<typename T, typename E>
 	bool Task<T, E>::is_valid() const
 	{
-		return task_.operator bool();
+		return (task_ || is_ready());
 	}
 
 	template<typename T, typename E>
@@ -230,13 +374,19 @@ namespace nn
 	void Task<T, E>::remove()
 	{
 		task_ = nullptr;
+		ready_scheduler_ = nullptr;
+		ready_status_ = Status::InProgress;
+		ready_.reset();
 	}
 
 	template<typename T, typename E>
 	Task<T, E>::Task(Task&& rhs) noexcept
-		: task_(rhs.task_)
+		: task_(std::move(rhs.task_))
+		, ready_scheduler_(rhs.ready_scheduler_)
+		, ready_status_(rhs.ready_status_)
+		, ready_(std::move(rhs.ready_))
 	{
-		rhs.task_ = nullptr;
+		rhs.remove();
 	}
 
 	template<typename T, typename E>
@@ -246,6 +396,13 @@ namespace nn
 		{
 			remove();
 			std::swap(task_, rhs.task_);
+			std::swap(ready_scheduler_, rhs.ready_scheduler_);
+			std::swap(ready_status_, rhs.ready_status_);
+			if (rhs.ready_)
+			{
+				ready_.emplace(std::move(*rhs.ready_));
+				rhs.ready_.reset();
+			}
 		}
 		return *this;
 	}
@@ -253,8 +410,8 @@ namespace nn
 	template<typename T, typename E>
 	Status Task<T, E>::status() const
 	{
-		assert(task_);
-		return task_->status();
+		assert(is_valid());
+		return (task_ ? task_->status() : ready_status_);
 	}
 
 	template<typename T, typename E>
@@ -272,7 +429,6 @@ namespace nn
 	template<typename T, typename E>
 	bool Task<T, E>::is_canceled() const
 	{
-		assert(task_);
 		return (status() == Status::Canceled);
 	}
 
@@ -293,43 +449,53 @@ namespace nn
 	template<typename T, typename E>
 	Scheduler& Task<T, E>::scheduler() const
 	{
-		assert(task_);
-		return task_->scheduler();
+		assert(is_valid());
+		return (task_ ? task_->scheduler() : *ready_scheduler_);
+	}
+
+	template<typename T, typename E>
+	Priority Task<T, E>::priority() const
+	{
+		assert(is_valid());
+		return (task_ ? task_->priority() : Priority::Normal);
 	}
 
 	template<typename T, typename E>
 	void Task<T, E>::try_cancel()
 	{
-		assert(task_);
-		task_->cancel();
+		assert(is_valid());
+		if (task_)
+		{
+			task_->cancel();
+		}
 	}
 
 	template<typename T, typename E>
 	expected<T, E>& Task<T, E>::get() const &
 	{
-		assert(task_);
-		return task_->get_data();
+		assert(is_valid());
+		return (task_ ? task_->get_data() : *ready_);
 	}
 
 	template<typename T, typename E>
 	expected<T, E>& Task<T, E>::get() &
 	{
-		assert(task_);
-		return task_->get_data();
+		assert(is_valid());
+		return (task_ ? task_->get_data() : *ready_);
 	}
 
 	template<typename T, typename E>
 	expected<T, E> Task<T, E>::get() &&
 	{
-		assert(task_);
-		return std::move(task_->get_data());
+		assert(is_valid());
+		return std::move(task_ ? task_->get_data() : *ready_);
 	}
 
 	template<typename T, typename E>
 	expected<T, E> Task<T, E>::get_once() const
 	{
-		assert(task_);
-		return std::move(task_->get_data());
+		assert(is_valid());
+		return std::move(task_ ? task_->get_data() : *ready_);
 	}
 
 	template<typename T, typename E>
@@ -346,6 +512,22 @@ namespace nn
 		return std::move(f)(self);
 	}
 
+	template<typename T, typename E>
+	template<typename Return, typename F>
+	/*static*/ auto Task<T, E>::invoke_ready(std::false_type
+		, Scheduler& scheduler, F&& f, const Task&)
+	{
+		return Return::invoke(scheduler, std::forward<F>(f));
+	}
+
+	template<typename T, typename E>
+	template<typename Return, typename F>
+	/*static*/ auto Task<T, E>::invoke_ready(std::true_type
+		, Scheduler& scheduler, F&& f, const Task& self)
+	{
+		return Return::invoke(scheduler, std::forward<F>(f), self);
+	}
+
 	template<typename T, typename E>
 	template<typename F, typename CallPredicate
 		, typename ReturnWithTaskArg
@@ -366,38 +548,83 @@ namespace nn
 		{
 			using Callable = detail::EboStorage<Function>;
 
-			explicit Invoker(Function f, CallPredicate p, const InternalTask& t)
+			explicit Invoker(Function f, CallPredicate p, Task&& t)
 				: Callable(std::move(f))
 				, CallPredicate(std::move(p))
-				, task(t)
+				, task(std::move(t))
 			{
 			}
 
+			// Predicate and functor get the same handle by reference:
+			// no reference counting on every call
 			decltype(auto) invoke()
 			{
 				Function& f = static_cast<Callable&>(*this).get();
-				return Task::invoke(HasTaskArg(), f, Task(task));
+				return Task::invoke(HasTaskArg(), f, task);
 			}
 
 			bool can_invoke()
 			{
 				auto& call_if = static_cast<CallPredicate&>(*this);
-				return std::move(call_if)(Task(task));
+				return std::move(call_if)(task);
 			}
 
 			bool wait() const
 			{
-				return (task->status() == Status::InProgress);
+				// Invoker is posted to the scheduler only when
+				// the task is finished (see make_after())
+				assert(task.is_finished());
+				return false;
 			}
 
-			InternalTask task;
+			Task task;
 		};
 
 		using FinishTask = detail::FunctionTask<FunctionTaskReturn, Invoker>;
 
+		if (is_ready())
+		{
+			if (&scheduler == ready_scheduler_)
+			{
+				// Nothing to wait for, no need to allocate continuation
+				if (!p(*this))
+				{
+					return ReturnTask(scheduler, Status::Canceled
+						, MakeExpectedWithDefaultError<typename ReturnTask::value>());
+				}
+				if (detail::EnterInlineContinuation(scheduler))
+				{
+					struct LeaveInline
+					{
+						~LeaveInline() { detail::LeaveInlineContinuation(); }
+					} leave;
+					return invoke_ready<FunctionTaskReturn>(HasTaskArg()
+						, scheduler, std::forward<F>(f), *this);
+				}
+			}
+			// Continuation is ticked by the scheduler: not from the tick,
+			// too deep recursion or other scheduler
+			constexpr bool cheap_copy = (std::is_trivially_copyable_v<value>
+				&& (sizeof(value) <= (2 * sizeof(void*))));
+			if constexpr (cheap_copy)
+			{
+				// Continuation gets own ready task and is posted right away:
+				// this task keeps its value for other continuations
+				return ReturnTask::template make<FinishTask>(scheduler
+					, Invoker(std::forward<F>(f), std::move(p)
+						, Task(*ready_scheduler_, ready_status_, value(*ready_))));
+			}
+			else
+			{
+				make_internal();
+			}
+		}
+
 		assert(task_);
-		return ReturnTask::template make<FinishTask>(scheduler
-			, Invoker(std::forward<F>(f), std::move(p), task_));
+		auto finish_task = ReturnTask::template make_after<FinishTask>(*task_, scheduler
+			, Invoker(std::forward<F>(f), std::move(p), Task(task_)));
+		NN_TRACE(detail::TraceContinuation(task_.get(), finish_task.task_.get()));
+		return finish_task;
 	}
 
 	template<typename T, typename E>
@@ -429,8 +656,8 @@ namespace nn
 		-> decltype(on_finish(
 			std::declval<Scheduler&>(), std::forward<F>(f)))
 	{
-		assert(task_);
-		return on_finish(task_->scheduler(), std::forward<F>(f));
+		assert(is_valid());
+		return on_finish(scheduler(), std::forward<F>(f));
 	}
 
 	template<typename T, typename E>
@@ -447,7 +674,7 @@ namespace nn
 		-> decltype(then(
 			std::declval<Scheduler&>(), std::forward<F>(f)))
 	{
-		return then(task_->scheduler(), std::forward<F>(f));
+		return then(scheduler(), std::forward<F>(f));
 	}
 
 	template<typename T, typename E>
@@ -468,8 +695,8 @@ namespace nn
 		-> decltype(on_fail(
 			std::declval<Scheduler&>(), std::forward<F>(f)))
 	{
-		assert(task_);
-		return on_fail(task_->scheduler(), std::forward<F>(f));
+		assert(is_valid());
+		return on_fail(scheduler(), std::forward<F>(f));
 	}
 
 	template<typename T, typename E>
@@ -490,8 +717,8 @@ namespace nn
 		-> decltype(on_success(
 			std::declval<Scheduler&>(), std::forward<F>(f)))
 	{
-		assert(task_);
-		return on_success(task_->scheduler(), std::forward<F>(f));
+		assert(is_valid());
+		return on_success(scheduler(), std::forward<F>(f));
 	}
 
 	template<typename T, typename E>
@@ -512,8 +739,8 @@ namespace nn
 		-> decltype(on_cancel(
 			std::declval<Scheduler&>(), std::forward<F>(f)))
 	{
-		assert(task_);
-		return on_cancel(task_->scheduler(), std::forward<F>(f));
+		assert(is_valid());
+		return on_cancel(scheduler(), std::forward<F>(f));
 	}
 
 	template<typename>
@@ -0,0 +1,124 @@
+#pragma once
+#include <memory>
+#include <memory_resource>
+
+#include <cstddef>
+
+namespace nn
+{
+
+	// Memory for task internals (state, custom task and
+	// continuations of every Task<>) of the Scheduler.
+	// Thread-safe: tasks are created and destroyed on any thread.
+	class TaskAllocator
+	{
+	public:
+		virtual ~TaskAllocator() = default;
+
+		virtual void* allocate(std::size_t size, std::size_t alignment) = 0;
+		// `size` and `alignment` are the same as passed to allocate()
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept = 0;
+	};
+
+	// Global operator new/delete
+	class NewDeleteTaskAllocator final : public TaskAllocator
+	{
+	public:
+		virtual void* allocate(std::size_t size, std::size_t alignment) override;
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override;
+	};
+
+	// Tasks from std::pmr::memory_resource (e.g., monotonic arena
+	// of the request). Thread-safe only if `resource` is:
+	// std::pmr::monotonic_buffer_resource and
+	// std::pmr::unsynchronized_pool_resource need a Scheduler
+	// which tasks are created and destroyed on one thread.
+	// `resource` should outlive the allocator
+	class MemoryResourceTaskAllocator final : public TaskAllocator
+	{
+	public:
+		explicit MemoryResourceTaskAllocator(std::pmr::memory_resource& resource);
+
+		virtual void* allocate(std::size_t size, std::size_t alignment) override;
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override;
+
+		std::pmr::memory_resource& resource() const;
+
+	private:
+		std::pmr::memory_resource* resource_;
+	};
+
+	// std::pmr::memory_resource on top of TaskAllocator, so containers
+	// of the tasks (see Scheduler::memory_resource()) draw from
+	// the same memory as tasks. `allocator` should outlive the resource
+	class TaskAllocatorResource final : public std::pmr::memory_resource
+	{
+	public:
+		explicit TaskAllocatorResource(TaskAllocator& allocator);
+
+		TaskAllocator& allocator() const;
+
+	private:
+		virtual void* do_allocate(std::size_t size, std::size_t alignment) override;
+		virtual void do_deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) override;
+		virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	private:
+		TaskAllocator* allocator_;
+	};
+
+	// Default allocator of the Scheduler. Blocks of fixed size
+	// classes (multiple of k_block_granularity) are carved from chunks
+	// of the size class. Chunks grow geometrically and are released
+	// only when allocator is destroyed. Every thread keeps small cache
+	// of free blocks per size class; caches exchange batches of blocks
+	// with lock-free stack of the size class, so memory freed on one
+	// thread is reused by tasks created on other threads.
+	// Caches of threads keep allocator's memory until thread exits
+	// or starts to use other allocators. Chunks are aligned by
+	// k_max_block_alignment, so are blocks which size is a multiple of it
+	// (e.g., tasks aligned by the cache line, see NN_CACHE_LINE_SIZE).
+	// Blocks that are bigger then k_max_block_size or over-aligned
+	// come from NewDeleteTaskAllocator.
+	class PoolTaskAllocator final : public TaskAllocator
+	{
+	public:
+		static constexpr std::size_t k_block_granularity = 32;
+		static constexpr std::size_t k_max_block_size = 512;
+		static constexpr std::size_t k_max_block_alignment = 64;
+		static constexpr std::size_t k_size_classes =
+			(k_max_block_size / k_block_granularity);
+
+		explicit PoolTaskAllocator();
+		virtual ~PoolTaskAllocator() override;
+		PoolTaskAllocator(PoolTaskAllocator&& rhs) = delete;
+		PoolTaskAllocator& operator=(PoolTaskAllocator&& rhs) = delete;
+		PoolTaskAllocator(const PoolTaskAllocator& rhs) = delete;
+		PoolTaskAllocator& operator=(const PoolTaskAllocator& rhs) = delete;
+
+		virtual void* allocate(std::size_t size, std::size_t alignment) override;
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override;
+
+		// Blocks (used and free) carved from the chunks so far
+		std::size_t reserved_blocks() const;
+
+	private:
+		class SizeClass;
+		struct State;
+		struct ThreadCache;
+
+		static bool IsPooled(std::size_t size, std::size_t alignment);
+		// Null when thread exits
+		static ThreadCache* GetThreadCache();
+
+	private:
+		std::shared_ptr<State> state_;
+		NewDeleteTaskAllocator fallback_;
+	};
+
+} // namespace nn
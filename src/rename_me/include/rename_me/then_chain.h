@@ -0,0 +1,227 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/detail/function_task_base.h>
+#include <rename_me/detail/cpp_20.h>
+
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+namespace nn
+{
+
+	template<typename T, typename E, typename... Fs>
+	class ThenChain;
+
+	namespace detail
+	{
+
+		// Single then() step of the fused chain: invokes `F` with
+		// finished `PrevTask` the same way Task<>::on_finish() does
+		template<typename PrevTask, typename F>
+		struct ThenStep
+		{
+			using ReturnWithTaskArg = FunctionTaskReturn<F, const PrevTask&>;
+			using ReturnWithoutTaskArg = FunctionTaskReturn<F>;
+			using HasTaskArg = typename ReturnWithTaskArg::is_valid;
+			using Return = std::conditional_t<
+				HasTaskArg::value
+				, ReturnWithTaskArg
+				, ReturnWithoutTaskArg>;
+			static_assert(Return::is_valid::value
+				, "Functor should accept `const Task<T, E>&` or nothing");
+			using type = typename Return::type;
+
+			static type invoke(Scheduler& scheduler, F&& f, const PrevTask& prev)
+			{
+				return invoke(HasTaskArg(), scheduler, std::move(f), prev);
+			}
+
+			static type invoke(std::true_type, Scheduler& scheduler, F&& f, const PrevTask& prev)
+			{
+				return Return::invoke(scheduler, std::move(f), prev);
+			}
+
+			static type invoke(std::false_type, Scheduler& scheduler, F&& f, const PrevTask&)
+			{
+				return Return::invoke(scheduler, std::move(f));
+			}
+		};
+
+		template<typename PrevTask, typename... Fs>
+		struct ThenChainReturn;
+
+		template<typename PrevTask>
+		struct ThenChainReturn<PrevTask>
+		{
+			using type = PrevTask;
+		};
+
+		template<typename PrevTask, typename F, typename... Fs>
+		struct ThenChainReturn<PrevTask, F, Fs...>
+			: ThenChainReturn<typename ThenStep<PrevTask, F>::type, Fs...>
+		{
+		};
+
+		// Functor that runs all `Fs` back to back. Every step returns
+		// ready Task<> (see Task<>::make_ready()) that is kept on the stack
+		// and passed to the next step, so nothing is allocated in between.
+		// If the step returns Task<> that is still in progress,
+		// rest of the steps are fused into its continuation
+		template<typename RootTask, typename... Fs>
+		class FusedThen : private std::tuple<Fs...>
+		{
+			using Functions = std::tuple<Fs...>;
+		public:
+			using type = typename ThenChainReturn<RootTask, Fs...>::type;
+
+			explicit FusedThen(Functions&& fs)
+				: Functions(std::move(fs))
+			{
+			}
+
+			type operator()(const RootTask& root)
+			{
+				return run<0>(root.scheduler(), root);
+			}
+
+		private:
+			template<std::size_t I, typename PrevTask>
+			type run(Scheduler& scheduler, const PrevTask& prev)
+			{
+				using F = std::tuple_element_t<I, Functions>;
+				using Step = ThenStep<PrevTask, F>;
+				auto next = Step::invoke(scheduler, std::move(std::get<I>(functions())), prev);
+				if constexpr ((I + 1) == sizeof...(Fs))
+				{
+					return next;
+				}
+				else
+				{
+					if constexpr (Step::Return::is_task::value)
+					{
+						if (next.is_in_progress())
+						{
+							return std::move(next).then(rest<I + 1, decltype(next)>(
+								std::make_index_sequence<sizeof...(Fs) - I - 1>()));
+						}
+					}
+					return run<I + 1>(scheduler, next);
+				}
+			}
+
+			template<std::size_t From, typename PrevTask, std::size_t... Is>
+			auto rest(std::index_sequence<Is...>)
+			{
+				using Rest = FusedThen<PrevTask, std::tuple_element_t<From + Is, Functions>...>;
+				return Rest(std::make_tuple(std::move(std::get<From + Is>(functions()))...));
+			}
+
+			Functions& functions()
+			{
+				return static_cast<Functions&>(*this);
+			}
+		};
+
+	} // namespace detail
+
+	// Builder of then() chain that is executed as single task.
+	// Instead of allocating and posting new task for every then(),
+	// functors are kept there until task() is called:
+	//
+	//   auto task = then_chain(std::move(root))
+	//       .then(a)
+	//       .then(b)
+	//       .then(c)
+	//       .task();
+	//
+	// is the same as root.then(a).then(b).then(c), but a, b and c are
+	// invoked back to back from one continuation of the `root`.
+	// Intermediate results are not observable: canceling returned task
+	// before the functors are invoked cancels the whole chain.
+	// Functor that returns Task<> that is not finished yet splits the
+	// chain: rest of the functors wait for this task in the same way
+	template<typename T, typename E, typename... Fs>
+	class ThenChain
+	{
+		using RootTask = Task<T, E>;
+		using Functions = std::tuple<Fs...>;
+		using Fused = detail::FusedThen<RootTask, Fs...>;
+
+		template<typename OtherT, typename OtherE, typename... OtherFs>
+		friend class ThenChain;
+
+	public:
+		using task_type = typename Fused::type;
+
+		explicit ThenChain(RootTask&& root);
+
+		template<typename F>
+		ThenChain<T, E, Fs..., detail::remove_cvref_t<F>> then(F&& f) &&;
+
+		// Posts fused functors as single continuation of the root task
+		task_type task() &&;
+
+	private:
+		explicit ThenChain(RootTask&& root, Functions&& fs);
+
+		task_type fuse(std::false_type /*empty chain*/);
+		task_type fuse(std::true_type /*empty chain*/);
+
+	private:
+		RootTask root_;
+		Functions fs_;
+	};
+
+	template<typename T, typename E>
+	ThenChain<T, E> then_chain(Task<T, E>&& root)
+	{
+		return ThenChain<T, E>(std::move(root));
+	}
+
+	template<typename T, typename E, typename... Fs>
+	/*explicit*/ ThenChain<T, E, Fs...>::ThenChain(RootTask&& root)
+		: root_(std::move(root))
+		, fs_()
+	{
+	}
+
+	template<typename T, typename E, typename... Fs>
+	/*explicit*/ ThenChain<T, E, Fs...>::ThenChain(RootTask&& root, Functions&& fs)
+		: root_(std::move(root))
+		, fs_(std::move(fs))
+	{
+	}
+
+	template<typename T, typename E, typename... Fs>
+	template<typename F>
+	ThenChain<T, E, Fs..., detail::remove_cvref_t<F>>
+		ThenChain<T, E, Fs...>::then(F&& f) &&
+	{
+		using Chain = ThenChain<T, E, Fs..., detail::remove_cvref_t<F>>;
+		return Chain(std::move(root_), std::tuple_cat(std::move(fs_)
+			, std::tuple<detail::remove_cvref_t<F>>(std::forward<F>(f))));
+	}
+
+	template<typename T, typename E, typename... Fs>
+	typename ThenChain<T, E, Fs...>::task_type ThenChain<T, E, Fs...>::task() &&
+	{
+		assert(root_.is_valid());
+		return fuse(std::bool_constant<(sizeof...(Fs) == 0)>());
+	}
+
+	template<typename T, typename E, typename... Fs>
+	typename ThenChain<T, E, Fs...>::task_type
+		ThenChain<T, E, Fs...>::fuse(std::false_type /*empty chain*/)
+	{
+		return root_.then(Fused(std::move(fs_)));
+	}
+
+	template<typename T, typename E, typename... Fs>
+	typename ThenChain<T, E, Fs...>::task_type
+		ThenChain<T, E, Fs...>::fuse(std::true_type /*empty chain*/)
+	{
+		return std::move(root_);
+	}
+
+} // namespace nn
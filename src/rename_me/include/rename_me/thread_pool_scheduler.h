@@ -0,0 +1,86 @@
+#pragma once
+#include <rename_me/scheduler.h>
+#include <rename_me/detail/work_stealing_deque.h>
+#include <rename_me/detail/threading.h>
+
+#if (NN_SINGLE_THREADED)
+#  error "ThreadPoolScheduler is not available with NN_SINGLE_THREADED"
+#endif
+
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace nn
+{
+
+	// Scheduler that ticks tasks on N worker threads.
+	// Each worker keeps its tasks in own work-stealing deque:
+	// tasks posted from the worker thread (including continuations)
+	// go to the worker's deque, tasks posted from other threads are
+	// distributed between workers. Idle workers steal tasks from
+	// randomly chosen workers. Every task is ticked by one thread
+	// at a time, but subsequent ticks may happen on different threads.
+	// Task's Priority is not taken into account (except queue_depth()):
+	// all tasks are ticked by idle workers as soon as possible.
+	//
+	// There is no need to poll() ThreadPoolScheduler,
+	// run_until() blocks until the task is finished.
+	class ThreadPoolScheduler final : public Scheduler
+	{
+	public:
+		// 0 means std::thread::hardware_concurrency()
+		explicit ThreadPoolScheduler(std::size_t workers_count = 0);
+		// `allocator` should outlive the scheduler and all its tasks
+		explicit ThreadPoolScheduler(TaskAllocator& allocator, std::size_t workers_count = 0);
+		// Tasks and workers' queues are allocated from thread-safe
+		// `resource` (see Scheduler(std::pmr::memory_resource&)), that
+		// should outlive the scheduler and all its tasks. Only the
+		// state of the worker threads (std::thread) comes from the heap
+		explicit ThreadPoolScheduler(std::pmr::memory_resource& resource, std::size_t workers_count = 0);
+		// Stops and joins workers. Tasks that are not finished yet
+		// are not ticked anymore, destroy all of them before
+		virtual ~ThreadPoolScheduler() override;
+
+		std::size_t workers_count() const;
+		// Same as workers_count()
+		virtual std::size_t concurrency() const override;
+
+	protected:
+		virtual void enqueue(detail::ErasedTask task) override;
+		virtual void enqueue_ready(detail::ErasedTask task) override;
+		virtual void notify_timers() override;
+
+	private:
+		struct Worker;
+
+		void start(std::size_t workers_count);
+		void run(Worker& worker);
+		// Ticks all tasks of the `worker` once.
+		// Returns true if at least one task finished
+		bool run_once(Worker& worker);
+		bool steal(Worker& worker);
+		// Waits for the work posted after `epoch` (see run())
+		void park(Worker& worker, std::size_t epoch);
+		void notify_work();
+		Worker* current_worker();
+
+	private:
+		// Workers and their queues. Global heap, unless the scheduler
+		// is constructed with memory resource
+		std::pmr::memory_resource& workers_resource_;
+		std::pmr::vector<Worker*> workers_;
+		std::atomic<std::size_t> next_worker_;
+		std::atomic<bool> stop_;
+		// Parking of idle workers
+		std::mutex sleep_guard_;
+		std::condition_variable work_available_;
+		std::atomic<std::size_t> sleeping_count_;
+		std::atomic<std::size_t> work_epoch_;
+	};
+
+} // namespace nn
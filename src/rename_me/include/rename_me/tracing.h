@@ -0,0 +1,29 @@
+#pragma once
+#include <ostream>
+
+#include <cstddef>
+
+namespace nn
+{
+
+	// Tracing of task's lifetime: creation, ticks, cancel requests,
+	// finish and on_finish() edges between tasks, plus Scheduler's polls.
+	// Events are recorded only when the library and the code that uses
+	// it are compiled with NN_ENABLE_TRACING=1 (see CMake option of the
+	// same name) and only between start_tracing() and stop_tracing().
+	// Every thread records events into its own ring buffer without
+	// locks, only last k_trace_buffer_events events are kept per thread.
+
+	constexpr std::size_t k_trace_buffer_events = (std::size_t(1) << 15);
+
+	void start_tracing();
+	void stop_tracing();
+	bool is_tracing();
+
+	// Writes recorded events as Chrome trace-event JSON that can be
+	// opened in https://ui.perfetto.dev or chrome://tracing.
+	// Written events are removed from the buffers.
+	// Should be called when tracing is stopped
+	void write_trace(std::ostream& out);
+
+} // namespace nn
@@ -0,0 +1,86 @@
+#pragma once
+#include <rename_me/task.h>
+#include <rename_me/detail/when_task_base.h>
+
+#include <tuple>
+#include <vector>
+#include <variant>
+#include <utility>
+
+#include <cstddef>
+
+namespace nn
+{
+
+	// Task that finishes once all `tasks` finish. Value is the tuple
+	// of the values of `tasks` in the same order. Task is always
+	// successful: failed and canceled tasks keep their errors there.
+	// `tasks` are not polled: every task decrements the counter once
+	// it finishes and the last one posts returned task to the scheduler
+	// of the first task. try_cancel() of returned task does not cancel
+	// `tasks`: it's canceled once they finish
+	//
+	//   auto task = when_all(std::move(config), std::move(user))
+	//       .then([](const Task<std::tuple<expected<Config>, expected<User>>>& t) {...});
+	template<typename T, typename E, typename... Ts, typename... Es>
+	Task<std::tuple<expected<T, E>, expected<Ts, Es>...>, void>
+		when_all(Task<T, E> task, Task<Ts, Es>... tasks)
+	{
+		using Children = std::tuple<Task<T, E>, Task<Ts, Es>...>;
+		using WhenTask = detail::WhenAllTask<Children>;
+		Scheduler& scheduler = task.scheduler();
+		return detail::WhenLatch::Make<typename WhenTask::Value, void, WhenTask>(scheduler
+			, Children(std::move(task), std::move(tasks)...));
+	}
+
+	// Same as when_all(tasks...) for any number of tasks of the same type.
+	// Values are kept in the vector that is reserved once. Returned
+	// task is posted to the `scheduler`, immediately if `tasks` is empty
+	template<typename T, typename E>
+	Task<std::vector<expected<T, E>>, void>
+		when_all(Scheduler& scheduler, std::vector<Task<T, E>> tasks)
+	{
+		using Children = std::vector<Task<T, E>>;
+		using WhenTask = detail::WhenAllTask<Children>;
+		return detail::WhenLatch::Make<typename WhenTask::Value, void, WhenTask>(scheduler
+			, std::move(tasks));
+	}
+
+	template<typename Value>
+	struct WhenAnyResult
+	{
+		// Position of the task that finished first
+		std::size_t index;
+		// Value of the task that finished first
+		Value value;
+	};
+
+	// Task that finishes once first of `tasks` finishes, successfully
+	// or not. Rest of the `tasks` are try_cancel()-ed, but are not
+	// waited for. Value is the std::variant<> with the value
+	// of the first task at the position of this task.
+	// As when_all(), returned task is not posted until then
+	template<typename T, typename E, typename... Ts, typename... Es>
+	Task<WhenAnyResult<std::variant<expected<T, E>, expected<Ts, Es>...>>, void>
+		when_any(Task<T, E> task, Task<Ts, Es>... tasks)
+	{
+		using Children = std::tuple<Task<T, E>, Task<Ts, Es>...>;
+		using WhenTask = detail::WhenAnyTask<Children>;
+		Scheduler& scheduler = task.scheduler();
+		return detail::WhenLatch::Make<typename WhenTask::Value, void, WhenTask>(scheduler
+			, Children(std::move(task), std::move(tasks)...));
+	}
+
+	// Same as when_any(tasks...) for any number of tasks of the same type.
+	// Fails immediately if `tasks` is empty
+	template<typename T, typename E>
+	Task<WhenAnyResult<expected<T, E>>, void>
+		when_any(Scheduler& scheduler, std::vector<Task<T, E>> tasks)
+	{
+		using Children = std::vector<Task<T, E>>;
+		using WhenTask = detail::WhenAnyTask<Children>;
+		return detail::WhenLatch::Make<typename WhenTask::Value, void, WhenTask>(scheduler
+			, std::move(tasks));
+	}
+
+} // namespace nn
@@ -0,0 +1,30 @@
+#include <rename_me/detail/parallel_task_base.h>
+#include <rename_me/scheduler.h>
+
+#include <algorithm>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		ParallelSplit SplitParallelRange(const Scheduler& scheduler
+			, std::size_t size, std::size_t grain)
+		{
+			const std::size_t concurrency = (std::max)(scheduler.concurrency(), std::size_t(1));
+			if (grain == 0)
+			{
+				grain = (std::max)(size / (concurrency * k_parallel_chunks_per_worker), std::size_t(1));
+			}
+			// Not (size + grain - 1) / grain: overflows for huge `grain`
+			const std::size_t chunks = (size / grain) + std::size_t((size % grain) != 0);
+			ParallelSplit split;
+			split.size = size;
+			split.grain = grain;
+			split.workers_count = (std::min)(concurrency, chunks);
+			split.wake_up = (concurrency == 1);
+			return split;
+		}
+
+	} // namespace detail
+} // namespace nn
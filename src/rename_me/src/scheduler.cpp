@@ -1,6 +1,7 @@
 #include <rename_me/scheduler.h>
 
 #include <algorithm>
+#include <thread>
 
 #include <cassert>
 
@@ -8,32 +9,279 @@ namespace nn
 {
 	namespace
 	{
-		using Lock = std::lock_guard<std::mutex>;
+		using TryLock = std::unique_lock<detail::Mutex>;
+
+		// run_until() keeps polling without sleeps for this number
+		// of polls in a row that have no finished tasks. Tasks that
+		// need many ticks to finish are not slowed down
+		const std::size_t k_spin_polls = 64;
+		// Then sleeps for the time that is doubled on every poll
+		// while nothing happens
+		const std::chrono::nanoseconds k_min_idle_wait = std::chrono::microseconds(50);
+		const std::chrono::nanoseconds k_max_idle_wait = std::chrono::milliseconds(1);
+		// Lane that was not ticked completely for this number
+		// of polls goes first on the next poll
+		const std::size_t k_max_starved_polls = 4;
+		// Continuations of ready tasks that are invoked one from
+		// another on the same stack, see EnterInlineContinuation()
+		const std::size_t k_max_inline_continuations = 16;
+
+		// Scheduler that ticks the task on this thread, if any
+		thread_local const Scheduler* t_ticking = nullptr;
+		thread_local std::size_t t_inline_continuations = 0;
+
+		std::int64_t NowNs()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::uint64_t ElapsedNs(std::int64_t start, std::int64_t end)
+		{
+			return ((end > start) ? static_cast<std::uint64_t>(end - start) : 0);
+		}
+
+		// Latency of every N-th task is recorded: reading
+		// the clock costs more then ticking of simple task
+		bool SampleLatency()
+		{
+			thread_local std::uint32_t t_counter = 0;
+			return ((t_counter++ % SchedulerStats::k_latency_sample_period) == 0);
+		}
 	} // namespace
 
 	/*explicit*/ Scheduler::Scheduler()
-		: tasks_()
+		: Scheduler(std::make_unique<PoolTaskAllocator>(), nullptr, nullptr)
+	{
+	}
+
+	/*explicit*/ Scheduler::Scheduler(TaskAllocator& allocator)
+		: Scheduler(nullptr, &allocator, nullptr)
+	{
+	}
+
+	/*explicit*/ Scheduler::Scheduler(std::pmr::memory_resource& resource)
+		: Scheduler(nullptr, nullptr, &resource)
+	{
+	}
+
+	/*explicit*/ Scheduler::Scheduler(std::unique_ptr<TaskAllocator> own_allocator
+		, TaskAllocator* allocator, std::pmr::memory_resource* resource)
+		: own_allocator_(std::move(own_allocator))
+		, resource_allocator_(resource ? *resource : *std::pmr::null_memory_resource())
+		, allocator_(allocator ? *allocator
+			: (resource ? resource_allocator_ : *own_allocator_))
+		, memory_resource_(allocator_)
+		, queue_()
+		, poll_guard_()
+		, lanes_()
+		, counters_()
+		, budget_guard_()
+		, budget_stats_()
 		, tasks_count_(0)
-		, tick_tasks_count_(0)
+		, waiting_tasks_count_(0)
+#if !defined(NDEBUG)
+		, alive_tasks_count_(0)
+#endif
+#if !(NN_SINGLE_THREADED)
+		, wait_guard_()
+		, wake_up_()
+#endif
+		, waiting_threads_count_(0)
+		, wake_requested_(false)
+		, timers_start_(Clock::now())
+		, timers_guard_()
+		, timers_()
+		, posted_timers_(nullptr)
+		, canceled_timers_(nullptr)
+		, next_timer_tick_(detail::TimerWheel::k_never)
 	{
 	}
 
 	Scheduler::~Scheduler()
 	{
 		assert(!has_tasks());
+		assert((alive_tasks_count_ == 0)
+			&& "Task<> handles should be destroyed before the Scheduler");
 	}
 
 	void Scheduler::post(detail::ErasedTask task)
 	{
 		assert(task);
-		Lock _(guard_);
-		tasks_.push_back(std::move(task));
-		tasks_count_ = tasks_.size();
+		detail::TaskBase::Timestamps& timestamps = task->timestamps();
+		if ((timestamps.created == 0) && SampleLatency())
+		{
+			timestamps.created = NowNs();
+			timestamps.ready = timestamps.created;
+		}
+		// Count before the task becomes visible to poll()
+		count_ready(*task);
+		enqueue(std::move(task));
+	}
+
+	void Scheduler::count_ready(detail::TaskBase& task)
+	{
+		++tasks_count_;
+		++lane(task).depth;
+		detail::TaskBase::Timestamps& timestamps = task.timestamps();
+		if ((timestamps.created != 0) && (timestamps.ready == 0))
+		{
+			// Sampled continuation or timer
+			timestamps.ready = NowNs();
+		}
+	}
+
+	Status Scheduler::tick_task(detail::TaskBase& task, TickCounters& counters)
+	{
+		detail::TaskBase::Timestamps& timestamps = task.timestamps();
+		if (timestamps.ready != 0)
+		{
+			counters_.first_tick_latency.record(ElapsedNs(timestamps.ready, NowNs()));
+			timestamps.ready = 0;
+		}
+		++counters.ticks;
+		const Scheduler* const ticking = t_ticking;
+		t_ticking = this;
+		const Status status = task.update();
+		t_ticking = ticking;
+		switch (status)
+		{
+		case Status::InProgress:
+			return status;
+		case Status::Successful:
+			++counters.successful;
+			break;
+		case Status::Failed:
+			++counters.failed;
+			break;
+		case Status::Canceled:
+			++counters.canceled;
+			break;
+		}
+		if (timestamps.created != 0)
+		{
+			counters_.completion_latency.record(ElapsedNs(timestamps.created, NowNs()));
+		}
+		return status;
+	}
+
+	void Scheduler::flush_counters(TickCounters& counters)
+	{
+		const auto add = [](detail::Atomic<std::uint64_t>& total, std::uint64_t& value)
+		{
+			if (value != 0)
+			{
+				total.fetch_add(value, std::memory_order_relaxed);
+				value = 0;
+			}
+		};
+		add(counters_.ticks, counters.ticks);
+		add(counters_.successful, counters.successful);
+		add(counters_.failed, counters.failed);
+		add(counters_.canceled, counters.canceled);
+	}
+
+	Scheduler::Lane& Scheduler::lane(detail::TaskBase& task)
+	{
+		const std::size_t index = static_cast<std::size_t>(task.priority());
+		assert(index < k_lanes);
+		return lanes_[index];
+	}
+
+	void Scheduler::enqueue(detail::ErasedTask task)
+	{
+		if (queue_.push(std::move(task)))
+		{
+			// Otherwise, poller did not get previous tasks yet
+			detail::AtomicFence(std::memory_order_seq_cst);
+			notify_waiting();
+		}
+	}
+
+	void Scheduler::enqueue_ready(detail::ErasedTask task)
+	{
+		// Run in the same poll()
+		Lane& l = lane(*task);
+		l.tasks.push_back(std::move(task));
+	}
+
+	void Scheduler::notify_timers()
+	{
+		notify_waiting();
+	}
+
+	void Scheduler::finish_task(detail::TaskBase& task)
+	{
+		post_continuations(task);
+		--lane(task).depth;
+		--tasks_count_;
+		// May be waited by run_until()
+		notify_waiting();
+	}
+
+	void Scheduler::park_task(detail::ErasedTask task)
+	{
+		// Counted as waiting one, same as posted by PostWaitingTask()
+		++waiting_tasks_count_;
+		--lane(*task).depth;
+		--tasks_count_;
+		detail::TaskBase* parked = task.detach();
+		if (!parked->park())
+		{
+			// unpark() was invoked meanwhile
+			detail::PostWaitingTask(*this, detail::ErasedTask::attach(parked));
+		}
+	}
+
+	void Scheduler::post_after(detail::TaskBase& parent, detail::ErasedTask task)
+	{
+		assert(task);
+		// Count before the task becomes visible to the parent
+		// to not underflow in post_continuations()
+		++waiting_tasks_count_;
+		if (SampleLatency())
+		{
+			task->timestamps().created = NowNs();
+		}
+		detail::TaskBase* continuation = task.detach();
+		if (!parent.add_continuation(continuation))
+		{
+			// Parent finished already
+			post(detail::ErasedTask::attach(continuation));
+			--waiting_tasks_count_;
+		}
+	}
+
+	void Scheduler::post_continuations(detail::TaskBase& task)
+	{
+		detail::TaskBase* continuation = task.close_continuations();
+		while (continuation)
+		{
+			detail::TaskBase* next = continuation->next();
+			continuation->set_next(nullptr);
+			Scheduler& scheduler = continuation->scheduler();
+			if (continuation->is_inline_continuation())
+			{
+				(void)continuation->update();
+				(void)detail::ErasedTask::attach(continuation);
+			}
+			else if (&scheduler == this)
+			{
+				count_ready(*continuation);
+				enqueue_ready(detail::ErasedTask::attach(continuation));
+			}
+			else
+			{
+				scheduler.post(detail::ErasedTask::attach(continuation));
+			}
+			--scheduler.waiting_tasks_count_;
+			continuation = next;
+		}
 	}
 
 	std::size_t Scheduler::tasks_count() const
 	{
-		return (tasks_count_ + tick_tasks_count_);
+		return (tasks_count_ + waiting_tasks_count_);
 	}
 
 	bool Scheduler::has_tasks() const
@@ -41,52 +289,573 @@ namespace nn
 		return (tasks_count() > 0);
 	}
 
+	std::size_t Scheduler::queue_depth(Priority priority) const
+	{
+		const std::size_t index = static_cast<std::size_t>(priority);
+		assert(index < k_lanes);
+		return lanes_[index].depth;
+	}
+
+	TaskAllocator& Scheduler::allocator()
+	{
+		return allocator_;
+	}
+
+	std::pmr::memory_resource& Scheduler::memory_resource()
+	{
+		if (&allocator_ == &resource_allocator_)
+		{
+			return resource_allocator_.resource();
+		}
+		return memory_resource_;
+	}
+
+	std::size_t Scheduler::concurrency() const
+	{
+		return 1;
+	}
+
+	void Scheduler::take_posted()
+	{
+		// Split posted tasks by lanes keeping the order
+		detail::TaskBase* heads[k_lanes] = {};
+		detail::TaskBase* tails[k_lanes] = {};
+		detail::TaskBase* task = queue_.pop_all();
+		while (task)
+		{
+			detail::TaskBase* next = task->next();
+			task->set_next(nullptr);
+			const std::size_t index = static_cast<std::size_t>(task->priority());
+			if (tails[index])
+			{
+				tails[index]->set_next(task);
+			}
+			else
+			{
+				heads[index] = task;
+			}
+			tails[index] = task;
+			task = next;
+		}
+		for (std::size_t i = 0; i < k_lanes; ++i)
+		{
+			lanes_[i].tasks.push_front(heads[i]);
+		}
+	}
+
 	std::size_t Scheduler::poll(std::size_t tasks_count /*= 0*/)
 	{
+		TryLock lock(poll_guard_, std::try_to_lock);
+		if (!lock.owns_lock())
+		{
+			return 0;
+		}
+		bool out_of_budget = false;
+		return poll_lanes(tasks_count, Clock::time_point::max(), out_of_budget);
+	}
+
+	std::size_t Scheduler::poll_for(std::chrono::nanoseconds budget)
+	{
+		TryLock lock(poll_guard_, std::try_to_lock);
+		if (!lock.owns_lock())
+		{
+			return 0;
+		}
+		const Clock::time_point start = Clock::now();
+		bool out_of_budget = false;
+		const std::size_t finished = poll_lanes(0
+			, start + std::chrono::duration_cast<Clock::duration>(budget), out_of_budget);
+		const std::chrono::nanoseconds elapsed = (Clock::now() - start);
+		record_budget(budget, elapsed, out_of_budget);
+		return finished;
+	}
+
+	void Scheduler::record_budget(std::chrono::nanoseconds budget
+		, std::chrono::nanoseconds elapsed, bool out_of_budget)
+	{
+		std::lock_guard<detail::Mutex> lock(budget_guard_);
+		++budget_stats_.polls;
+		if (out_of_budget)
+		{
+			++budget_stats_.exhausted;
+		}
+		const std::chrono::nanoseconds overrun = std::max(elapsed - budget
+			, std::chrono::nanoseconds(0));
+		budget_stats_.last_overrun = overrun;
+		if (overrun > std::chrono::nanoseconds(0))
+		{
+			++budget_stats_.overruns;
+			budget_stats_.total_overrun += overrun;
+			budget_stats_.max_overrun = std::max(budget_stats_.max_overrun, overrun);
+		}
+	}
+
+	BudgetStats Scheduler::budget_stats() const
+	{
+		std::lock_guard<detail::Mutex> lock(budget_guard_);
+		return budget_stats_;
+	}
+
+	SchedulerStats Scheduler::stats() const
+	{
+		SchedulerStats stats;
+		stats.successful = counters_.successful.load(std::memory_order_relaxed);
+		stats.failed = counters_.failed.load(std::memory_order_relaxed);
+		stats.canceled = counters_.canceled.load(std::memory_order_relaxed);
+		// Every ready task is either finished or counted by tasks_count_
+		stats.posted = (stats.finished() + tasks_count_);
+		stats.ticks = counters_.ticks.load(std::memory_order_relaxed);
+		stats.polls = counters_.polls.load(std::memory_order_relaxed);
+		stats.tasks_count = tasks_count();
+		for (std::size_t i = 0; i < k_lanes; ++i)
+		{
+			stats.queue_depth[i] = lanes_[i].depth;
+		}
+		stats.ticks_per_poll = counters_.ticks_per_poll.snapshot();
+		stats.poll_duration = counters_.poll_duration.snapshot();
+		stats.first_tick_latency = counters_.first_tick_latency.snapshot();
+		stats.completion_latency = counters_.completion_latency.snapshot();
+		stats.budget = budget_stats();
+		return stats;
+	}
+
+	std::size_t Scheduler::poll_lanes(std::size_t tasks_count
+		, Clock::time_point deadline, bool& out_of_budget)
+	{
+		// Sampled, see SampleLatency()
+		bool measure = false;
+		std::int64_t start = 0;
 		std::size_t finished = 0;
+		TickCounters counters;
 		const bool has_limit = (tasks_count != 0);
-		auto tasks = get_tasks();
-		for (auto& task : tasks)
+		const bool has_deadline = (deadline != Clock::time_point::max());
+		NN_TRACE(const std::int64_t trace_start = detail::TraceStart());
+		poll_timers();
+		// Newly posted tasks go in front of in-progress tasks
+		take_posted();
+
+		// Lanes in priority order, except starved lane that goes first
+		std::size_t order[k_lanes] = {};
+		std::size_t most_starved = 0;
+		for (std::size_t i = 0; i < k_lanes; ++i)
 		{
-			if (task->update() == Status::InProgress)
+			order[i] = i;
+			if (lanes_[i].starved_polls > lanes_[most_starved].starved_polls)
 			{
-				continue;
+				most_starved = i;
 			}
+		}
+		if (lanes_[most_starved].starved_polls >= k_max_starved_polls)
+		{
+			std::rotate(order, order + most_starved, order + most_starved + 1);
+		}
 
-			task = nullptr;
-			++finished;
-			if (has_limit && (finished == tasks_count))
+		bool ticked[k_lanes] = {};
+		const auto next_task = [&](std::size_t index)
+		{
+			const Lane& l = lanes_[index];
+			return (l.cursor ? l.cursor->next() : l.tasks.front());
+		};
+		while (true)
+		{
+			std::size_t index = k_lanes;
+			detail::TaskBase* task = nullptr;
+			for (std::size_t i : order)
+			{
+				task = next_task(i);
+				if (task)
+				{
+					index = i;
+					break;
+				}
+			}
+			if (!task)
 			{
 				break;
 			}
+			if ((counters.ticks == 0) && SampleLatency())
+			{
+				measure = true;
+				start = NowNs();
+			}
+			ticked[index] = true;
+			Lane& l = lanes_[index];
+			if (tick_task(*task, counters) == Status::InProgress)
+			{
+				if (task->is_park_requested())
+				{
+					park_task(l.tasks.remove_after(l.cursor));
+				}
+				else
+				{
+					l.cursor = task;
+				}
+			}
+			else
+			{
+				detail::ErasedTask finished_task = l.tasks.remove_after(l.cursor);
+				finish_task(*finished_task);
+				++finished;
+				if (has_limit && (finished == tasks_count))
+				{
+					break;
+				}
+			}
+			if (has_deadline && (Clock::now() >= deadline))
+			{
+				out_of_budget = true;
+				break;
+			}
+		}
+
+		for (std::size_t i = 0; i < k_lanes; ++i)
+		{
+			Lane& l = lanes_[i];
+			const bool has_unvisited = (next_task(i) != nullptr);
+			const bool starved = (!ticked[i] && has_unvisited);
+			l.starved_polls = (starved ? (l.starved_polls + 1) : 0);
+			if (!has_unvisited)
+			{
+				// Whole lane was ticked, start from the front next time
+				l.cursor = nullptr;
+			}
 		}
-		add_tasks(std::move(tasks));
+
+		counters_.polls.fetch_add(1, std::memory_order_relaxed);
+		if (measure)
+		{
+			counters_.ticks_per_poll.record(counters.ticks);
+			counters_.poll_duration.record(ElapsedNs(start, NowNs()));
+		}
+		flush_counters(counters);
+		NN_TRACE(detail::TracePoll(this, trace_start, counters.ticks));
 		return finished;
 	}
 
-	std::vector<detail::ErasedTask> Scheduler::get_tasks()
+	bool Scheduler::wait_for_work(std::chrono::nanoseconds timeout)
+	{
+		const Clock::time_point timer = next_timer();
+		if (timer != Clock::time_point::max())
+		{
+			const Clock::time_point now = Clock::now();
+			if (timer <= now)
+			{
+				return true;
+			}
+			timeout = std::min<std::chrono::nanoseconds>(timeout, timer - now);
+		}
+
+#if (NN_SINGLE_THREADED)
+		// Nobody else can post the task or wake_up() while we sleep
+		const bool has_work = (wake_requested_ || has_posted_work());
+		if (!has_work)
+		{
+			std::this_thread::sleep_for(timeout);
+		}
+#else
+		std::unique_lock<std::mutex> lock(wait_guard_);
+		++waiting_threads_count_;
+		// Pairs with the fence in enqueue(): either we see posted
+		// task or poster sees waiting thread
+		detail::AtomicFence(std::memory_order_seq_cst);
+		const bool has_work = wake_up_.wait_for(lock, timeout, [this]
+		{
+			return (wake_requested_ || has_posted_work());
+		});
+		--waiting_threads_count_;
+#endif
+		wake_requested_ = false;
+		return (has_work || (Clock::now() >= timer));
+	}
+
+	bool Scheduler::has_posted_work() const
+	{
+		return (!queue_.empty() || has_posted_timers());
+	}
+
+	bool Scheduler::has_posted_timers() const
+	{
+		return (posted_timers_.load(std::memory_order_relaxed)
+			|| canceled_timers_.load(std::memory_order_relaxed));
+	}
+
+	void Scheduler::wake_up()
+	{
+#if (NN_SINGLE_THREADED)
+		wake_requested_ = true;
+#else
+		{
+			std::lock_guard<std::mutex> lock(wait_guard_);
+			wake_requested_ = true;
+		}
+		wake_up_.notify_all();
+#endif
+	}
+
+	void Scheduler::notify_waiting()
+	{
+		if (waiting_threads_count_ > 0)
+		{
+			wake_up();
+		}
+	}
+
+	void Scheduler::run_until_idle()
+	{
+		std::size_t idle_polls = 0;
+		while (has_tasks())
+		{
+			poll_or_wait(idle_polls);
+		}
+	}
+
+	void Scheduler::poll_or_wait(std::size_t& idle_polls)
 	{
-		std::vector<detail::ErasedTask> tasks;
-		Lock _(guard_);
-		tasks = std::move(tasks_);
-		tick_tasks_count_ = tasks.size();
-		tasks_count_ = 0;
-		return tasks;
+		if (poll() > 0)
+		{
+			idle_polls = 0;
+			return;
+		}
+		if (idle_polls < k_spin_polls)
+		{
+			++idle_polls;
+			std::this_thread::yield();
+			return;
+		}
+		const std::size_t shift = std::min<std::size_t>(idle_polls - k_spin_polls, 16);
+		const std::chrono::nanoseconds timeout = std::min<std::chrono::nanoseconds>(
+			k_min_idle_wait * (std::size_t(1) << shift), k_max_idle_wait);
+		if (wait_for_work(timeout))
+		{
+			idle_polls = 0;
+			return;
+		}
+		++idle_polls;
 	}
 
-	void Scheduler::add_tasks(std::vector<detail::ErasedTask> tasks)
+	void Scheduler::post_at(detail::TimerNode& timer, detail::ErasedTask task)
 	{
-		// Move in-progress tasks back
-		auto it = std::remove_if(std::begin(tasks), std::end(tasks)
-			, [](const detail::ErasedTask& task) { return !task; });
+		assert(task);
+		assert(!timer.task_ && "Timer can be posted only once");
+		// Count before the task becomes visible to poll_timers()
+		// to not underflow in make_timer_ready()
+		++waiting_tasks_count_;
+		if (SampleLatency())
+		{
+			task->timestamps().created = NowNs();
+		}
+		timer.task_ = task.detach();
+		detail::TimerNode* head = posted_timers_.load(std::memory_order_relaxed);
+		do
+		{
+			timer.next_ = head;
+		}
+		while (!posted_timers_.compare_exchange_weak(head, &timer
+			, std::memory_order_release, std::memory_order_relaxed));
+		// See wait_for_work()
+		detail::AtomicFence(std::memory_order_seq_cst);
+		notify_timers();
+	}
 
-		Lock _(guard_);
-		tasks_.reserve(tasks_.size() + tasks.size());
-		tasks_.insert(std::end(tasks_)
-			, std::make_move_iterator(std::begin(tasks))
-			, std::make_move_iterator(it));
-		tick_tasks_count_ = 0;
-		tasks_count_ = tasks_.size();
+	void Scheduler::cancel_timer(detail::TimerNode& timer)
+	{
+		if (!timer.task_)
+		{
+			// Task was not posted with post_at()
+			return;
+		}
+		if (timer.cancel_posted_.exchange(true))
+		{
+			return;
+		}
+		// Keep task alive until poll_timers()
+		timer.task_->add_ref_count();
+		detail::TimerNode* head = canceled_timers_.load(std::memory_order_relaxed);
+		do
+		{
+			timer.next_canceled_ = head;
+		}
+		while (!canceled_timers_.compare_exchange_weak(head, &timer
+			, std::memory_order_release, std::memory_order_relaxed));
+		// See wait_for_work()
+		detail::AtomicFence(std::memory_order_seq_cst);
+		notify_timers();
 	}
 
+	void Scheduler::poll_timers()
+	{
+		if (!posted_timers_.load(std::memory_order_relaxed)
+			&& !canceled_timers_.load(std::memory_order_relaxed)
+			&& (next_timer_tick_.load(std::memory_order_relaxed) == detail::TimerWheel::k_never))
+		{
+			// Fast path: no timers at all
+			return;
+		}
+		TryLock lock(timers_guard_, std::try_to_lock);
+		if (!lock.owns_lock())
+		{
+			return;
+		}
+
+		timers_.advance(now_tick(), [this](detail::TimerNode& timer)
+		{
+			make_timer_ready(timer);
+		});
+
+		detail::TimerNode* posted = posted_timers_.exchange(nullptr, std::memory_order_acquire);
+		while (posted)
+		{
+			detail::TimerNode* next = posted->next_;
+			posted->next_ = nullptr;
+			const std::uint64_t tick = to_tick(posted->deadline());
+			if (posted->canceled_ || (tick <= timers_.elapsed()))
+			{
+				make_timer_ready(*posted);
+			}
+			else
+			{
+				timers_.schedule(*posted, tick);
+			}
+			posted = next;
+		}
+
+		detail::TimerNode* canceled = canceled_timers_.exchange(nullptr, std::memory_order_acquire);
+		while (canceled)
+		{
+			detail::TimerNode* next = canceled->next_canceled_;
+			canceled->next_canceled_ = nullptr;
+			detail::TaskBase* task = canceled->task_;
+			if (canceled->is_scheduled())
+			{
+				timers_.cancel(*canceled);
+				make_timer_ready(*canceled);
+			}
+			else if (!canceled->expired_)
+			{
+				// Posted, but not yet scheduled timer
+				canceled->canceled_ = true;
+			}
+			// Reference from cancel_timer()
+			(void)detail::ErasedTask::attach(task);
+			canceled = next;
+		}
+
+		next_timer_tick_ = timers_.next_expiration();
+	}
+
+	void Scheduler::make_timer_ready(detail::TimerNode& timer)
+	{
+		assert(!timer.is_scheduled() && !timer.expired_);
+		timer.expired_ = true;
+		count_ready(*timer.task_);
+		enqueue_ready(detail::ErasedTask::attach(timer.task_));
+		--waiting_tasks_count_;
+	}
+
+	Scheduler::Clock::time_point Scheduler::next_timer() const
+	{
+		const std::uint64_t tick = next_timer_tick_;
+		if (tick == detail::TimerWheel::k_never)
+		{
+			return Clock::time_point::max();
+		}
+		return (timers_start_ + std::chrono::milliseconds(tick));
+	}
+
+	std::uint64_t Scheduler::to_tick(Clock::time_point time) const
+	{
+		if (time <= timers_start_)
+		{
+			return 0;
+		}
+		// Round up to never expire timer earlier
+		const Clock::duration duration = (time - timers_start_);
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+		if (ms < duration)
+		{
+			++ms;
+		}
+		return static_cast<std::uint64_t>(ms.count());
+	}
+
+	std::uint64_t Scheduler::now_tick() const
+	{
+		const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			Clock::now() - timers_start_);
+		return static_cast<std::uint64_t>(ms.count());
+	}
+
+	namespace detail
+	{
+		void CancelTimer(Scheduler& scheduler, TimerNode& timer)
+		{
+			scheduler.cancel_timer(timer);
+		}
+
+		void PostTask(Scheduler& scheduler, ErasedTask task)
+		{
+			scheduler.post(std::move(task));
+		}
+
+		void PostTaskAfter(Scheduler& scheduler, TaskBase& parent, ErasedTask task)
+		{
+			scheduler.post_after(parent, std::move(task));
+		}
+
+		void CountWaitingTask(Scheduler& scheduler)
+		{
+			++scheduler.waiting_tasks_count_;
+		}
+
+		void PostWaitingTask(Scheduler& scheduler, ErasedTask task)
+		{
+			assert(task);
+			// Uncount after the post to not make run_until_idle()
+			// see no tasks in between
+			scheduler.post(std::move(task));
+			--scheduler.waiting_tasks_count_;
+		}
+
+		void ReleaseWaitingTask(Scheduler& scheduler, ErasedTask task)
+		{
+			task = nullptr;
+			--scheduler.waiting_tasks_count_;
+		}
+
+		bool EnterInlineContinuation(const Scheduler& scheduler)
+		{
+			if ((t_ticking != &scheduler)
+				|| (t_inline_continuations >= k_max_inline_continuations))
+			{
+				return false;
+			}
+			++t_inline_continuations;
+			return true;
+		}
+
+		void LeaveInlineContinuation()
+		{
+			assert(t_inline_continuations > 0);
+			--t_inline_continuations;
+		}
+
+		void* AllocateTask(Scheduler& scheduler
+			, std::size_t size, std::size_t alignment)
+		{
+#if !defined(NDEBUG)
+			++scheduler.alive_tasks_count_;
+#endif
+			return scheduler.allocator().allocate(size, alignment);
+		}
+
+		void DeallocateTask(Scheduler& scheduler, void* ptr
+			, std::size_t size, std::size_t alignment) noexcept
+		{
+			scheduler.allocator().deallocate(ptr, size, alignment);
+#if !defined(NDEBUG)
+			--scheduler.alive_tasks_count_;
+#endif
+		}
+	} // namespace detail
+
 } // namespace nn
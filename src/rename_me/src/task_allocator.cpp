@@ -0,0 +1,505 @@
+#include <rename_me/task_allocator.h>
+#include <rename_me/detail/bits.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#include <cstdint>
+#include <cassert>
+
+namespace nn
+{
+	namespace
+	{
+		// Chunk N of the size class has (k_first_chunk_blocks << N) blocks
+		const std::uint32_t k_first_chunk_blocks = 64;
+		// Up to ~10^9 blocks of every size class, fits 32-bit index
+		const std::uint32_t k_max_chunks = 24;
+		// Blocks move between thread's cache and shared
+		// stack of the size class in batches
+		const std::uint32_t k_batch_blocks = 32;
+		const std::uint32_t k_max_cached_blocks = (2 * k_batch_blocks);
+		// Allocators (schedulers) that thread uses at the same time
+		const std::size_t k_cached_allocators = 4;
+
+		static_assert((k_first_chunk_blocks % k_batch_blocks) == 0
+			, "Batch should not cross chunks");
+
+		std::uint32_t ChunkBlocks(std::uint32_t chunk)
+		{
+			return (k_first_chunk_blocks << chunk);
+		}
+
+		// Index of the first block of the chunk
+		std::uint32_t ChunkStart(std::uint32_t chunk)
+		{
+			return (k_first_chunk_blocks * ((std::uint32_t(1) << chunk) - 1));
+		}
+
+		std::uint32_t ChunkFor(std::uint32_t index)
+		{
+			return detail::HighestBit((index / k_first_chunk_blocks) + 1);
+		}
+
+		struct FreeBlock
+		{
+			// Next block of the batch or thread's cache
+			FreeBlock* next = nullptr;
+			// Batch's head only: blocks in the batch
+			std::uint32_t count = 0;
+		};
+
+		// Batch's head only: index + 1 of the next batch
+		// in the shared stack, 0 if none
+		using BatchLink = std::atomic<std::uint32_t>;
+
+		static_assert(sizeof(FreeBlock) <= PoolTaskAllocator::k_block_granularity
+			, "Free block should fit smallest size class");
+
+		// Plain bool is usable during and after thread's exit
+		thread_local bool t_cache_destroyed = false;
+	} // namespace
+
+	// Shared part of the size class: chunks and lock-free stack
+	// of batches of free blocks. Stack's head keeps (index + 1) of
+	// the top batch's block and a tag that changes on every update,
+	// so popping thread never succeeds with the link that it read
+	// from the batch which was popped and pushed back meanwhile (ABA).
+	// Links are kept after the blocks of the chunk, not in the blocks:
+	// popping thread may read the link of the batch which blocks are
+	// in use already, it does not race with the tasks constructed there
+	class PoolTaskAllocator::SizeClass
+	{
+	public:
+		explicit SizeClass()
+			: block_size_(0)
+			, batches_(0)
+			, chunks_count_(0)
+			, chunks_()
+			, grow_guard_()
+			, carved_(0)
+		{
+		}
+
+		~SizeClass()
+		{
+			const std::uint32_t count = chunks_count_.load();
+			for (std::uint32_t chunk = 0; chunk < count; ++chunk)
+			{
+				::operator delete(chunks_[chunk].load()
+					, std::align_val_t(k_max_block_alignment));
+			}
+		}
+
+		void set_block_size(std::size_t block_size)
+		{
+			block_size_ = block_size;
+		}
+
+		// Returns list of free blocks linked thru FreeBlock::next
+		FreeBlock* pop_batch(std::uint32_t& count)
+		{
+			std::uint64_t head = batches_.load(std::memory_order_acquire);
+			while (IndexOf(head) != 0)
+			{
+				const std::uint32_t index = (IndexOf(head) - 1);
+				const std::uint32_t next = link_at(index).load(std::memory_order_relaxed);
+				if (batches_.compare_exchange_weak(head, MakeHead(head, next)
+					, std::memory_order_acquire, std::memory_order_acquire))
+				{
+					FreeBlock* batch = block_at(index);
+					count = batch->count;
+					return batch;
+				}
+			}
+			return carve(count);
+		}
+
+		// Takes list of `count` free blocks linked thru FreeBlock::next
+		void push_batch(FreeBlock* batch, std::uint32_t count)
+		{
+			assert(batch && (count != 0));
+			batch->count = count;
+			const std::uint32_t index = index_of(batch);
+			BatchLink& link = link_at(index);
+			std::uint64_t head = batches_.load(std::memory_order_relaxed);
+			do
+			{
+				link.store(IndexOf(head), std::memory_order_relaxed);
+			}
+			while (!batches_.compare_exchange_weak(head, MakeHead(head, index + 1)
+				, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		std::size_t reserved_blocks()
+		{
+			std::lock_guard<std::mutex> lock(grow_guard_);
+			const std::uint32_t count = chunks_count_.load(std::memory_order_relaxed);
+			return ((count == 0) ? 0 : (ChunkStart(count - 1) + carved_));
+		}
+
+	private:
+		static std::uint32_t IndexOf(std::uint64_t head)
+		{
+			return static_cast<std::uint32_t>(head);
+		}
+
+		static std::uint64_t MakeHead(std::uint64_t prev_head, std::uint32_t index)
+		{
+			const std::uint64_t tag = ((prev_head >> 32) + 1);
+			return ((tag << 32) | index);
+		}
+
+		FreeBlock* block_at(std::uint32_t index) const
+		{
+			const std::uint32_t chunk = ChunkFor(index);
+			char* data = chunks_[chunk].load(std::memory_order_acquire);
+			assert(data);
+			return reinterpret_cast<FreeBlock*>(
+				data + (index - ChunkStart(chunk)) * block_size_);
+		}
+
+		BatchLink& link_at(std::uint32_t index) const
+		{
+			const std::uint32_t chunk = ChunkFor(index);
+			char* data = chunks_[chunk].load(std::memory_order_acquire);
+			assert(data);
+			BatchLink* links = reinterpret_cast<BatchLink*>(
+				data + ChunkBlocks(chunk) * block_size_);
+			return links[index - ChunkStart(chunk)];
+		}
+
+		std::uint32_t index_of(const void* ptr) const
+		{
+			const char* p = static_cast<const char*>(ptr);
+			const std::uint32_t count = chunks_count_.load(std::memory_order_acquire);
+			// Most of the blocks are in the last (biggest) chunks
+			for (std::uint32_t chunk = count; chunk-- > 0;)
+			{
+				const char* data = chunks_[chunk].load(std::memory_order_relaxed);
+				const std::size_t offset = static_cast<std::size_t>(p - data);
+				if ((p >= data) && (offset < ChunkBlocks(chunk) * block_size_))
+				{
+					assert((offset % block_size_) == 0);
+					return static_cast<std::uint32_t>(
+						ChunkStart(chunk) + (offset / block_size_));
+				}
+			}
+			assert(false && "Block was not allocated by this allocator");
+			return 0;
+		}
+
+		// Cuts new batch from the last chunk, adds chunk if needed
+		FreeBlock* carve(std::uint32_t& count)
+		{
+			std::lock_guard<std::mutex> lock(grow_guard_);
+			std::uint32_t chunk = chunks_count_.load(std::memory_order_relaxed);
+			if ((chunk == 0) || (carved_ == ChunkBlocks(chunk - 1)))
+			{
+				if (chunk == k_max_chunks)
+				{
+					throw std::bad_alloc();
+				}
+				// Blocks, then link of every block (see link_at())
+				const std::uint32_t blocks = ChunkBlocks(chunk);
+				char* data = static_cast<char*>(::operator new(
+					blocks * (block_size_ + sizeof(BatchLink))
+					, std::align_val_t(k_max_block_alignment)));
+				BatchLink* links = reinterpret_cast<BatchLink*>(data + blocks * block_size_);
+				for (std::uint32_t i = 0; i < blocks; ++i)
+				{
+					new(links + i) BatchLink(0);
+				}
+				chunks_[chunk].store(data, std::memory_order_release);
+				chunks_count_.store(chunk + 1, std::memory_order_release);
+				carved_ = 0;
+				++chunk;
+			}
+			char* data = chunks_[chunk - 1].load(std::memory_order_relaxed)
+				+ (carved_ * block_size_);
+			carved_ += k_batch_blocks;
+
+			FreeBlock* next = nullptr;
+			for (std::uint32_t i = k_batch_blocks; i-- > 0;)
+			{
+				FreeBlock* block = new(data + i * block_size_) FreeBlock();
+				block->next = next;
+				next = block;
+			}
+			count = k_batch_blocks;
+			return next;
+		}
+
+	private:
+		std::size_t block_size_;
+		std::atomic<std::uint64_t> batches_;
+		std::atomic<std::uint32_t> chunks_count_;
+		std::atomic<char*> chunks_[k_max_chunks];
+		std::mutex grow_guard_;
+		// Blocks of the last chunk given away
+		std::uint32_t carved_;
+	};
+
+	struct PoolTaskAllocator::State
+	{
+		SizeClass classes[k_size_classes];
+	};
+
+	// Free blocks that the thread took from (or freed to) allocators.
+	// Keeps allocator's State alive, so blocks can be returned to the
+	// allocator's shared stacks at any time, even if allocator itself
+	// is destroyed. State (and all its memory) is released once
+	// allocator and all thread's caches that use it are destroyed
+	struct PoolTaskAllocator::ThreadCache
+	{
+		struct List
+		{
+			FreeBlock* head = nullptr;
+			std::uint32_t count = 0;
+		};
+
+		struct Entry
+		{
+			std::shared_ptr<State> state;
+			List lists[k_size_classes];
+		};
+
+		~ThreadCache()
+		{
+			for (Entry& entry : entries)
+			{
+				Flush(entry);
+			}
+			t_cache_destroyed = true;
+		}
+
+		List& list(const std::shared_ptr<State>& state, std::size_t size_class)
+		{
+			for (Entry& entry : entries)
+			{
+				if (entry.state == state)
+				{
+					return entry.lists[size_class];
+				}
+			}
+			// Evict least recently added allocator
+			Entry& last = entries[k_cached_allocators - 1];
+			Flush(last);
+			for (std::size_t i = k_cached_allocators - 1; i > 0; --i)
+			{
+				entries[i] = std::move(entries[i - 1]);
+			}
+			entries[0] = Entry();
+			entries[0].state = state;
+			return entries[0].lists[size_class];
+		}
+
+		static void Flush(Entry& entry)
+		{
+			if (!entry.state)
+			{
+				return;
+			}
+			for (std::size_t i = 0; i < k_size_classes; ++i)
+			{
+				List& l = entry.lists[i];
+				if (l.head)
+				{
+					entry.state->classes[i].push_batch(l.head, l.count);
+				}
+				l = List();
+			}
+			entry.state = nullptr;
+		}
+
+		Entry entries[k_cached_allocators];
+	};
+
+	void* NewDeleteTaskAllocator::allocate(std::size_t size, std::size_t alignment)
+	{
+		if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		{
+			return ::operator new(size, std::align_val_t(alignment));
+		}
+		return ::operator new(size);
+	}
+
+	void NewDeleteTaskAllocator::deallocate(void* ptr
+		, std::size_t /*size*/, std::size_t alignment) noexcept
+	{
+		if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		{
+			::operator delete(ptr, std::align_val_t(alignment));
+			return;
+		}
+		::operator delete(ptr);
+	}
+
+	/*explicit*/ MemoryResourceTaskAllocator::MemoryResourceTaskAllocator(
+		std::pmr::memory_resource& resource)
+		: resource_(&resource)
+	{
+	}
+
+	void* MemoryResourceTaskAllocator::allocate(std::size_t size, std::size_t alignment)
+	{
+		return resource_->allocate(size, alignment);
+	}
+
+	void MemoryResourceTaskAllocator::deallocate(void* ptr
+		, std::size_t size, std::size_t alignment) noexcept
+	{
+		resource_->deallocate(ptr, size, alignment);
+	}
+
+	std::pmr::memory_resource& MemoryResourceTaskAllocator::resource() const
+	{
+		return *resource_;
+	}
+
+	/*explicit*/ TaskAllocatorResource::TaskAllocatorResource(TaskAllocator& allocator)
+		: allocator_(&allocator)
+	{
+	}
+
+	TaskAllocator& TaskAllocatorResource::allocator() const
+	{
+		return *allocator_;
+	}
+
+	void* TaskAllocatorResource::do_allocate(std::size_t size, std::size_t alignment)
+	{
+		return allocator_->allocate(size, alignment);
+	}
+
+	void TaskAllocatorResource::do_deallocate(void* ptr
+		, std::size_t size, std::size_t alignment)
+	{
+		allocator_->deallocate(ptr, size, alignment);
+	}
+
+	bool TaskAllocatorResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+	{
+		return (this == &other);
+	}
+
+	/*explicit*/ PoolTaskAllocator::PoolTaskAllocator()
+		: state_(std::make_shared<State>())
+		, fallback_()
+	{
+		for (std::size_t i = 0; i < k_size_classes; ++i)
+		{
+			state_->classes[i].set_block_size((i + 1) * k_block_granularity);
+		}
+	}
+
+	PoolTaskAllocator::~PoolTaskAllocator() = default;
+
+	/*static*/ bool PoolTaskAllocator::IsPooled(std::size_t size, std::size_t alignment)
+	{
+		// Blocks of the size class are aligned by the greatest
+		// power of 2 that divides block size, up to the chunk's alignment
+		const std::size_t block_size = ((size + k_block_granularity - 1)
+			/ k_block_granularity) * k_block_granularity;
+		return (size != 0)
+			&& (size <= k_max_block_size)
+			&& (alignment <= k_max_block_alignment)
+			&& ((block_size % alignment) == 0);
+	}
+
+	/*static*/ PoolTaskAllocator::ThreadCache* PoolTaskAllocator::GetThreadCache()
+	{
+		if (t_cache_destroyed)
+		{
+			return nullptr;
+		}
+		thread_local ThreadCache t_cache;
+		return &t_cache;
+	}
+
+	void* PoolTaskAllocator::allocate(std::size_t size, std::size_t alignment)
+	{
+		if (!IsPooled(size, alignment))
+		{
+			return fallback_.allocate(size, alignment);
+		}
+		const std::size_t size_class = ((size - 1) / k_block_granularity);
+		SizeClass& shared = state_->classes[size_class];
+		ThreadCache* cache = GetThreadCache();
+		if (!cache)
+		{
+			// Thread exits: take one block, give the rest back
+			std::uint32_t count = 0;
+			FreeBlock* batch = shared.pop_batch(count);
+			if (batch->next)
+			{
+				shared.push_batch(batch->next, count - 1);
+			}
+			return batch;
+		}
+
+		ThreadCache::List& list = cache->list(state_, size_class);
+		if (!list.head)
+		{
+			list.head = shared.pop_batch(list.count);
+		}
+		FreeBlock* block = list.head;
+		list.head = block->next;
+		--list.count;
+		return block;
+	}
+
+	void PoolTaskAllocator::deallocate(void* ptr
+		, std::size_t size, std::size_t alignment) noexcept
+	{
+		if (!ptr)
+		{
+			return;
+		}
+		if (!IsPooled(size, alignment))
+		{
+			fallback_.deallocate(ptr, size, alignment);
+			return;
+		}
+		const std::size_t size_class = ((size - 1) / k_block_granularity);
+		SizeClass& shared = state_->classes[size_class];
+		FreeBlock* block = new(ptr) FreeBlock();
+		ThreadCache* cache = GetThreadCache();
+		if (!cache)
+		{
+			shared.push_batch(block, 1);
+			return;
+		}
+
+		ThreadCache::List& list = cache->list(state_, size_class);
+		block->next = list.head;
+		list.head = block;
+		if (++list.count <= k_max_cached_blocks)
+		{
+			return;
+		}
+		// Give one batch back, keep the rest
+		FreeBlock* last = list.head;
+		for (std::uint32_t i = 1; i < k_batch_blocks; ++i)
+		{
+			last = last->next;
+		}
+		FreeBlock* batch = list.head;
+		list.head = last->next;
+		list.count -= k_batch_blocks;
+		last->next = nullptr;
+		shared.push_batch(batch, k_batch_blocks);
+	}
+
+	std::size_t PoolTaskAllocator::reserved_blocks() const
+	{
+		std::size_t blocks = 0;
+		for (std::size_t i = 0; i < k_size_classes; ++i)
+		{
+			blocks += state_->classes[i].reserved_blocks();
+		}
+		return blocks;
+	}
+
+} // namespace nn
@@ -0,0 +1,324 @@
+#include <rename_me/detail/threading.h>
+
+// Not available in single-threaded build
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+
+#include <algorithm>
+#include <random>
+
+#include <cassert>
+
+namespace nn
+{
+
+	struct ThreadPoolScheduler::Worker
+	{
+		explicit Worker(ThreadPoolScheduler& owner, std::size_t index
+			, std::pmr::memory_resource& resource)
+			: owner(owner)
+			, inbox()
+			, deque(resource)
+			, in_progress(&resource)
+			, random(static_cast<std::minstd_rand::result_type>(index + 1))
+			, thread()
+		{
+		}
+
+		ThreadPoolScheduler& owner;
+		// Tasks posted to this worker from other threads
+		detail::TaskQueue inbox;
+		// Tasks owned by this worker, other workers steal from there
+		detail::WorkStealingDeque deque;
+		// Ticked, but not finished tasks during run_once()
+		std::pmr::vector<detail::ErasedTask> in_progress;
+		std::minstd_rand random;
+		std::thread thread;
+	};
+
+	namespace
+	{
+		thread_local void* t_current_worker = nullptr;
+
+		void PushTasks(detail::WorkStealingDeque& deque, detail::TaskBase* tasks)
+		{
+			while (tasks)
+			{
+				detail::TaskBase* next = tasks->next();
+				tasks->set_next(nullptr);
+				deque.push(detail::ErasedTask::attach(tasks));
+				tasks = next;
+			}
+		}
+	} // namespace
+
+	/*explicit*/ ThreadPoolScheduler::ThreadPoolScheduler(std::size_t workers_count /*= 0*/)
+		: Scheduler()
+		, workers_resource_(*std::pmr::new_delete_resource())
+		, workers_(&workers_resource_)
+		, next_worker_(0)
+		, stop_(false)
+		, sleep_guard_()
+		, work_available_()
+		, sleeping_count_(0)
+		, work_epoch_(0)
+	{
+		start(workers_count);
+	}
+
+	/*explicit*/ ThreadPoolScheduler::ThreadPoolScheduler(TaskAllocator& allocator
+		, std::size_t workers_count /*= 0*/)
+		: Scheduler(allocator)
+		, workers_resource_(*std::pmr::new_delete_resource())
+		, workers_(&workers_resource_)
+		, next_worker_(0)
+		, stop_(false)
+		, sleep_guard_()
+		, work_available_()
+		, sleeping_count_(0)
+		, work_epoch_(0)
+	{
+		start(workers_count);
+	}
+
+	/*explicit*/ ThreadPoolScheduler::ThreadPoolScheduler(std::pmr::memory_resource& resource
+		, std::size_t workers_count /*= 0*/)
+		: Scheduler(resource)
+		, workers_resource_(resource)
+		, workers_(&workers_resource_)
+		, next_worker_(0)
+		, stop_(false)
+		, sleep_guard_()
+		, work_available_()
+		, sleeping_count_(0)
+		, work_epoch_(0)
+	{
+		start(workers_count);
+	}
+
+	void ThreadPoolScheduler::start(std::size_t workers_count)
+	{
+		if (workers_count == 0)
+		{
+			workers_count = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		}
+		workers_.reserve(workers_count);
+		std::pmr::polymorphic_allocator<Worker> allocator(&workers_resource_);
+		for (std::size_t i = 0; i < workers_count; ++i)
+		{
+			Worker* worker = allocator.allocate(1);
+			allocator.construct(worker, *this, i, workers_resource_);
+			workers_.push_back(worker);
+		}
+		// Start only when all workers are created: any of them can be stolen from
+		for (Worker* worker : workers_)
+		{
+			Worker& w = *worker;
+			w.thread = std::thread([this, &w] { run(w); });
+		}
+	}
+
+	ThreadPoolScheduler::~ThreadPoolScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_guard_);
+			stop_ = true;
+		}
+		work_available_.notify_all();
+		for (Worker* worker : workers_)
+		{
+			worker->thread.join();
+		}
+		std::pmr::polymorphic_allocator<Worker> allocator(&workers_resource_);
+		for (Worker* worker : workers_)
+		{
+			allocator.destroy(worker);
+			allocator.deallocate(worker, 1);
+		}
+	}
+
+	std::size_t ThreadPoolScheduler::workers_count() const
+	{
+		return workers_.size();
+	}
+
+	std::size_t ThreadPoolScheduler::concurrency() const
+	{
+		return workers_count();
+	}
+
+	ThreadPoolScheduler::Worker* ThreadPoolScheduler::current_worker()
+	{
+		Worker* worker = static_cast<Worker*>(t_current_worker);
+		// Null if it's not a thread of this pool
+		return ((worker && (&worker->owner == this)) ? worker : nullptr);
+	}
+
+	void ThreadPoolScheduler::enqueue(detail::ErasedTask task)
+	{
+		if (Worker* worker = current_worker())
+		{
+			worker->deque.push(std::move(task));
+		}
+		else
+		{
+			const std::size_t index = (next_worker_++ % workers_.size());
+			workers_[index]->inbox.push(std::move(task));
+		}
+		notify_work();
+	}
+
+	void ThreadPoolScheduler::enqueue_ready(detail::ErasedTask task)
+	{
+		// Invoked from worker thread or from poll_timers()
+		enqueue(std::move(task));
+	}
+
+	void ThreadPoolScheduler::notify_timers()
+	{
+		// Parked worker should pick up new deadline
+		notify_work();
+		Scheduler::notify_timers();
+	}
+
+	void ThreadPoolScheduler::notify_work()
+	{
+		++work_epoch_;
+		if (sleeping_count_ > 0)
+		{
+			{
+				// Don't miss worker that checks for work under the lock
+				std::lock_guard<std::mutex> lock(sleep_guard_);
+			}
+			work_available_.notify_one();
+		}
+	}
+
+	void ThreadPoolScheduler::run(Worker& worker)
+	{
+		t_current_worker = &worker;
+		while (!stop_)
+		{
+			const std::size_t epoch = work_epoch_;
+			poll_timers();
+			const bool has_progress = run_once(worker);
+			if (!worker.in_progress.empty())
+			{
+				for (auto& task : worker.in_progress)
+				{
+					worker.deque.push(std::move(task));
+				}
+				worker.in_progress.clear();
+				if (!has_progress)
+				{
+					// Polling tasks only. Let others run
+					std::this_thread::yield();
+				}
+				continue;
+			}
+			if (has_progress || steal(worker))
+			{
+				continue;
+			}
+			if (epoch == work_epoch_)
+			{
+				park(worker, epoch);
+			}
+		}
+		t_current_worker = nullptr;
+	}
+
+	bool ThreadPoolScheduler::run_once(Worker& worker)
+	{
+		PushTasks(worker.deque, worker.inbox.pop_all());
+
+		bool has_progress = false;
+		TickCounters counters;
+		// Tasks are popped one by one so the rest can be stolen meanwhile.
+		// New tasks (and continuations) pushed while ticking are
+		// popped first
+		while (detail::ErasedTask task = worker.deque.pop())
+		{
+			if (tick_task(*task, counters) == Status::InProgress)
+			{
+				if (task->is_park_requested())
+				{
+					park_task(std::move(task));
+				}
+				else
+				{
+					worker.in_progress.push_back(std::move(task));
+				}
+				continue;
+			}
+			finish_task(*task);
+			has_progress = true;
+		}
+		flush_counters(counters);
+		return has_progress;
+	}
+
+	bool ThreadPoolScheduler::steal(Worker& worker)
+	{
+		const std::size_t count = workers_.size();
+		if (count == 1)
+		{
+			return false;
+		}
+		const std::size_t start = static_cast<std::size_t>(worker.random() % count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Worker& victim = *workers_[(start + i) % count];
+			if (&victim == &worker)
+			{
+				continue;
+			}
+			if (detail::ErasedTask task = victim.deque.steal())
+			{
+				worker.deque.push(std::move(task));
+				return true;
+			}
+			// Victim may be busy with long tick(), help with its inbox
+			if (detail::TaskBase* posted = victim.inbox.pop_all())
+			{
+				PushTasks(worker.deque, posted);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ThreadPoolScheduler::park(Worker& worker, std::size_t epoch)
+	{
+		++sleeping_count_;
+		// Last check for posted tasks after registering as sleeping:
+		// either notify_work() sees sleeping worker or we see new epoch.
+		// `epoch` is taken by run() before poll_timers(): the work
+		// posted since then (including timers that poll_timers()
+		// did not see) is not missed even if nobody was sleeping
+		// Timers that are not merged by poll_timers() yet are
+		// not seen by next_timer(): go back to poll them
+		if (worker.inbox.empty() && !has_posted_timers() && !steal(worker))
+		{
+			const auto has_work = [&]
+			{
+				return (stop_ || (work_epoch_ != epoch) || has_posted_timers());
+			};
+			std::unique_lock<std::mutex> lock(sleep_guard_);
+			const auto timer = next_timer();
+			if (timer == std::chrono::steady_clock::time_point::max())
+			{
+				work_available_.wait(lock, has_work);
+			}
+			else
+			{
+				// Wake up to expire the timer
+				(void)work_available_.wait_until(lock, timer, has_work);
+			}
+		}
+		--sleeping_count_;
+	}
+
+} // namespace nn
+
+#endif // !(NN_SINGLE_THREADED)
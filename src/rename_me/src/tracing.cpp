@@ -0,0 +1,347 @@
+#include <rename_me/tracing.h>
+#include <rename_me/detail/trace.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+
+#include <cstdio>
+#include <cassert>
+
+namespace nn
+{
+	namespace
+	{
+		// Single-writer ring buffer of the thread
+		struct ThreadTraceBuffer
+		{
+			explicit ThreadTraceBuffer(std::uint32_t tid)
+				: tid(tid)
+				, events(k_trace_buffer_events)
+				, head(0)
+				, tail(0)
+			{
+			}
+
+			const std::uint32_t tid;
+			std::vector<detail::TraceEvent> events;
+			// Number of events ever written
+			std::atomic<std::uint64_t> head;
+			// Number of events written by write_trace()
+			std::uint64_t tail;
+		};
+
+		static_assert((k_trace_buffer_events & (k_trace_buffer_events - 1)) == 0
+			, "Ring buffer size should be power of 2");
+
+		struct TraceRegistry
+		{
+			std::atomic<bool> enabled{false};
+			std::mutex guard;
+			// Buffers are kept after thread exit
+			std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;
+		};
+
+		TraceRegistry& GetRegistry()
+		{
+			static TraceRegistry registry;
+			return registry;
+		}
+
+		ThreadTraceBuffer& GetThreadBuffer()
+		{
+			thread_local std::shared_ptr<ThreadTraceBuffer> t_buffer;
+			if (!t_buffer)
+			{
+				TraceRegistry& registry = GetRegistry();
+				std::lock_guard<std::mutex> lock(registry.guard);
+				const auto tid = static_cast<std::uint32_t>(registry.buffers.size() + 1);
+				t_buffer = std::make_shared<ThreadTraceBuffer>(tid);
+				registry.buffers.push_back(t_buffer);
+			}
+			return *t_buffer;
+		}
+
+		struct ThreadEvent
+		{
+			detail::TraceEvent event;
+			std::uint32_t tid;
+		};
+
+		const char* StatusName(Status status)
+		{
+			switch (status)
+			{
+			case Status::InProgress: return "InProgress";
+			case Status::Successful: return "Successful";
+			case Status::Failed:     return "Failed";
+			case Status::Canceled:   return "Canceled";
+			}
+			return "";
+		}
+
+		// Writes JSON string. Type names may contain quotes or backslashes
+		void WriteString(std::ostream& out, const char* str)
+		{
+			out << '"';
+			for (; str && *str; ++str)
+			{
+				const char c = *str;
+				if ((c == '"') || (c == '\\'))
+				{
+					out << '\\' << c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20)
+				{
+					out << ' ';
+				}
+				else
+				{
+					out << c;
+				}
+			}
+			out << '"';
+		}
+
+		class TraceWriter
+		{
+		public:
+			explicit TraceWriter(std::ostream& out, std::int64_t start_time)
+				: out_(out)
+				, start_time_(start_time)
+				, first_(true)
+			{
+			}
+
+			// Common fields of the event: {"ph":..,"ts":..,"pid":1,"tid":..
+			// The caller adds the rest and closes the object
+			std::ostream& begin(char phase, std::int64_t time, std::uint32_t tid)
+			{
+				out_ << (first_ ? "\n" : ",\n");
+				first_ = false;
+				char ts[32];
+				std::snprintf(ts, sizeof(ts), "%.3f"
+					, static_cast<double>(time - start_time_) / 1000.0);
+				out_ << "{\"ph\":\"" << phase << "\",\"ts\":" << ts
+					<< ",\"pid\":1,\"tid\":" << tid;
+				return out_;
+			}
+
+			std::ostream& duration(std::int64_t duration)
+			{
+				char dur[32];
+				std::snprintf(dur, sizeof(dur), "%.3f"
+					, static_cast<double>(duration) / 1000.0);
+				out_ << ",\"dur\":" << dur;
+				return out_;
+			}
+
+		private:
+			std::ostream& out_;
+			const std::int64_t start_time_;
+			bool first_;
+		};
+
+		// Task's lifetime as it's seen from the events
+		struct TaskTrace
+		{
+			std::uint64_t id = 0;
+			bool finished = false;
+			bool ticked = false;
+			// Flow from the parent was started
+			bool has_flow = false;
+			std::vector<std::uint64_t> continuations;
+		};
+	} // namespace
+
+	namespace detail
+	{
+		bool IsTracing()
+		{
+			return GetRegistry().enabled.load(std::memory_order_relaxed);
+		}
+
+		std::int64_t TraceNow()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		void RecordTraceEvent(const TraceEvent& event)
+		{
+			ThreadTraceBuffer& buffer = GetThreadBuffer();
+			const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+			buffer.events[head & (k_trace_buffer_events - 1)] = event;
+			buffer.head.store(head + 1, std::memory_order_release);
+		}
+	} // namespace detail
+
+	void start_tracing()
+	{
+		GetRegistry().enabled = true;
+	}
+
+	void stop_tracing()
+	{
+		GetRegistry().enabled = false;
+	}
+
+	bool is_tracing()
+	{
+		return detail::IsTracing();
+	}
+
+	void write_trace(std::ostream& out)
+	{
+		std::vector<ThreadEvent> events;
+		std::vector<std::uint32_t> tids;
+		{
+			TraceRegistry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.guard);
+			for (auto& buffer : registry.buffers)
+			{
+				const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+				const std::uint64_t first = std::max(buffer->tail
+					, (head > k_trace_buffer_events) ? (head - k_trace_buffer_events) : 0);
+				for (std::uint64_t i = first; i < head; ++i)
+				{
+					events.push_back(ThreadEvent{
+						buffer->events[i & (k_trace_buffer_events - 1)], buffer->tid});
+				}
+				buffer->tail = head;
+				tids.push_back(buffer->tid);
+			}
+		}
+		std::stable_sort(events.begin(), events.end()
+			, [](const ThreadEvent& lhs, const ThreadEvent& rhs)
+		{
+			return (lhs.event.time < rhs.event.time);
+		});
+
+		out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		TraceWriter writer(out, events.empty() ? 0 : events.front().event.time);
+		for (std::uint32_t tid : tids)
+		{
+			writer.begin('M', events.empty() ? 0 : events.front().event.time, tid)
+				<< ",\"name\":\"thread_name\",\"args\":{\"name\":\"thread " << tid << "\"}}";
+		}
+
+		std::unordered_map<const void*, TaskTrace> tasks;
+		std::uint64_t last_id = 0;
+		// Tasks that were created before tracing started get id on first use
+		const auto get_task = [&](const void* task) -> TaskTrace&
+		{
+			TaskTrace& trace = tasks[task];
+			if (trace.id == 0)
+			{
+				trace.id = ++last_id;
+			}
+			return trace;
+		};
+		const auto start_flow = [&](TaskTrace& parent, std::int64_t time, std::uint32_t tid)
+		{
+			for (std::uint64_t id : parent.continuations)
+			{
+				writer.begin('s', time, tid)
+					<< ",\"name\":\"on_finish\",\"cat\":\"flow\",\"id\":" << id << "}";
+			}
+			parent.continuations.clear();
+		};
+		const auto finish = [&](const void* task, TaskTrace& trace
+			, std::int64_t time, std::uint32_t tid, Status status)
+		{
+			writer.begin('e', time, tid)
+				<< ",\"name\":\"task\",\"cat\":\"task\",\"id\":" << trace.id
+				<< ",\"args\":{\"status\":\"" << StatusName(status) << "\"}}";
+			trace.finished = true;
+			start_flow(trace, time, tid);
+			// Address may be reused by other task
+			tasks.erase(task);
+		};
+
+		for (const ThreadEvent& thread_event : events)
+		{
+			const detail::TraceEvent& e = thread_event.event;
+			const std::uint32_t tid = thread_event.tid;
+			switch (e.type)
+			{
+			case detail::TraceEventType::Create:
+			{
+				// New task with, possibly, reused address
+				TaskTrace& trace = tasks[e.object];
+				trace = TaskTrace();
+				trace.id = ++last_id;
+				writer.begin('b', e.time, tid)
+					<< ",\"name\":\"task\",\"cat\":\"task\",\"id\":" << trace.id
+					<< ",\"args\":{\"type\":";
+				WriteString(out, static_cast<const char*>(e.other));
+				out << "}}";
+				if (e.status != Status::InProgress)
+				{
+					finish(e.object, trace, e.time, tid, e.status);
+				}
+				break;
+			}
+			case detail::TraceEventType::Tick:
+			{
+				TaskTrace& trace = get_task(e.object);
+				if (!trace.ticked && trace.has_flow)
+				{
+					writer.begin('f', e.time, tid)
+						<< ",\"name\":\"on_finish\",\"cat\":\"flow\",\"bp\":\"e\",\"id\":"
+						<< trace.id << "}";
+				}
+				trace.ticked = true;
+				writer.begin('X', e.time, tid)
+					<< ",\"name\":\"tick\",\"cat\":\"task\"";
+				writer.duration(e.duration)
+					<< ",\"args\":{\"task\":" << trace.id
+					<< ",\"status\":\"" << StatusName(e.status) << "\"}}";
+				if (e.status != Status::InProgress)
+				{
+					finish(e.object, trace, e.time + e.duration, tid, e.status);
+				}
+				break;
+			}
+			case detail::TraceEventType::Cancel:
+			{
+				TaskTrace& trace = get_task(e.object);
+				writer.begin('i', e.time, tid)
+					<< ",\"name\":\"try_cancel\",\"cat\":\"task\",\"s\":\"t\""
+					<< ",\"args\":{\"task\":" << trace.id << "}}";
+				break;
+			}
+			case detail::TraceEventType::Continuation:
+			{
+				TaskTrace& continuation = get_task(e.other);
+				continuation.has_flow = true;
+				const auto parent = tasks.find(e.object);
+				if (parent == tasks.end())
+				{
+					// Parent finished already
+					writer.begin('s', e.time, tid)
+						<< ",\"name\":\"on_finish\",\"cat\":\"flow\",\"id\":"
+						<< continuation.id << "}";
+				}
+				else
+				{
+					parent->second.continuations.push_back(continuation.id);
+				}
+				break;
+			}
+			case detail::TraceEventType::Poll:
+				writer.begin('X', e.time, tid)
+					<< ",\"name\":\"poll\",\"cat\":\"scheduler\"";
+				writer.duration(e.duration)
+					<< ",\"args\":{\"ticks\":" << e.count << "}}";
+				break;
+			}
+		}
+		out << "\n]}\n";
+	}
+
+} // namespace nn
@@ -0,0 +1,111 @@
+#include <rename_me/detail/when_task_base.h>
+
+#include <new>
+
+namespace nn
+{
+	namespace detail
+	{
+
+		/*static*/ ErasedTask WhenWaiter::Make(Scheduler& scheduler
+			, WhenLatch& latch, std::size_t index)
+		{
+			void* memory = AllocateTask(scheduler, sizeof(WhenWaiter), alignof(WhenWaiter));
+			return ErasedTask::attach(new(memory) WhenWaiter(scheduler, latch, index));
+		}
+
+		/*explicit*/ WhenWaiter::WhenWaiter(Scheduler& scheduler
+			, WhenLatch& latch, std::size_t index)
+			: TaskBase(scheduler)
+			, latch_(latch)
+			, index_(index)
+		{
+			set_inline_continuation();
+		}
+
+		Status WhenWaiter::update()
+		{
+			latch_.arrive(index_);
+			last_run_ = Status::Successful;
+			return Status::Successful;
+		}
+
+		void WhenWaiter::destroy() noexcept
+		{
+			WhenLatch& latch = latch_;
+			Scheduler& scheduler = TaskBase::scheduler();
+			this->~WhenWaiter();
+			DeallocateTask(scheduler, this, sizeof(WhenWaiter), alignof(WhenWaiter));
+			// May destroy the latch
+			latch.release();
+		}
+
+		/*explicit*/ WhenLatch::WhenLatch(Scheduler& scheduler, std::size_t count, bool any)
+			: scheduler_(scheduler)
+			, owner_(nullptr)
+			, count_(count)
+			, any_(any)
+			, remaining_(count)
+			, first_(k_none)
+		{
+		}
+
+		std::size_t WhenLatch::first() const
+		{
+			return first_.load(std::memory_order_acquire);
+		}
+
+		bool WhenLatch::cancel_requested() const
+		{
+			const TaskBase* owner = owner_.load(std::memory_order_acquire);
+			return (owner && owner->cancel_requested());
+		}
+
+		void WhenLatch::start(TaskBase& owner)
+		{
+			assert(!owner_);
+			owner_.store(&owner, std::memory_order_release);
+			if (count_ == 0)
+			{
+				owner.add_ref_count();
+				PostTask(scheduler_, ErasedTask::attach(&owner));
+			}
+		}
+
+		void WhenLatch::wait_task(std::size_t index, TaskBase* task)
+		{
+			assert(owner_ && (index < count_));
+			if (!task || (task->status() != Status::InProgress))
+			{
+				arrive(index);
+				return;
+			}
+			ErasedTask waiter = WhenWaiter::Make(scheduler_, *this, index);
+			// Continuations inherit priority of the parent task
+			waiter->set_priority(task->priority());
+			owner_.load(std::memory_order_relaxed)->add_ref_count();
+			PostTaskAfter(scheduler_, *task, std::move(waiter));
+		}
+
+		void WhenLatch::arrive(std::size_t index)
+		{
+			const std::size_t remaining = remaining_.fetch_sub(1, std::memory_order_acq_rel);
+			assert(remaining > 0);
+			const bool open = (any_ ? (remaining == count_) : (remaining == 1));
+			if (!open)
+			{
+				return;
+			}
+			first_.store(index, std::memory_order_release);
+			TaskBase* owner = owner_.load(std::memory_order_relaxed);
+			owner->add_ref_count();
+			PostTask(scheduler_, ErasedTask::attach(owner));
+		}
+
+		void WhenLatch::release() noexcept
+		{
+			(void)ErasedTask::attach(owner_.load(std::memory_order_relaxed));
+		}
+
+	} // namespace detail
+} // namespace nn
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <memory_resource>
 
 #include <cassert>
 
@@ -13,7 +14,8 @@ namespace nn
 	namespace curl
 	{
 
-		using Buffer = std::vector<char>;
+		// Allocated from Scheduler::memory_resource()
+		using Buffer = std::pmr::vector<char>;
 
 		struct CurlGet
 		{
@@ -48,7 +50,7 @@ namespace nn
 			class CurlTask
 			{
 			public:
-				explicit CurlTask(CurlGet&& curl_get);
+				explicit CurlTask(CurlGet&& curl_get, std::pmr::memory_resource& resource);
 				~CurlTask();
 
 				bool setup(const CurlGet& options);
@@ -76,7 +78,8 @@ namespace nn
 			Scheduler& scheduler, CurlGet curl_get)
 		{
 			using Task = Task<Buffer, CurlError>;
-			return Task::template make<detail::CurlTask>(scheduler, std::move(curl_get));
+			return Task::template make<detail::CurlTask>(scheduler
+				, std::move(curl_get), scheduler.memory_resource());
 		}
 
 	} // namespace curl
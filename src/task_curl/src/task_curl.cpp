@@ -1,7 +1,7 @@
 #include <task_curl/task_curl.h>
 
-nn::curl::detail::CurlTask::CurlTask(CurlGet&& curl_get)
-	: buffer_()
+nn::curl::detail::CurlTask::CurlTask(CurlGet&& curl_get, std::pmr::memory_resource& resource)
+	: buffer_(&resource)
 	, data_()
 	, multi_handle_(nullptr)
 	, request_(nullptr)
@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include <rename_me/channel.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+
+#include "test_tools.h"
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+using namespace nn;
+
+TEST(Channel, Buffered_Operations_Are_Ready)
+{
+	Scheduler sch;
+	Channel<int> channel(sch, 2);
+	ASSERT_TRUE(channel.send(1).is_successful());
+	ASSERT_TRUE(channel.send(2).is_successful());
+	ASSERT_EQ(2u, channel.size());
+	// Nothing is posted
+	ASSERT_EQ(0u, sch.tasks_count());
+
+	auto task = channel.receive();
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(1, task.get().value());
+	ASSERT_EQ(1u, channel.size());
+}
+
+TEST(Channel, Waiting_Receiver_Is_Not_Polled)
+{
+	Scheduler sch;
+	Channel<std::unique_ptr<int>> channel(sch, 4);
+	auto task = channel.receive();
+	ASSERT_TRUE(task.is_in_progress());
+	for (int i = 0; i < 5; ++i)
+	{
+		ASSERT_EQ(0u, sch.poll());
+	}
+	ASSERT_EQ(0u, sch.stats().ticks);
+	// Not polled, but counted
+	ASSERT_EQ(1u, sch.tasks_count());
+
+	// Value goes to the receiver, not to the ring
+	ASSERT_TRUE(channel.send(std::make_unique<int>(5)).is_successful());
+	ASSERT_EQ(0u, channel.size());
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(5, *task.get().value());
+	ASSERT_EQ(1u, sch.stats().ticks);
+}
+
+TEST(Channel, Full_Channel_Makes_Sender_Wait)
+{
+	Scheduler sch;
+	Channel<int> channel(sch, 1);
+	ASSERT_TRUE(channel.send(1).is_successful());
+	auto second = channel.send(2);
+	auto third = channel.send(3);
+	ASSERT_TRUE(second.is_in_progress());
+	(void)sch.poll();
+	ASSERT_TRUE(second.is_in_progress());
+
+	ASSERT_EQ(1, channel.receive().get().value());
+	// Value of the first waiting sender took the room
+	ASSERT_EQ(1u, channel.size());
+	sch.run_until(second);
+	ASSERT_TRUE(second.is_successful());
+	ASSERT_TRUE(third.is_in_progress());
+	ASSERT_EQ(2, channel.receive().get().value());
+	ASSERT_EQ(3, channel.receive().get().value());
+	sch.run_until(third);
+	ASSERT_TRUE(third.is_successful());
+}
+
+TEST(Channel, Receive_Many_Takes_Buffered_Values)
+{
+	Scheduler sch;
+	Channel<int> channel(sch, 8);
+	for (int i = 0; i < 5; ++i)
+	{
+		(void)channel.send(i);
+	}
+	auto first = channel.receive_many(3);
+	ASSERT_TRUE(first.is_successful());
+	ASSERT_EQ((std::vector<int>{0, 1, 2}), first.get().value());
+	auto rest = channel.receive_many(10);
+	ASSERT_EQ((std::vector<int>{3, 4}), rest.get().value());
+
+	auto waiting = channel.receive_many(10);
+	ASSERT_TRUE(waiting.is_in_progress());
+	(void)channel.send(5);
+	sch.run_until(waiting);
+	ASSERT_EQ((std::vector<int>{5}), waiting.get().value());
+}
+
+TEST(Channel, Close_Fails_Waiting_Operations)
+{
+	Scheduler sch;
+	Channel<int> channel(sch, 1);
+	auto receiver = channel.receive();
+	channel.close();
+	sch.run_until(receiver);
+	ASSERT_EQ(Status::Failed, receiver.status());
+	ASSERT_EQ(Status::Failed, channel.send(1).status());
+
+	Channel<int> full(sch, 1);
+	(void)full.send(1);
+	auto sender = full.send(2);
+	full.close();
+	sch.run_until(sender);
+	ASSERT_EQ(Status::Failed, sender.status());
+	// Buffered value is still there
+	ASSERT_EQ(1, full.receive().get().value());
+	ASSERT_EQ(Status::Failed, full.receive().status());
+	ASSERT_EQ(Status::Failed, full.receive_many(2).status());
+}
+
+TEST(Channel, Waiting_Operation_Can_Be_Dropped)
+{
+	Scheduler sch;
+	{
+		Channel<int> channel(sch, 1);
+		(void)channel.receive();
+		(void)channel.send(1);
+		(void)channel.receive();
+	}
+	sch.run_until_idle();
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(Channel, Consumer_Can_Rearm_From_Continuation)
+{
+	Scheduler sch;
+	const int k_capacity = 100'000;
+	Channel<int> channel(sch, k_capacity);
+	std::vector<Task<void, void>> senders;
+	senders.reserve(k_capacity);
+	for (int i = 0; i < 2 * k_capacity; ++i)
+	{
+		auto task = channel.send(1);
+		if (task.is_in_progress())
+		{
+			senders.push_back(std::move(task));
+		}
+	}
+	ASSERT_EQ(std::size_t(k_capacity), senders.size());
+
+	// Every receive() is ready: continuations are not
+	// invoked recursively without limit
+	int received = 0;
+	std::function<void ()> receive = [&]
+	{
+		(void)channel.receive().then([&](const Task<int>& task)
+		{
+			if (task.is_successful())
+			{
+				received += task.get().value();
+				receive();
+			}
+		});
+	};
+	receive();
+	while (received < (2 * k_capacity))
+	{
+		(void)sch.poll();
+	}
+	channel.close();
+	sch.run_until_idle();
+	ASSERT_EQ(2 * k_capacity, received);
+}
+
+#if !(NN_SINGLE_THREADED)
+TEST(Channel, Run_Until_Idle_Waits_For_Value_From_Other_Thread)
+{
+	Scheduler sch;
+	Channel<int> channel(sch, 1);
+	int received = 0;
+	(void)channel.receive().then([&](const Task<int>& task)
+	{
+		received = task.get().value();
+	});
+	std::thread producer([&]
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		(void)channel.send(5);
+	});
+	sch.run_until_idle();
+	producer.join();
+	ASSERT_EQ(5, received);
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(Channel, Works_With_Many_Producers)
+{
+	ThreadPoolScheduler sch(2);
+	Channel<int> channel(sch, 16);
+	const int k_values = 1000;
+	auto produce = [&]
+	{
+		for (int i = 1; i <= k_values; ++i)
+		{
+			auto task = channel.send(i);
+			while (task.is_in_progress())
+			{
+				std::this_thread::yield();
+			}
+		}
+	};
+	std::thread first(produce);
+	std::thread second(produce);
+	long long sum = 0;
+	int received = 0;
+	while (received < (2 * k_values))
+	{
+		auto task = channel.receive_many(8);
+		sch.run_until(task);
+		ASSERT_TRUE(task.is_successful());
+		for (int value : task.get().value())
+		{
+			sum += value;
+			++received;
+		}
+	}
+	first.join();
+	second.join();
+	ASSERT_EQ(2 * k_values, received);
+	ASSERT_EQ(2LL * k_values * (k_values + 1) / 2, sum);
+}
+#endif
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <rename_me/delay_task.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+#include <rename_me/function_task.h>
+
+#include "test_tools.h"
+
+#include <vector>
+#include <chrono>
+#include <thread>
+
+using namespace nn;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Counts ticks to check that sleeping task is not ticked
+	struct TimerTask
+	{
+		explicit TimerTask(Clock::time_point deadline, int& ticks)
+			: timer_(deadline)
+			, ticks_(ticks)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext& context)
+		{
+			++ticks_;
+			if (context.cancel_requested)
+			{
+				data_ = MakeExpectedWithDefaultError<expected<void, void>>();
+				return Status::Canceled;
+			}
+			return Status::Successful;
+		}
+
+		expected<void, void>& get()
+		{
+			return data_;
+		}
+
+		detail::TimerNode& timer()
+		{
+			return timer_;
+		}
+
+		detail::TimerNode timer_;
+		int& ticks_;
+		expected<void, void> data_;
+	};
+} // namespace
+
+TEST(DelayTask, Finishes_Successfully_Not_Earlier_Then_Delay)
+{
+	Scheduler sch;
+	const auto start = Clock::now();
+	Task<> task = make_delay_task(sch, std::chrono::milliseconds(20));
+	ASSERT_TRUE(task.is_in_progress());
+	ASSERT_EQ(std::size_t(1), sch.tasks_count());
+	sch.run_until(task);
+	ASSERT_LE(std::chrono::milliseconds(20), Clock::now() - start);
+	ASSERT_EQ(Status::Successful, task.status());
+	ASSERT_TRUE(task.get().has_value());
+	ASSERT_FALSE(sch.has_tasks());
+}
+
+TEST(DelayTask, Sleeping_Task_Is_Not_Ticked)
+{
+	Scheduler sch;
+	int ticks = 0;
+	// Far deadline: polls can't reach it however slow they are
+	Task<> task = Task<>::make<TimerTask>(sch
+		, Clock::now() + std::chrono::hours(1), ticks);
+	for (int i = 0; i < 100; ++i)
+	{
+		ASSERT_EQ(std::size_t(0), sch.poll());
+	}
+	ASSERT_EQ(0, ticks);
+	ASSERT_TRUE(task.is_in_progress());
+	task.try_cancel();
+	sch.run_until(task);
+	ASSERT_EQ(1, ticks);
+	ASSERT_EQ(Status::Canceled, task.status());
+
+	// Ticked once the deadline expires
+	int expired_ticks = 0;
+	Task<> expired = Task<>::make<TimerTask>(sch
+		, Clock::now() + std::chrono::milliseconds(10), expired_ticks);
+	sch.run_until(expired);
+	ASSERT_EQ(1, expired_ticks);
+	ASSERT_EQ(Status::Successful, expired.status());
+}
+
+TEST(DelayTask, Deadline_In_The_Past_Expires_On_Next_Poll)
+{
+	Scheduler sch;
+	Task<> task = make_delay_task(sch, Clock::now() - std::chrono::seconds(1));
+	ASSERT_EQ(std::size_t(1), sch.poll());
+	ASSERT_EQ(Status::Successful, task.status());
+}
+
+TEST(DelayTask, Cancel_Finishes_Task_Without_Waiting)
+{
+	Scheduler sch;
+	const auto start = Clock::now();
+	Task<> task = make_delay_task(sch, std::chrono::hours(1));
+	(void)sch.poll();
+	task.try_cancel();
+	sch.run_until(task);
+	ASSERT_GT(std::chrono::minutes(1), Clock::now() - start);
+	ASSERT_EQ(Status::Canceled, task.status());
+	ASSERT_FALSE(task.get().has_value());
+	ASSERT_FALSE(sch.has_tasks());
+}
+
+TEST(DelayTask, Cancel_Before_First_Poll)
+{
+	Scheduler sch;
+	Task<> task = make_delay_task(sch, std::chrono::hours(1));
+	task.try_cancel();
+	ASSERT_EQ(std::size_t(1), sch.poll());
+	ASSERT_EQ(Status::Canceled, task.status());
+}
+
+TEST(DelayTask, Cancel_After_Finish_Is_Ignored)
+{
+	Scheduler sch;
+	Task<> task = make_delay_task(sch, std::chrono::milliseconds(1));
+	sch.run_until(task);
+	task.try_cancel();
+	ASSERT_EQ(std::size_t(0), sch.poll());
+	ASSERT_EQ(Status::Successful, task.status());
+}
+
+TEST(DelayTask, Timeout_Task_Fails_On_Deadline)
+{
+	Scheduler sch;
+	Task<> task = make_timeout_task(sch, std::chrono::milliseconds(5));
+	sch.run_until(task);
+	ASSERT_EQ(Status::Failed, task.status());
+	ASSERT_FALSE(task.get().has_value());
+}
+
+TEST(DelayTask, Continuation_Is_Invoked_When_Timer_Expires)
+{
+	Scheduler sch;
+	Task<int> task = make_delay_task(sch, std::chrono::milliseconds(5))
+		.then([] { return 42; });
+	sch.run_until(task);
+	ASSERT_EQ(42, task.get().value());
+}
+
+TEST(DelayTask, Timers_Expire_In_Deadline_Order)
+{
+	Scheduler sch;
+	std::vector<int> order;
+	std::vector<Task<>> tasks;
+	const int k_delays_ms[] = {30, 10, 70, 1, 20, 0, 130};
+	for (int delay : k_delays_ms)
+	{
+		tasks.push_back(make_delay_task(sch, std::chrono::milliseconds(delay))
+			.then([&order, delay] { order.push_back(delay); }));
+	}
+	sch.run_until_idle();
+	ASSERT_EQ(std::vector<int>({0, 1, 10, 20, 30, 70, 130}), order);
+}
+
+#if !(NN_SINGLE_THREADED)
+TEST(DelayTask, Works_With_Thread_Pool)
+{
+	ThreadPoolScheduler sch(2);
+	const auto start = Clock::now();
+	std::vector<Task<>> tasks;
+	for (int i = 0; i < 50; ++i)
+	{
+		tasks.push_back(make_delay_task(sch, std::chrono::milliseconds(i % 10)));
+	}
+	Task<> canceled = make_delay_task(sch, std::chrono::hours(1));
+	canceled.try_cancel();
+	for (const Task<>& task : tasks)
+	{
+		sch.run_until(task);
+		ASSERT_EQ(Status::Successful, task.status());
+	}
+	sch.run_until(canceled);
+	ASSERT_EQ(Status::Canceled, canceled.status());
+	ASSERT_LE(std::chrono::milliseconds(9), Clock::now() - start);
+}
+
+TEST(DelayTask, Thread_Pool_Wakes_Up_For_Timer_Posted_From_Other_Thread)
+{
+	ThreadPoolScheduler sch(2);
+	for (int i = 0; i < 500; ++i)
+	{
+		// Let workers park
+		std::this_thread::sleep_for(std::chrono::microseconds(i % 200));
+		Task<> task;
+		std::thread post([&]
+		{
+			task = make_delay_task(sch, std::chrono::microseconds(100));
+		});
+		post.join();
+		// Not run_until(): lost wake up should fail, not hang
+		const auto deadline = Clock::now() + std::chrono::seconds(5);
+		while (task.is_in_progress() && (Clock::now() < deadline))
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+		ASSERT_EQ(Status::Successful, task.status()) << "iteration " << i;
+	}
+}
+#endif
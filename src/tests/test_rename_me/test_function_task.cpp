@@ -89,8 +89,18 @@ namespace
 		Status tick(const ExecutionContext&) { return Status::Successful; }
 		expected<void, void>& get() { return *this; }
 	};
+#  if (NN_CACHE_LINE_SIZE > 0)
+	// Hot state and state shared with other threads take
+	// own cache lines (see TaskBase), EBOTask goes to the next one
 	static_assert(sizeof(detail::InternalCustomTask<void, void, EBOTask>)
-		== 4 * sizeof(void*), "");
+		== 3 * NN_CACHE_LINE_SIZE, "");
+#  else
+	// virtual pointer + status and timer offset + Scheduler& +
+	// intrusive link + timestamps + 32-bit reference count +
+	// continuations list + EBOTask
+	static_assert(sizeof(detail::InternalCustomTask<void, void, EBOTask>)
+		== 7 * sizeof(void*) + sizeof(detail::TaskBase::Timestamps), "");
+#  endif
 #endif
 
 	// Test-controlled task
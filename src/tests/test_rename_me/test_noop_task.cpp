@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
 #include <rename_me/noop_task.h>
+#include <rename_me/function_task.h>
 
 #include "test_tools.h"
 
+#include <memory>
+#include <functional>
+
 using namespace nn;
 
 namespace
@@ -112,3 +116,178 @@ TEST(Noop, Expexted_With_Void_Error)
 	ASSERT_FALSE(task.get().has_value());
 }
 
+
+TEST(Noop, Ready_Task_Is_Not_Allocated)
+{
+	CountingAllocator allocator;
+	Scheduler sch(allocator);
+	Task<int> task = make_task(success, sch, 1);
+	Task<void, int> error_task = make_task(error, sch, 2);
+	Task<int, int> expected_task = make_task(sch, expected<int, int>(3));
+	ASSERT_EQ(0, allocator.allocations);
+	ASSERT_FALSE(sch.has_tasks());
+	ASSERT_EQ(&sch, &task.scheduler());
+	ASSERT_EQ(Priority::Normal, task.priority());
+	task.try_cancel();
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_FALSE(task.is_canceled());
+	ASSERT_EQ(2, error_task.get().error());
+	ASSERT_EQ(3, expected_task.get().value());
+}
+
+TEST(Noop, Then_Of_Ready_Task_Is_Invoked_Immediately_From_Tick)
+{
+	CountingAllocator allocator;
+	Scheduler sch(allocator);
+	int allocations = -1;
+	Task<int> outer = make_task(sch, [&]
+	{
+		const int before = allocator.allocations;
+		Task<int> task = make_task(success, sch, 1)
+			.then([](const Task<int>& self) { return self.get().value() + 1; })
+			.then([](const Task<int>& self) { return expected<int, void>(self.get().value() + 1); })
+			.then([&sch](const Task<int>& self) { return make_task(success, sch, self.get().value() + 1); });
+		bool called = false;
+		Task<> discard = make_task(error, sch).then([&] { called = true; });
+		allocations = (allocator.allocations - before);
+		return ((called && discard.is_successful()) ? task.get().value() : -1);
+	});
+	sch.run_until(outer);
+	ASSERT_EQ(4, outer.get().value());
+	ASSERT_EQ(0, allocations);
+}
+
+TEST(Noop, Then_Of_Ready_Task_Outside_Of_Tick_Is_Posted)
+{
+	Scheduler sch;
+	bool called = false;
+	Task<int> task = make_task(success, sch, 1)
+		.then([&](const Task<int>& self) { called = true; return self.get().value() + 1; });
+	ASSERT_FALSE(called);
+	ASSERT_TRUE(task.is_in_progress());
+	sch.run_until(task);
+	ASSERT_TRUE(called);
+	ASSERT_EQ(2, task.get().value());
+}
+
+TEST(Noop, Then_Of_Ready_Task_Outside_Of_Tick_Allocates_Continuation_Only)
+{
+	CountingAllocator allocator;
+	Scheduler sch(allocator);
+	Task<int> ready = make_task(success, sch, 1);
+	Task<int> first = ready.then([](const Task<int>& self) { return self.get().value() + 1; });
+	ASSERT_EQ(1, allocator.allocations);
+	Task<int> second = ready.on_success([](const Task<int>& self) { return self.get().value() + 2; });
+	ASSERT_EQ(2, allocator.allocations);
+	sch.run_until(first);
+	sch.run_until(second);
+	ASSERT_EQ(2, first.get().value());
+	ASSERT_EQ(3, second.get().value());
+	// Value is still available thru the parent
+	ASSERT_EQ(1, ready.get().value());
+}
+
+TEST(Noop, Then_Of_Ready_Task_Outside_Of_Tick_Does_Not_Copy_Value)
+{
+	struct CopyCounter
+	{
+		int* copies;
+
+		explicit CopyCounter(int* copies_)
+			: copies(copies_)
+		{
+		}
+
+		CopyCounter(const CopyCounter& rhs)
+			: copies(rhs.copies)
+		{
+			++*copies;
+		}
+
+		CopyCounter(CopyCounter&& rhs) = default;
+	};
+
+	CountingAllocator allocator;
+	Scheduler sch(allocator);
+	int copies = 0;
+	Task<CopyCounter> ready = make_task(success, sch, CopyCounter(&copies));
+	const int copies_before = copies;
+	const auto is_same = [&](const Task<CopyCounter>& self)
+	{
+		return (self.get().value().copies == &copies);
+	};
+	Task<bool> first = ready.then(is_same);
+	// Task internals to share the value and the continuation
+	ASSERT_EQ(2, allocator.allocations);
+	Task<bool> second = ready.then(is_same);
+	ASSERT_EQ(3, allocator.allocations);
+	sch.run_until(first);
+	sch.run_until(second);
+	ASSERT_TRUE(first.get().value());
+	ASSERT_TRUE(second.get().value());
+	ASSERT_EQ(copies_before, copies);
+}
+
+TEST(Noop, Continuation_Can_Be_Rearmed_Many_Times)
+{
+	Scheduler sch;
+	const int k_count = 1'000'000;
+	int count = 0;
+	std::function<void ()> rearm = [&]
+	{
+		(void)make_task(success, sch, 1).then([&](const Task<int>& self)
+		{
+			count += self.get().value();
+			if (count < k_count)
+			{
+				rearm();
+			}
+		});
+	};
+	(void)make_task(sch, rearm);
+	sch.run_until_idle();
+	ASSERT_EQ(k_count, count);
+}
+
+TEST(Noop, On_Success_Of_Failed_Ready_Task_Is_Canceled)
+{
+	Scheduler sch;
+	bool called = false;
+	Task<> task = make_task(error, sch, 1).on_success([&] { called = true; });
+	ASSERT_FALSE(called);
+	ASSERT_TRUE(task.is_canceled());
+	ASSERT_FALSE(task.get().has_value());
+}
+
+TEST(Noop, Then_Of_Ready_Task_With_Other_Scheduler_Is_Posted)
+{
+	Scheduler sch;
+	Scheduler other;
+	Task<std::unique_ptr<int>> task = make_task(success, sch, std::make_unique<int>(1));
+	Task<int> continuation = task.then(other
+		, [](const Task<std::unique_ptr<int>>& self) { return *self.get().value() + 1; });
+	ASSERT_TRUE(continuation.is_in_progress());
+	ASSERT_EQ(0u, sch.poll());
+	ASSERT_EQ(1u, other.poll());
+	ASSERT_EQ(2, continuation.get().value());
+	// Value is still available thru the parent
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(1, *task.get().value());
+}
+
+TEST(Noop, Ready_Task_Is_Moved_With_Its_Value)
+{
+	Scheduler sch;
+	Task<std::unique_ptr<int>> task = make_task(success, sch, std::make_unique<int>(5));
+	Task<std::unique_ptr<int>> moved(std::move(task));
+	ASSERT_FALSE(task.is_valid());
+	ASSERT_TRUE(moved.is_valid());
+	ASSERT_EQ(5, *moved.get().value());
+
+	Task<std::unique_ptr<int>> assigned;
+	assigned = std::move(moved);
+	ASSERT_FALSE(moved.is_valid());
+	ASSERT_EQ(5, *assigned.get().value());
+	std::unique_ptr<int> value = std::move(assigned).get().value();
+	ASSERT_EQ(5, *value);
+}
@@ -5,6 +5,8 @@
 
 #include "test_tools.h"
 
+#include <memory>
+
 using ::testing::ElementsAreArray;
 using ::testing::UnorderedElementsAreArray;
 
@@ -138,6 +140,29 @@ namespace
 	static_assert(ReturnCheck<Task<char, char>&, Task<char, char>>::value
 		, "Task<char, char> should be returned when using Task<char, char>& f() callback");
 
+	// Test-controlled task
+	struct TestTask
+		: expected<void, void>
+	{
+		explicit TestTask(Status& status)
+			: expected<void, void>()
+			, status_(status)
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			return status_;
+		}
+
+		expected<void, void>& get()
+		{
+			return *this;
+		}
+
+		Status& status_;
+	};
+
 } // namespace
 
 TEST(OnFinish, Can_Be_Chained)
@@ -338,3 +363,132 @@ TEST(OnFinish, On_Cancel_Is_Failed_And_Canceled_When_Task_Is_NOT_Canceled)
 	ASSERT_TRUE(on_cancel.is_canceled());
 	ASSERT_FALSE(cancel_invoked);
 }
+
+TEST(OnFinish, Is_Posted_To_Scheduler_Only_When_Task_Finishes)
+{
+	Scheduler sch;
+	Scheduler finish_sch;
+	Status status = Status::InProgress;
+	Task<> task = Task<>::make<TestTask>(sch, status);
+
+	bool invoked = false;
+	Task<> on_finish = task.on_finish(finish_sch, [&] { invoked = true; });
+	// Waiting task is still counted
+	ASSERT_EQ(std::size_t(1), finish_sch.tasks_count());
+
+	ASSERT_EQ(std::size_t(0), finish_sch.poll());
+	ASSERT_EQ(std::size_t(0), sch.poll());
+	ASSERT_EQ(std::size_t(0), finish_sch.poll());
+	ASSERT_EQ(std::size_t(1), finish_sch.tasks_count());
+	ASSERT_FALSE(invoked);
+	ASSERT_TRUE(on_finish.is_in_progress());
+
+	status = Status::Successful;
+	ASSERT_EQ(std::size_t(1), sch.poll());
+	ASSERT_FALSE(invoked);
+	ASSERT_EQ(std::size_t(1), finish_sch.tasks_count());
+
+	ASSERT_EQ(std::size_t(1), finish_sch.poll());
+	ASSERT_TRUE(invoked);
+	ASSERT_TRUE(on_finish.is_successful());
+	ASSERT_FALSE(finish_sch.has_tasks());
+	ASSERT_FALSE(sch.has_tasks());
+}
+
+TEST(OnFinish, Continuations_Are_Invoked_In_Order_Of_Registration)
+{
+	Scheduler sch;
+	Status status = Status::InProgress;
+	Task<> task = Task<>::make<TestTask>(sch, status);
+
+	std::vector<int> calls;
+	auto task1 = task.on_finish([&] { calls.push_back(1); });
+	auto task2 = task.on_success([&] { calls.push_back(2); });
+	auto task3 = task.on_finish([&] { calls.push_back(3); });
+	ASSERT_EQ(std::size_t(4), sch.tasks_count());
+
+	status = Status::Successful;
+	while (sch.has_tasks())
+	{
+		(void)sch.poll();
+	}
+
+	ASSERT_THAT(calls, ElementsAreArray({1, 2, 3}));
+}
+
+TEST(OnFinish, Added_To_Finished_Task_Is_Posted_Immediately)
+{
+	Scheduler sch;
+	Task<int> task = make_task(sch, [] { return 1; });
+	ASSERT_EQ(std::size_t(1), sch.poll());
+
+	Task<int> on_finish = task.then([](const Task<int>& task)
+	{
+		return task.get().value() + 1;
+	});
+	ASSERT_EQ(std::size_t(1), sch.poll());
+	ASSERT_EQ(2, on_finish.get().value());
+}
+
+TEST(OnFinish, Finished_Continuation_Releases_Functor_And_Parent)
+{
+	Scheduler sch;
+	auto parent_value = std::make_shared<int>(1);
+	auto functor_state = std::make_shared<int>(2);
+	Task<int> task = make_task(sch, [parent_value] { return parent_value; })
+		.then([functor_state](const Task<std::shared_ptr<int>>& parent)
+	{
+		return *parent.get().value() + *functor_state;
+	});
+	// Captured by the functors and kept by not finished tasks
+	ASSERT_EQ(2, parent_value.use_count());
+	ASSERT_EQ(2, functor_state.use_count());
+
+	sch.run_until(task);
+	ASSERT_EQ(3, task.get().value());
+	ASSERT_EQ(1, parent_value.use_count());
+	ASSERT_EQ(1, functor_state.use_count());
+}
+
+TEST(OnFinish, Canceled_Continuation_Releases_Functor)
+{
+	Scheduler sch;
+	auto functor_state = std::make_shared<int>(1);
+	Task<int> task = make_task(sch, [] { return 1; })
+		.on_fail([functor_state] { return *functor_state; });
+	ASSERT_EQ(2, functor_state.use_count());
+
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_canceled());
+	ASSERT_EQ(1, functor_state.use_count());
+}
+
+TEST(OnFinish, More_Than_65535_Continuations_Of_Single_Task)
+{
+	Scheduler sch;
+	Status status = Status::InProgress;
+	Task<> task = Task<>::make<TestTask>(sch, status);
+
+	// Every continuation references the task
+	const std::size_t k_count = 70'000;
+	std::size_t invoked = 0;
+	std::vector<Task<>> continuations;
+	continuations.reserve(k_count);
+	for (std::size_t i = 0; i < k_count; ++i)
+	{
+		continuations.push_back(task.on_finish([&] { ++invoked; }));
+	}
+	ASSERT_EQ(std::size_t(0), sch.poll());
+	ASSERT_EQ(std::size_t(0), invoked);
+
+	// Continuations are ticked only once, after the task finishes
+	const std::uint64_t ticks = sch.stats().ticks;
+	status = Status::Successful;
+	ASSERT_EQ(k_count + 1, sch.poll());
+	ASSERT_EQ(k_count + 1, sch.stats().ticks - ticks);
+	ASSERT_EQ(k_count, invoked);
+	ASSERT_FALSE(sch.has_tasks());
+
+	continuations.clear();
+	ASSERT_TRUE(task.is_successful());
+}
@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+#include <rename_me/parallel_for.h>
+#include <rename_me/task_allocator.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+
+#include "test_tools.h"
+
+#include <vector>
+#include <memory_resource>
+#include <string>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include <cstdint>
+
+using namespace nn;
+
+TEST(ParallelFor, Visits_Every_Element_Once)
+{
+	Scheduler sch;
+	std::vector<int> data(1000, 0);
+	auto task = parallel_for(sch, data.begin(), data.end(), [](int& v) { ++v; }, 7);
+	static_assert(std::is_same<Task<void, void>, decltype(task)>::value, "");
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(1000, std::accumulate(data.begin(), data.end(), 0));
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(ParallelFor, Huge_Grain_Is_Single_Chunk)
+{
+	Scheduler sch;
+	std::vector<int> data(10, 0);
+	auto task = parallel_for(sch, data.begin(), data.end(), [](int& v) { ++v; }
+		, (std::numeric_limits<std::size_t>::max)());
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(10, std::accumulate(data.begin(), data.end(), 0));
+}
+
+TEST(ParallelFor, Of_Empty_Range_Is_Successful)
+{
+	Scheduler sch;
+	std::vector<int> data;
+	auto task = parallel_for(sch, data.begin(), data.end(), [](int&) {});
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+
+	auto values = parallel_transform(sch, data.begin(), data.end(), [](int v) { return v; });
+	sch.run_until(values);
+	ASSERT_TRUE(values.is_successful());
+	ASSERT_TRUE(values.get().value().empty());
+}
+
+TEST(ParallelFor, Fails_With_First_Error)
+{
+	Scheduler sch;
+	std::vector<int> data(100);
+	std::iota(data.begin(), data.end(), 0);
+	int visited = 0;
+	auto task = parallel_for(sch, data.begin(), data.end(), [&](int v)
+	{
+		++visited;
+		return ((v == 10) ? expected<void, std::string>(unexpected<std::string>("10"))
+			: expected<void, std::string>());
+	}, 1);
+	static_assert(std::is_same<Task<void, std::string>, decltype(task)>::value, "");
+	sch.run_until(task);
+	ASSERT_EQ(Status::Failed, task.status());
+	ASSERT_EQ("10", task.get().error());
+	// Single worker: nothing is run after the error
+	ASSERT_EQ(11, visited);
+}
+
+TEST(ParallelFor, Canceled_Stops_After_Current_Chunk)
+{
+	Scheduler sch;
+	std::vector<int> data(1000);
+	Task<void, void>* self = nullptr;
+	int visited = 0;
+	auto task = parallel_for(sch, data.begin(), data.end(), [&](int&)
+	{
+		if (++visited == 5)
+		{
+			self->try_cancel();
+		}
+	}, 2);
+	self = &task;
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_canceled());
+	ASSERT_EQ(6, visited);
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(ParallelFor, Allocates_Tasks_Per_Worker)
+{
+	CountingAllocator allocator;
+	Scheduler sch(allocator);
+	std::vector<int> data(10'000);
+	auto task = parallel_for(sch, data.begin(), data.end(), [](int& v) { v = 1; }, 1);
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	// Returned task, single worker with its waiter, shared range
+	// and the list of the workers
+	ASSERT_EQ(5, allocator.allocations);
+}
+
+TEST(ParallelTransform, Keeps_Values_In_Order)
+{
+	Scheduler sch;
+	std::vector<int> data(1000);
+	std::iota(data.begin(), data.end(), 0);
+	auto task = parallel_transform(sch, data.begin(), data.end()
+		, [](int v) { return std::to_string(v); }, 3);
+	static_assert(std::is_same<Task<std::pmr::vector<std::string>, void>, decltype(task)>::value, "");
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	const auto& values = task.get().value();
+	ASSERT_EQ(1000u, values.size());
+	for (int i = 0; i < 1000; ++i)
+	{
+		ASSERT_EQ(std::to_string(i), values[i]);
+	}
+}
+
+TEST(ParallelTransform, Keeps_Bool_Values)
+{
+	Scheduler sch;
+	std::vector<int> data(100);
+	std::iota(data.begin(), data.end(), 0);
+	auto task = parallel_transform(sch, data.begin(), data.end()
+		, [](int v) { return ((v % 3) == 1); }, 3);
+	static_assert(std::is_same<Task<std::pmr::vector<bool>, void>, decltype(task)>::value, "");
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	const auto& values = task.get().value();
+	ASSERT_EQ(data.size(), values.size());
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		ASSERT_EQ(((data[i] % 3) == 1), values[i]);
+	}
+}
+
+TEST(ParallelTransform, Fails_With_Error_Of_Expected)
+{
+	Scheduler sch;
+	std::vector<int> data(10, 1);
+	data[5] = -1;
+	auto task = parallel_transform(sch, data.begin(), data.end(), [](int v)
+	{
+		return ((v < 0) ? expected<int, int>(unexpected<int>(v)) : expected<int, int>(v * 2));
+	});
+	static_assert(std::is_same<Task<std::pmr::vector<int>, int>, decltype(task)>::value, "");
+	sch.run_until(task);
+	ASSERT_EQ(Status::Failed, task.status());
+	ASSERT_EQ(-1, task.get().error());
+}
+
+TEST(ParallelReduce, Reduces_Mapped_Values)
+{
+	Scheduler sch;
+	std::vector<int> data(1000);
+	std::iota(data.begin(), data.end(), 1);
+	auto task = parallel_reduce(sch, data.begin(), data.end(), std::int64_t(0)
+		, std::plus<>(), [](int v) { return std::int64_t(v) * 2; }, 7);
+	static_assert(std::is_same<Task<std::int64_t, void>, decltype(task)>::value, "");
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(1000 * 1001, task.get().value());
+
+	auto max = parallel_reduce(sch, data.begin(), data.end(), 0
+		, [](int lhs, int rhs) { return (std::max)(lhs, rhs); });
+	sch.run_until(max);
+	ASSERT_EQ(1000, max.get().value());
+}
+
+TEST(ParallelReduce, Of_Empty_Range_Is_Identity)
+{
+	Scheduler sch;
+	std::vector<int> data;
+	auto task = parallel_reduce(sch, data.begin(), data.end(), 42, std::plus<>());
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(42, task.get().value());
+}
+
+TEST(ParallelReduce, Fails_With_Error_Of_Map)
+{
+	Scheduler sch;
+	std::vector<int> data(100, 1);
+	data[50] = -1;
+	auto task = parallel_reduce(sch, data.begin(), data.end(), 0, std::plus<>(), [](int v)
+	{
+		return ((v < 0) ? expected<int, int>(unexpected<int>(v)) : expected<int, int>(v));
+	});
+	static_assert(std::is_same<Task<int, int>, decltype(task)>::value, "");
+	sch.run_until(task);
+	ASSERT_EQ(Status::Failed, task.status());
+	ASSERT_EQ(-1, task.get().error());
+}
+
+#if !(NN_SINGLE_THREADED)
+TEST(ParallelFor, Works_With_Thread_Pool)
+{
+	CountingAllocator allocator;
+	ThreadPoolScheduler sch(allocator, 4);
+	std::vector<int> data(100'000);
+	std::iota(data.begin(), data.end(), 0);
+	auto task = parallel_transform(sch, data.begin(), data.end()
+		, [](int v) { return (v * 2); }, 16);
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	const auto& values = task.get().value();
+	ASSERT_EQ(data.size(), values.size());
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		ASSERT_EQ(data[i] * 2, values[i]);
+	}
+	// Returned task, 4 workers with waiters, shared range,
+	// the list of the workers and the values
+	ASSERT_LE(allocator.allocations, 12);
+}
+
+TEST(ParallelTransform, Workers_Write_Neighbour_Bools)
+{
+	ThreadPoolScheduler sch(8);
+	std::vector<int> data(100'000);
+	std::iota(data.begin(), data.end(), 0);
+	auto task = parallel_transform(sch, data.begin(), data.end()
+		, [](int v) { return ((v % 3) == 1); }, 3);
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	const auto& values = task.get().value();
+	ASSERT_EQ(data.size(), values.size());
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		ASSERT_EQ(((data[i] % 3) == 1), values[i]);
+	}
+}
+
+TEST(ParallelFor, Fails_Fast_With_Thread_Pool)
+{
+	ThreadPoolScheduler sch(4);
+	std::vector<int> data(100'000);
+	std::iota(data.begin(), data.end(), 0);
+	std::atomic<int> visited{0};
+	auto task = parallel_for(sch, data.begin(), data.end(), [&](int v)
+	{
+		++visited;
+		return ((v == 0) ? expected<void, int>(unexpected<int>(v)) : expected<void, int>());
+	}, 1);
+	sch.run_until(task);
+	ASSERT_EQ(Status::Failed, task.status());
+	ASSERT_EQ(0, task.get().error());
+	ASSERT_LT(visited.load(), static_cast<int>(data.size()));
+}
+
+TEST(ParallelReduce, Combines_Partials_Of_All_Workers)
+{
+	ThreadPoolScheduler sch(4);
+	std::vector<std::uint64_t> data(100'000);
+	std::iota(data.begin(), data.end(), 1);
+	auto task = parallel_reduce(sch, data.begin(), data.end(), std::uint64_t(0)
+		, std::plus<>(), [](std::uint64_t v) { return v; }, 64);
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(std::uint64_t(100'000) * 100'001 / 2, task.get().value());
+}
+#endif
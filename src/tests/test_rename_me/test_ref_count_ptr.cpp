@@ -175,3 +175,21 @@ TEST(RefCountPtr, Assign_To_Nullptr_Is_Reset)
 	}
 	ASSERT_EQ(1, dead_count);
 }
+
+TEST(RefCountPtr, Detach_And_Attach_Do_Not_Change_Ref_Count)
+{
+	int dead_count = 0;
+	{
+		Ptr ptr = Ptr::make(dead_count);
+		ASSERT_EQ(1, ptr->ref_);
+		RefCounted* raw = ptr.detach();
+		ASSERT_EQ(nullptr, ptr.get());
+		ASSERT_EQ(1, raw->ref_);
+		ASSERT_EQ(0, dead_count);
+
+		Ptr attached = Ptr::attach(raw);
+		ASSERT_EQ(raw, attached.get());
+		ASSERT_EQ(1, attached->ref_);
+	}
+	ASSERT_EQ(1, dead_count);
+}
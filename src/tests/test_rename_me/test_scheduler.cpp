@@ -1,13 +1,32 @@
 #include <gtest/gtest.h>
 #include <rename_me/scheduler.h>
 #include <rename_me/function_task.h>
+#include <rename_me/future_task.h>
 
 #include "test_tools.h"
 
 #include <thread>
+#include <vector>
+#include <atomic>
+#include <future>
+#include <chrono>
 
 using namespace nn;
 
+namespace
+{
+	// Not posted task that is never finished
+	struct PendingTask : detail::TaskBase
+	{
+		explicit PendingTask(Scheduler& scheduler)
+			: detail::TaskBase(scheduler)
+		{
+		}
+
+		virtual Status update() override { return Status::InProgress; }
+	};
+} // namespace
+
 TEST(Scheduler, Default_Constructed_Has_No_Tasks)
 {
 	Scheduler sch;
@@ -47,6 +66,8 @@ TEST(Scheduler, Task_On_Finish_Adds_One_Task_To_Scheduler)
 	ASSERT_FALSE(sch.has_tasks());
 }
 
+// Scheduler is polled from other thread
+#if !(NN_SINGLE_THREADED)
 TEST(Scheduler, Executes_Task_On_Schedulers_Thread)
 {
 	Scheduler sch;
@@ -88,3 +109,315 @@ TEST(Scheduler, Executes_On_Finish_On_Given_Scheduler)
 	ASSERT_EQ(worker2.get_id(), finish_task.get().value());
 	worker2.join();
 }
+
+TEST(Scheduler, Continuation_Of_Destroyed_Parent_Is_Not_Counted)
+{
+	Scheduler finish_sch;
+	{
+		Scheduler sch;
+		auto parent = detail::RefCountPtr<PendingTask>::make(sch);
+		detail::PostTaskAfter(finish_sch, *parent
+			, detail::RefCountPtr<PendingTask>::make(finish_sch).to_base<detail::TaskBase>());
+		ASSERT_EQ(std::size_t(1), finish_sch.tasks_count());
+		// Parent and its scheduler are destroyed
+		// while continuation waits
+	}
+	ASSERT_EQ(std::size_t(0), finish_sch.tasks_count());
+	finish_sch.run_until_idle();
+}
+
+TEST(Scheduler, Tasks_Posted_From_Many_Threads_Are_Executed)
+{
+	Scheduler sch;
+	const std::size_t k_threads = 8;
+	const std::size_t k_tasks_per_thread = 1000;
+	std::atomic<std::size_t> executed(0);
+	std::atomic<std::size_t> producers(k_threads);
+
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < k_threads; ++i)
+	{
+		threads.emplace_back([&]
+		{
+			for (std::size_t j = 0; j < k_tasks_per_thread; ++j)
+			{
+				(void)make_task(sch, [&] { ++executed; });
+			}
+			--producers;
+		});
+	}
+
+	while ((producers > 0) || sch.has_tasks())
+	{
+		(void)sch.poll();
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	ASSERT_EQ(k_threads * k_tasks_per_thread, executed.load());
+	ASSERT_EQ(std::size_t(0), sch.tasks_count());
+}
+
+#endif
+
+TEST(Scheduler, Tasks_Posted_While_Polling_Are_Executed_On_Next_Poll)
+{
+	Scheduler sch;
+	bool inner_executed = false;
+	Task<> task = make_task(sch, [&]
+	{
+		(void)make_task(sch, [&] { inner_executed = true; });
+	});
+
+	ASSERT_EQ(std::size_t(1), sch.poll());
+	ASSERT_FALSE(inner_executed);
+	ASSERT_EQ(std::size_t(1), sch.tasks_count());
+	ASSERT_EQ(std::size_t(1), sch.poll());
+	ASSERT_TRUE(inner_executed);
+	ASSERT_FALSE(sch.has_tasks());
+}
+
+TEST(Scheduler, Wait_For_Work_Times_Out_Without_Tasks)
+{
+	Scheduler sch;
+	const auto start = std::chrono::steady_clock::now();
+	ASSERT_FALSE(sch.wait_for_work(std::chrono::milliseconds(10)));
+	ASSERT_LE(std::chrono::milliseconds(10), std::chrono::steady_clock::now() - start);
+}
+
+TEST(Scheduler, Wait_For_Work_Returns_Immediately_When_Task_Is_Not_Polled)
+{
+	Scheduler sch;
+	(void)make_task(sch, [] {});
+	ASSERT_TRUE(sch.wait_for_work(std::chrono::hours(1)));
+	ASSERT_EQ(std::size_t(1), sch.poll());
+	ASSERT_FALSE(sch.wait_for_work(std::chrono::milliseconds(1)));
+}
+
+// Scheduler is polled from other thread
+#if !(NN_SINGLE_THREADED)
+TEST(Scheduler, Wait_For_Work_Returns_When_Task_Is_Posted)
+{
+	Scheduler sch;
+	std::thread worker([&]
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		(void)make_task(sch, [] {});
+	});
+	ASSERT_TRUE(sch.wait_for_work(std::chrono::hours(1)));
+	worker.join();
+	ASSERT_EQ(std::size_t(1), sch.poll());
+}
+
+TEST(Scheduler, Wait_For_Work_Returns_On_Wake_Up)
+{
+	Scheduler sch;
+	std::thread worker([&]
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		sch.wake_up();
+	});
+	ASSERT_TRUE(sch.wait_for_work(std::chrono::hours(1)));
+	worker.join();
+}
+
+#endif
+
+TEST(Scheduler, Run_Until_Returns_When_Task_Is_Finished)
+{
+	Scheduler sch;
+	std::promise<int> promise;
+	Task<int, std::exception_ptr> task = make_task(sch, promise.get_future());
+	std::thread worker([&]
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		promise.set_value(42);
+	});
+	sch.run_until(task);
+	worker.join();
+
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(42, task.get().value());
+	ASSERT_FALSE(sch.has_tasks());
+}
+
+TEST(Scheduler, Run_Until_Idle_Executes_All_Tasks)
+{
+	Scheduler sch;
+	int executed = 0;
+	(void)make_task(sch, [&] { ++executed; })
+		.then([&] { ++executed; })
+		.then([&] { ++executed; });
+	(void)make_task(sch, [&]
+	{
+		(void)make_task(sch, [&] { ++executed; });
+	});
+	sch.run_until_idle();
+
+	ASSERT_EQ(4, executed);
+	ASSERT_FALSE(sch.has_tasks());
+}
+
+TEST(Scheduler, Higher_Priority_Tasks_Are_Ticked_First)
+{
+	Scheduler sch;
+	std::vector<int> order;
+	(void)make_task(Priority::Low, sch, [&] { order.push_back(3); });
+	(void)make_task(sch, [&] { order.push_back(2); });
+	(void)make_task(Priority::High, sch, [&] { order.push_back(1); });
+	(void)make_task(Priority::Low, sch, [&] { order.push_back(4); });
+	ASSERT_EQ(std::size_t(4), sch.poll());
+	ASSERT_EQ(std::vector<int>({1, 2, 3, 4}), order);
+}
+
+TEST(Scheduler, Continuation_Inherits_Priority_And_Runs_Before_Lower_Lanes)
+{
+	Scheduler sch;
+	std::vector<int> order;
+	Task<> high = make_task(Priority::High, sch, [&] { order.push_back(1); });
+	Task<> continuation = high.then([&] { order.push_back(2); });
+	ASSERT_EQ(Priority::High, continuation.priority());
+	(void)make_task(Priority::Low, sch, [&] { order.push_back(3); });
+	ASSERT_EQ(std::size_t(3), sch.poll());
+	ASSERT_EQ(std::vector<int>({1, 2, 3}), order);
+}
+
+TEST(Scheduler, Queue_Depth_Counts_Not_Finished_Tasks_Per_Lane)
+{
+	Scheduler sch;
+	Task<> high = make_task(Priority::High, sch, [] {});
+	(void)make_task(Priority::Low, sch, [] {});
+	(void)make_task(Priority::Low, sch, [] {});
+	// Waits for `high`, is not counted yet
+	(void)high.then([] {});
+	ASSERT_EQ(std::size_t(1), sch.queue_depth(Priority::High));
+	ASSERT_EQ(std::size_t(0), sch.queue_depth(Priority::Normal));
+	ASSERT_EQ(std::size_t(2), sch.queue_depth(Priority::Low));
+	ASSERT_EQ(std::size_t(1), sch.poll(1));
+	ASSERT_EQ(std::size_t(1), sch.queue_depth(Priority::High));
+	ASSERT_EQ(std::size_t(2), sch.queue_depth(Priority::Low));
+	sch.run_until_idle();
+	ASSERT_EQ(std::size_t(0), sch.queue_depth(Priority::High));
+	ASSERT_EQ(std::size_t(0), sch.queue_depth(Priority::Low));
+}
+
+TEST(Scheduler, Low_Priority_Lane_Is_Not_Starved)
+{
+	Scheduler sch;
+	bool low_finished = false;
+	(void)make_task(Priority::Low, sch, [&] { low_finished = true; });
+	for (int i = 0; i < 100; ++i)
+	{
+		(void)make_task(Priority::High, sch, [] {});
+	}
+	int polls = 0;
+	while (!low_finished)
+	{
+		ASSERT_EQ(std::size_t(1), sch.poll(1));
+		++polls;
+	}
+	ASSERT_GT(10, polls);
+	sch.run_until_idle();
+}
+
+namespace
+{
+	// Stays in progress until `stop` is set, records every tick
+	struct RecordTicksTask
+	{
+		explicit RecordTicksTask(int id, std::vector<int>& ticks, const bool& stop
+			, std::chrono::milliseconds tick_duration = std::chrono::milliseconds(0))
+			: id_(id)
+			, ticks_(ticks)
+			, stop_(stop)
+			, tick_duration_(tick_duration)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			ticks_.push_back(id_);
+			std::this_thread::sleep_for(tick_duration_);
+			return (stop_ ? Status::Successful : Status::InProgress);
+		}
+
+		expected<void, void>& get()
+		{
+			return data_;
+		}
+
+		const int id_;
+		std::vector<int>& ticks_;
+		const bool& stop_;
+		const std::chrono::milliseconds tick_duration_;
+		expected<void, void> data_;
+	};
+} // namespace
+
+TEST(Scheduler, Poll_For_Stops_When_Budget_Is_Spent)
+{
+	Scheduler sch;
+	std::vector<int> ticks;
+	bool stop = false;
+	for (int i = 0; i < 100; ++i)
+	{
+		(void)Task<>::make<RecordTicksTask>(sch, i, ticks, stop
+			, std::chrono::milliseconds(1));
+	}
+	ASSERT_EQ(std::size_t(0), sch.poll_for(std::chrono::milliseconds(5)));
+	ASSERT_LE(std::size_t(1), ticks.size());
+	ASSERT_GT(std::size_t(50), ticks.size());
+	const BudgetStats stats = sch.budget_stats();
+	ASSERT_EQ(std::size_t(1), stats.polls);
+	ASSERT_EQ(std::size_t(1), stats.exhausted);
+
+	stop = true;
+	sch.run_until_idle();
+}
+
+TEST(Scheduler, Poll_For_Resumes_From_Task_Where_It_Stopped)
+{
+	Scheduler sch;
+	std::vector<int> ticks;
+	bool stop = false;
+	for (int i = 0; i < 4; ++i)
+	{
+		(void)Task<>::make<RecordTicksTask>(sch, i, ticks, stop);
+	}
+	// Zero budget: one tick per poll
+	for (int i = 0; i < 6; ++i)
+	{
+		ASSERT_EQ(std::size_t(0), sch.poll_for(std::chrono::nanoseconds(0)));
+	}
+	ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 0, 1}), ticks);
+	// Unlimited poll finishes the round
+	ASSERT_EQ(std::size_t(0), sch.poll());
+	ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 0, 1, 2, 3}), ticks);
+	ASSERT_EQ(std::size_t(6), sch.budget_stats().exhausted);
+
+	stop = true;
+	sch.run_until_idle();
+}
+
+TEST(Scheduler, Poll_For_Reports_Overrun_Of_Long_Tick)
+{
+	Scheduler sch;
+	std::vector<int> ticks;
+	bool stop = true;
+	(void)Task<>::make<RecordTicksTask>(sch, 0, ticks, stop
+		, std::chrono::milliseconds(10));
+	ASSERT_EQ(std::size_t(1), sch.poll_for(std::chrono::milliseconds(1)));
+	const BudgetStats stats = sch.budget_stats();
+	ASSERT_EQ(std::size_t(1), stats.overruns);
+	ASSERT_LE(std::chrono::milliseconds(9), stats.last_overrun);
+	ASSERT_EQ(stats.last_overrun, stats.max_overrun);
+	ASSERT_EQ(stats.last_overrun, stats.total_overrun);
+
+	ASSERT_EQ(std::size_t(0), sch.poll_for(std::chrono::seconds(1)));
+	ASSERT_EQ(std::size_t(2), sch.budget_stats().polls);
+	ASSERT_EQ(std::size_t(1), sch.budget_stats().overruns);
+	ASSERT_EQ(std::chrono::nanoseconds(0), sch.budget_stats().last_overrun);
+}
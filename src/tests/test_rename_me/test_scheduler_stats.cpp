@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <rename_me/scheduler.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+#include <rename_me/function_task.h>
+#include <rename_me/noop_task.h>
+
+#include "test_tools.h"
+
+#include <vector>
+#include <thread>
+
+using namespace nn;
+
+TEST(Histogram, Small_Values_Are_Exact)
+{
+	for (std::uint64_t value = 0; value < 16; ++value)
+	{
+		const std::size_t bucket = Histogram::BucketFor(value);
+		ASSERT_EQ(value, Histogram::BucketLowerBound(bucket));
+		ASSERT_EQ(value, Histogram::BucketUpperBound(bucket));
+	}
+}
+
+TEST(Histogram, Bucket_Contains_Value_With_Bounded_Error)
+{
+	const std::uint64_t k_values[] = {16, 17, 100, 1'000, 12'345, 1'000'000
+		, 123'456'789, std::uint64_t(1) << 40, std::numeric_limits<std::uint64_t>::max()};
+	for (std::uint64_t value : k_values)
+	{
+		const std::size_t bucket = Histogram::BucketFor(value);
+		ASSERT_GT(Histogram::k_buckets, bucket);
+		const std::uint64_t lower = Histogram::BucketLowerBound(bucket);
+		const std::uint64_t upper = Histogram::BucketUpperBound(bucket);
+		ASSERT_LE(lower, value);
+		ASSERT_GE(upper, value);
+		ASSERT_LE(static_cast<double>(upper - lower), 0.125 * static_cast<double>(lower));
+	}
+	for (std::size_t bucket = 0; bucket + 1 < Histogram::k_buckets; ++bucket)
+	{
+		ASSERT_EQ(Histogram::BucketUpperBound(bucket) + 1
+			, Histogram::BucketLowerBound(bucket + 1));
+	}
+}
+
+TEST(Histogram, Percentiles)
+{
+	Histogram histogram;
+	ASSERT_EQ(std::uint64_t(0), histogram.value_at_percentile(50));
+	for (std::uint64_t value = 1; value <= 10; ++value)
+	{
+		histogram.record(value);
+	}
+	histogram.record(1'000);
+	ASSERT_EQ(std::uint64_t(11), histogram.count());
+	ASSERT_EQ(std::uint64_t(1'055), histogram.sum());
+	ASSERT_EQ(std::uint64_t(1), histogram.value_at_percentile(0));
+	ASSERT_EQ(std::uint64_t(6), histogram.value_at_percentile(50));
+	ASSERT_EQ(std::uint64_t(10), histogram.value_at_percentile(90));
+	const std::uint64_t max = histogram.value_at_percentile(100);
+	ASSERT_LE(std::uint64_t(1'000), max);
+	ASSERT_GT(std::uint64_t(1'125), max);
+}
+
+TEST(SchedulerStats, Counts_Tasks_By_Finish_Status)
+{
+	Scheduler sch;
+	Task<> ok = make_task(sch, [] {});
+	Task<int, int> failed = make_task(sch, [] { return expected<int, int>(unexpected<int>(1)); });
+	Task<> canceled = make_task(sch, [] {});
+	canceled.try_cancel();
+	// Noop task is finished without posting
+	(void)make_task(success, sch);
+	Task<> continuation = ok.then([] {});
+
+	SchedulerStats stats = sch.stats();
+	ASSERT_EQ(std::uint64_t(3), stats.posted);
+	ASSERT_EQ(std::uint64_t(0), stats.finished());
+	ASSERT_EQ(std::size_t(4), stats.tasks_count);
+	ASSERT_EQ(std::size_t(3), stats.queue_depth[std::size_t(Priority::Normal)]);
+
+	sch.run_until_idle();
+	stats = sch.stats();
+	ASSERT_EQ(std::uint64_t(4), stats.posted);
+	ASSERT_EQ(std::uint64_t(2), stats.successful);
+	ASSERT_EQ(std::uint64_t(1), stats.failed);
+	ASSERT_EQ(std::uint64_t(1), stats.canceled);
+	ASSERT_EQ(std::uint64_t(4), stats.ticks);
+	ASSERT_LE(std::uint64_t(1), stats.polls);
+	ASSERT_EQ(std::size_t(0), stats.tasks_count);
+}
+
+TEST(SchedulerStats, Latencies_Are_Sampled)
+{
+	Scheduler sch;
+	const std::uint32_t k_tasks = 4 * SchedulerStats::k_latency_sample_period;
+	for (std::uint32_t i = 0; i < k_tasks; ++i)
+	{
+		(void)make_task(sch, [] {});
+	}
+	ASSERT_EQ(std::size_t(k_tasks), sch.poll());
+	const SchedulerStats stats = sch.stats();
+	ASSERT_EQ(std::uint64_t(4), stats.first_tick_latency.count());
+	ASSERT_EQ(std::uint64_t(4), stats.completion_latency.count());
+	ASSERT_LE(stats.first_tick_latency.count(), stats.ticks);
+}
+
+#if !(NN_SINGLE_THREADED)
+TEST(SchedulerStats, Counts_Ticks_Of_Thread_Pool)
+{
+	ThreadPoolScheduler sch(2);
+	std::vector<Task<>> tasks;
+	for (int i = 0; i < 100; ++i)
+	{
+		tasks.push_back(make_task(sch, [] {}));
+	}
+	sch.run_until_idle();
+	// Workers add counters after finishing a batch of tasks
+	SchedulerStats stats = sch.stats();
+	while (stats.successful != 100)
+	{
+		std::this_thread::yield();
+		stats = sch.stats();
+	}
+	ASSERT_EQ(std::uint64_t(100), stats.ticks);
+	ASSERT_EQ(std::uint64_t(100), stats.posted);
+}
+#endif
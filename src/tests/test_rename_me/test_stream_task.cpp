@@ -0,0 +1,302 @@
+#include <gtest/gtest.h>
+#include <rename_me/stream_task.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+
+#include "test_tools.h"
+
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <chrono>
+
+using namespace nn;
+
+namespace
+{
+	class CountingResource final : public std::pmr::memory_resource
+	{
+	public:
+		int allocations = 0;
+
+	private:
+		virtual void* do_allocate(std::size_t size, std::size_t alignment) override
+		{
+			++allocations;
+			return std::pmr::new_delete_resource()->allocate(size, alignment);
+		}
+
+		virtual void do_deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) override
+		{
+			std::pmr::new_delete_resource()->deallocate(ptr, size, alignment);
+		}
+
+		virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return (this == &other);
+		}
+	};
+
+	// Pushes `per_tick` items on every tick, ends after `count` items
+	struct Counter
+	{
+		int count;
+		int per_tick;
+		int ticks = 0;
+		int value = 0;
+
+		Status operator()(StreamWriter<int>& out)
+		{
+			++ticks;
+			for (int i = 0; (i < per_tick) && (value < count); ++i)
+			{
+				out.push(value++);
+			}
+			return ((value < count) ? Status::InProgress : Status::Successful);
+		}
+	};
+} // namespace
+
+TEST(StreamTask, Next_Takes_Buffered_Items)
+{
+	Scheduler sch;
+	auto stream = StreamTask<int>::make(sch, Counter{3, 3});
+	ASSERT_TRUE(stream.is_in_progress());
+	sch.run_until_idle();
+	ASSERT_EQ(Status::Successful, stream.status());
+	ASSERT_EQ(3u, stream.size());
+
+	for (int i = 0; i < 3; ++i)
+	{
+		auto item = stream.next();
+		ASSERT_TRUE(item.is_successful());
+		ASSERT_EQ(i, item.get().value());
+	}
+	// Nothing is posted
+	ASSERT_EQ(0u, sch.tasks_count());
+	ASSERT_EQ(Status::Failed, stream.next().status());
+}
+
+TEST(StreamTask, Waiting_Next_Is_Completed_By_Source)
+{
+	Scheduler sch;
+	auto stream = StreamTask<std::unique_ptr<int>>::make(sch
+		, [](StreamWriter<std::unique_ptr<int>>& out)
+	{
+		out.push(std::make_unique<int>(7));
+		return Status::Successful;
+	});
+	auto first = stream.next();
+	auto second = stream.next();
+	ASSERT_TRUE(first.is_in_progress());
+	// Source and both waiting next(), not polled, but counted
+	ASSERT_EQ(3u, sch.tasks_count());
+	sch.run_until(first);
+	ASSERT_EQ(7, *first.get().value());
+	// Stream ended: waiting next() fails
+	sch.run_until(second);
+	ASSERT_EQ(Status::Failed, second.status());
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(StreamTask, Next_Many_Takes_Items_Of_The_Tick)
+{
+	Scheduler sch;
+	auto stream = StreamTask<int>::make(sch, Counter{10, 4});
+	auto batch = stream.next_many(100);
+	ASSERT_TRUE(batch.is_in_progress());
+	sch.run_until(batch);
+	ASSERT_EQ((std::vector<int>{0, 1, 2, 3}), batch.get().value());
+
+	sch.run_until_idle();
+	ASSERT_EQ((std::vector<int>{4, 5, 6}), stream.next_many(3).get().value());
+	ASSERT_EQ((std::vector<int>{7, 8, 9}), stream.next_many(5).get().value());
+	ASSERT_EQ(Status::Failed, stream.next_many(5).status());
+}
+
+TEST(StreamTask, Source_Is_Not_Invoked_While_Buffer_Is_Full)
+{
+	Scheduler sch;
+	int ticks = 0;
+	auto stream = StreamTask<int>::make(sch, [&](StreamWriter<int>& out)
+	{
+		++ticks;
+		while (out.room() > 0)
+		{
+			out.push(ticks);
+		}
+		return Status::InProgress;
+	}, 2);
+	(void)sch.poll();
+	// Parked on the second tick
+	(void)sch.poll();
+	const std::uint64_t parked_ticks = sch.stats().ticks;
+	for (int i = 0; i < 5; ++i)
+	{
+		(void)sch.poll();
+	}
+	ASSERT_EQ(parked_ticks, sch.stats().ticks);
+	ASSERT_EQ(1, ticks);
+	ASSERT_EQ(2u, stream.size());
+	ASSERT_EQ(0u, sch.queue_depth(Priority::Normal));
+	// Not polled, but counted
+	ASSERT_EQ(1u, sch.tasks_count());
+	ASSERT_EQ(1, stream.next().get().value());
+	(void)sch.poll();
+	ASSERT_EQ(2, ticks);
+	ASSERT_EQ(2u, stream.size());
+	(void)sch.poll();
+	ASSERT_EQ(0u, sch.queue_depth(Priority::Normal));
+
+	// Parked source is posted to be canceled
+	stream.try_cancel();
+	sch.run_until_idle();
+	ASSERT_EQ(Status::Canceled, stream.status());
+	// Buffered items are still there
+	ASSERT_EQ(1, stream.next().get().value());
+	ASSERT_EQ(2, stream.next().get().value());
+	ASSERT_EQ(Status::Failed, stream.next().status());
+}
+
+TEST(StreamTask, For_Each_Consumes_All_Items)
+{
+	Scheduler sch;
+	auto stream = StreamTask<int>::make(sch, Counter{100, 7});
+	// Taken before for_each()
+	(void)sch.poll();
+	ASSERT_EQ(0, stream.next().get().value());
+
+	std::vector<int> items;
+	auto done = std::move(stream).for_each([&](int value)
+	{
+		items.push_back(value);
+	});
+	ASSERT_FALSE(stream.is_valid());
+	sch.run_until(done);
+	ASSERT_TRUE(done.is_successful());
+	ASSERT_EQ(99u, items.size());
+	ASSERT_EQ(1, items.front());
+	ASSERT_EQ(99, items.back());
+}
+
+TEST(StreamTask, For_Each_After_Source_Finished)
+{
+	Scheduler sch;
+	auto stream = StreamTask<int>::make(sch, Counter{5, 5});
+	sch.run_until_idle();
+	int sum = 0;
+	auto done = std::move(stream).for_each([&](int value) { sum += value; });
+	sch.run_until(done);
+	ASSERT_TRUE(done.is_successful());
+	ASSERT_EQ(0 + 1 + 2 + 3 + 4, sum);
+}
+
+TEST(StreamTask, For_Each_Gets_Error_Of_The_Source)
+{
+	Scheduler sch;
+	int ticks = 0;
+	auto stream = StreamTask<int, int>::make(sch, [&](StreamWriter<int, int>& out)
+	{
+		out.push(ticks);
+		if (++ticks == 3)
+		{
+			return out.fail(42);
+		}
+		return Status::InProgress;
+	});
+	int count = 0;
+	auto done = std::move(stream).for_each([&](int) { ++count; });
+	sch.run_until(done);
+	ASSERT_EQ(Status::Failed, done.status());
+	ASSERT_EQ(42, done.get().error());
+	// Items of the failed tick are consumed too
+	ASSERT_EQ(3, count);
+}
+
+TEST(StreamTask, Cancel_Of_For_Each_Cancels_Source)
+{
+	Scheduler sch;
+	auto stream = StreamTask<int>::make(sch, [](StreamWriter<int>& out)
+	{
+		out.push(1);
+		return Status::InProgress;
+	});
+	auto done = std::move(stream).for_each([](int) { });
+	(void)sch.poll();
+	done.try_cancel();
+	sch.run_until(done);
+	ASSERT_EQ(Status::Canceled, done.status());
+}
+
+TEST(StreamTask, For_Each_Makes_Constant_Allocations)
+{
+	auto allocations = [](int count)
+	{
+		CountingResource resource;
+		{
+			Scheduler sch(resource);
+			const int before = resource.allocations;
+			auto done = StreamTask<int>::make(sch, Counter{count, 16}, 64)
+				.for_each([](int) { });
+			sch.run_until(done);
+			return (resource.allocations - before);
+		}
+	};
+	ASSERT_EQ(allocations(100), allocations(10'000));
+}
+
+#if !(NN_SINGLE_THREADED)
+TEST(StreamTask, Next_From_Other_Thread)
+{
+	ThreadPoolScheduler sch(2);
+	auto stream = StreamTask<int>::make(sch, Counter{1000, 3}, 16);
+	long long sum = 0;
+	while (true)
+	{
+		auto batch = stream.next_many(8);
+		sch.run_until(batch);
+		if (!batch.is_successful())
+		{
+			break;
+		}
+		for (int value : batch.get().value())
+		{
+			sum += value;
+		}
+	}
+	ASSERT_EQ(Status::Successful, stream.status());
+	ASSERT_EQ(999LL * 1000 / 2, sum);
+}
+
+TEST(StreamTask, Full_Buffer_Is_Not_Polled_By_Thread_Pool)
+{
+	ThreadPoolScheduler sch(1);
+	auto stream = StreamTask<int>::make(sch, Counter{1000, 4}, 8);
+	// Source fills the buffer and is parked
+	while ((stream.size() < 8) || (sch.queue_depth(Priority::Normal) > 0))
+	{
+		std::this_thread::yield();
+	}
+	const std::uint64_t ticks = sch.stats().ticks;
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	// Last tick may be not flushed to the stats yet
+	ASSERT_LE(sch.stats().ticks - ticks, 1u);
+	ASSERT_EQ(1u, sch.tasks_count());
+
+	long long sum = 0;
+	while (true)
+	{
+		auto item = stream.next();
+		sch.run_until(item);
+		if (!item.is_successful())
+		{
+			break;
+		}
+		sum += item.get().value();
+	}
+	ASSERT_EQ(999LL * 1000 / 2, sum);
+}
+#endif
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include <rename_me/task_allocator.h>
+#include <rename_me/scheduler.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+#include <rename_me/function_task.h>
+
+#include "test_tools.h"
+
+#include <vector>
+#include <memory_resource>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include <cstdint>
+
+using namespace nn;
+
+namespace
+{
+	class CountingResource final : public std::pmr::memory_resource
+	{
+	public:
+		explicit CountingResource(std::pmr::memory_resource& upstream)
+			: upstream_(upstream)
+		{
+		}
+
+		std::atomic<int> allocations{0};
+		std::atomic<int> alive{0};
+
+	private:
+		virtual void* do_allocate(std::size_t size, std::size_t alignment) override
+		{
+			++allocations;
+			++alive;
+			return upstream_.allocate(size, alignment);
+		}
+
+		virtual void do_deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) override
+		{
+			--alive;
+			upstream_.deallocate(ptr, size, alignment);
+		}
+
+		virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return (this == &other);
+		}
+
+		std::pmr::memory_resource& upstream_;
+	};
+} // namespace
+
+TEST(PoolTaskAllocator, Freed_Block_Is_Reused)
+{
+	PoolTaskAllocator allocator;
+	void* first = allocator.allocate(100, alignof(std::max_align_t));
+	void* second = allocator.allocate(100, alignof(std::max_align_t));
+	ASSERT_NE(first, second);
+	allocator.deallocate(first, 100, alignof(std::max_align_t));
+	// Same size class
+	void* third = allocator.allocate(120, alignof(std::max_align_t));
+	ASSERT_EQ(first, third);
+	allocator.deallocate(second, 100, alignof(std::max_align_t));
+	allocator.deallocate(third, 120, alignof(std::max_align_t));
+}
+
+TEST(PoolTaskAllocator, Blocks_Are_Reserved_In_Batches)
+{
+	PoolTaskAllocator allocator;
+	ASSERT_EQ(0u, allocator.reserved_blocks());
+	std::vector<void*> blocks;
+	for (int i = 0; i < 65; ++i)
+	{
+		blocks.push_back(allocator.allocate(32, 8));
+		ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(blocks.back()) % alignof(std::max_align_t));
+	}
+	// 3 batches of 32 blocks
+	ASSERT_EQ(96u, allocator.reserved_blocks());
+	std::sort(blocks.begin(), blocks.end());
+	ASSERT_TRUE(std::adjacent_find(blocks.begin(), blocks.end()) == blocks.end());
+	for (void* block : blocks)
+	{
+		allocator.deallocate(block, 32, 8);
+	}
+	ASSERT_EQ(96u, allocator.reserved_blocks());
+}
+
+TEST(PoolTaskAllocator, Big_And_Over_Aligned_Blocks_Are_Not_Pooled)
+{
+	PoolTaskAllocator allocator;
+	void* big = allocator.allocate(PoolTaskAllocator::k_max_block_size + 1, 8);
+	void* aligned = allocator.allocate(64, 128);
+	ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(aligned) % 128);
+	ASSERT_EQ(0u, allocator.reserved_blocks());
+	allocator.deallocate(big, PoolTaskAllocator::k_max_block_size + 1, 8);
+	allocator.deallocate(aligned, 64, 128);
+}
+
+TEST(PoolTaskAllocator, Cache_Line_Aligned_Blocks_Are_Pooled)
+{
+	PoolTaskAllocator allocator;
+	std::vector<void*> blocks;
+	for (int i = 0; i < 33; ++i)
+	{
+		blocks.push_back(allocator.allocate(192, 64));
+		ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(blocks.back()) % 64);
+	}
+	ASSERT_EQ(64u, allocator.reserved_blocks());
+	for (void* block : blocks)
+	{
+		allocator.deallocate(block, 192, 64);
+	}
+}
+
+TEST(PoolTaskAllocator, Concurrent_Allocations_Do_Not_Overlap)
+{
+	PoolTaskAllocator allocator;
+	const int k_threads = 4;
+	const int k_iterations = 20'000;
+	std::atomic<bool> failed(false);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < k_threads; ++t)
+	{
+		threads.emplace_back([&, t]
+		{
+			std::vector<int*> blocks;
+			for (int i = 0; i < k_iterations; ++i)
+			{
+				int* block = static_cast<int*>(allocator.allocate(sizeof(int), alignof(int)));
+				*block = t;
+				blocks.push_back(block);
+				if ((i % 3) == 2)
+				{
+					for (int* b : blocks)
+					{
+						failed = (failed || (*b != t));
+						allocator.deallocate(b, sizeof(int), alignof(int));
+					}
+					blocks.clear();
+				}
+			}
+			for (int* b : blocks)
+			{
+				allocator.deallocate(b, sizeof(int), alignof(int));
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	ASSERT_FALSE(failed);
+}
+
+TEST(TaskAllocator, Tasks_Are_Freed_When_Last_Reference_Is_Removed)
+{
+	CountingAllocator allocator;
+	{
+		Scheduler scheduler(allocator);
+		ASSERT_EQ(&allocator, &scheduler.allocator());
+		{
+			auto task = make_task(scheduler, [] { return 1; })
+				.then([](const Task<int>& t) { return t.get().value() + 1; })
+				.then([](const Task<int>& t) { return t.get().value() + 1; })
+				.then([](const Task<int>& t) { return t.get().value() + 1; })
+				.then([](const Task<int>& t) { return t.get().value() + 1; });
+			ASSERT_EQ(5, allocator.allocations);
+			scheduler.run_until(task);
+			ASSERT_EQ(5, task.get().value());
+		}
+		ASSERT_EQ(0, allocator.alive);
+	}
+	ASSERT_EQ(0, allocator.alive);
+}
+
+TEST(TaskAllocator, Scheduler_Allocates_Only_From_Memory_Resource)
+{
+	alignas(std::max_align_t) unsigned char buffer[16 * 1024];
+	std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer)
+		, std::pmr::null_memory_resource());
+	CountingResource resource(arena);
+	{
+		Scheduler scheduler(resource);
+		ASSERT_EQ(&resource, &scheduler.memory_resource());
+		{
+			std::pmr::vector<Task<int>> tasks(&scheduler.memory_resource());
+			tasks.reserve(2);
+			tasks.push_back(make_task(scheduler, [] { return 1; }));
+			tasks.push_back(tasks.back().then([](const Task<int>& t) { return t.get().value() + 1; }));
+			ASSERT_EQ(3, resource.allocations);
+			scheduler.run_until(tasks.back());
+			ASSERT_EQ(2, tasks.back().get().value());
+		}
+		ASSERT_EQ(0, resource.alive);
+	}
+	ASSERT_EQ(3, resource.allocations);
+	ASSERT_EQ(0, resource.alive);
+}
+
+TEST(TaskAllocator, Scheduler_Memory_Resource_Draws_From_Allocator)
+{
+	CountingAllocator allocator;
+	{
+		Scheduler scheduler(allocator);
+		std::pmr::vector<int> values(&scheduler.memory_resource());
+		values.resize(100);
+		ASSERT_EQ(1, allocator.allocations);
+		ASSERT_EQ(1, allocator.alive);
+	}
+	ASSERT_EQ(0, allocator.alive);
+}
+
+#if !(NN_SINGLE_THREADED)
+TEST(TaskAllocator, Thread_Pool_Tasks_Are_Freed)
+{
+	CountingAllocator allocator;
+	{
+		ThreadPoolScheduler scheduler(allocator, 2);
+		for (int i = 0; i < 100; ++i)
+		{
+			auto task = make_task(scheduler, [] {})
+				.then([] {});
+			scheduler.run_until(task);
+		}
+	}
+	ASSERT_EQ(200, allocator.allocations);
+	ASSERT_EQ(0, allocator.alive);
+}
+
+TEST(TaskAllocator, Thread_Pool_Allocates_Workers_From_Memory_Resource)
+{
+	CountingResource resource(*std::pmr::new_delete_resource());
+	{
+		ThreadPoolScheduler scheduler(resource, 2);
+		ASSERT_EQ(&resource, &scheduler.memory_resource());
+		// Workers with their queues
+		const int workers = resource.allocations;
+		ASSERT_GT(workers, 0);
+		for (int i = 0; i < 100; ++i)
+		{
+			auto task = make_task(scheduler, [] {})
+				.then([] {});
+			scheduler.run_until(task);
+		}
+		ASSERT_GE(resource.allocations, workers + 200);
+	}
+	ASSERT_EQ(0, resource.alive);
+}
+#endif
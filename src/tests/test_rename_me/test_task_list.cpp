@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <rename_me/detail/task_list.h>
+#include <rename_me/detail/task_queue.h>
+#include <rename_me/scheduler.h>
+
+#include <vector>
+
+using namespace nn;
+using namespace nn::detail;
+
+namespace
+{
+	struct ListTask : TaskBase
+	{
+		explicit ListTask(Scheduler& scheduler, int id)
+			: TaskBase(scheduler)
+			, id(id)
+		{
+		}
+
+		virtual Status update() override { return Status::Successful; }
+
+		const int id;
+	};
+
+	Scheduler g_scheduler;
+
+	ErasedTask MakeTask(int id)
+	{
+		return RefCountPtr<ListTask>::make(g_scheduler, id).to_base<TaskBase>();
+	}
+
+	std::vector<int> Ids(const TaskList& list)
+	{
+		std::vector<int> ids;
+		for (TaskBase* task = list.front(); task; task = task->next())
+		{
+			ids.push_back(static_cast<ListTask*>(task)->id);
+		}
+		return ids;
+	}
+} // namespace
+
+TEST(TaskList, Push_Back_Keeps_Order)
+{
+	TaskList list;
+	ASSERT_TRUE(list.empty());
+	list.push_back(MakeTask(1));
+	list.push_back(MakeTask(2));
+	list.push_back(MakeTask(3));
+	ASSERT_FALSE(list.empty());
+	ASSERT_EQ(std::vector<int>({1, 2, 3}), Ids(list));
+}
+
+TEST(TaskList, Push_Front_Puts_Queue_Tasks_First)
+{
+	TaskQueue queue;
+	queue.push(MakeTask(1));
+	queue.push(MakeTask(2));
+
+	TaskList list;
+	list.push_front(queue.pop_all());
+	ASSERT_EQ(std::vector<int>({1, 2}), Ids(list));
+
+	queue.push(MakeTask(3));
+	list.push_front(queue.pop_all());
+	list.push_front(nullptr);
+	list.push_back(MakeTask(4));
+	ASSERT_EQ(std::vector<int>({3, 1, 2, 4}), Ids(list));
+}
+
+TEST(TaskList, Remove_After_Unlinks_Task_And_Keeps_Tail)
+{
+	TaskList list;
+	list.push_back(MakeTask(1));
+	list.push_back(MakeTask(2));
+	list.push_back(MakeTask(3));
+
+	TaskBase* first = list.front();
+	ErasedTask last = list.remove_after(first->next());
+	ASSERT_EQ(3, static_cast<ListTask*>(last.get())->id);
+	ASSERT_EQ(nullptr, last->next());
+	ErasedTask front = list.remove_after(nullptr);
+	ASSERT_EQ(1, static_cast<ListTask*>(front.get())->id);
+	ASSERT_EQ(std::vector<int>({2}), Ids(list));
+
+	list.push_back(MakeTask(4));
+	ASSERT_EQ(std::vector<int>({2, 4}), Ids(list));
+	(void)list.remove_after(nullptr);
+	(void)list.remove_after(nullptr);
+	ASSERT_TRUE(list.empty());
+	list.push_back(MakeTask(5));
+	ASSERT_EQ(std::vector<int>({5}), Ids(list));
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <rename_me/then_chain.h>
+#include <rename_me/function_task.h>
+#include <rename_me/noop_task.h>
+
+#include "test_tools.h"
+
+#include <vector>
+
+using namespace nn;
+
+namespace
+{
+
+	int ReturnInt();
+	expected<char, int> ReturnExpected(const Task<int>&);
+
+	static_assert(std::is_same<Task<int, void>, decltype(then_chain(std::declval<Task<>&&>())
+		.then(&ReturnInt)
+		.task())>::value, "");
+	static_assert(std::is_same<Task<char, int>, decltype(then_chain(std::declval<Task<>&&>())
+		.then(&ReturnInt)
+		.then(&ReturnExpected)
+		.task())>::value, "");
+	static_assert(std::is_same<Task<>, decltype(then_chain(std::declval<Task<>&&>())
+		.task())>::value, "");
+
+} // namespace
+
+TEST(ThenChain, Functors_Are_Invoked_In_Order)
+{
+	Scheduler sch;
+	std::vector<int> calls;
+	auto task = then_chain(make_task(sch, [&] { calls.push_back(0); return 1; }))
+		.then([&](const Task<int>& t) { calls.push_back(1); return t.get().value() + 1; })
+		.then([&] { calls.push_back(2); })
+		.then([&](const Task<>& t) { calls.push_back(3); return t.is_successful(); })
+		.task();
+	static_assert(std::is_same<Task<bool, void>, decltype(task)>::value, "");
+
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_TRUE(task.get().value());
+	ASSERT_EQ((std::vector<int>{0, 1, 2, 3}), calls);
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(ThenChain, Chain_Is_Single_Task)
+{
+	CountingAllocator allocator;
+	Scheduler sch(allocator);
+	auto root = make_task(sch, [] { return 1; });
+	ASSERT_EQ(1, allocator.allocations);
+
+	auto task = then_chain(std::move(root))
+		.then([](const Task<int>& t) { return t.get().value() + 1; })
+		.then([](const Task<int>& t) { return t.get().value() + 1; })
+		.then([](const Task<int>& t) { return t.get().value() + 1; })
+		.task();
+	ASSERT_EQ(2, allocator.allocations);
+	ASSERT_EQ(2u, sch.tasks_count());
+
+	sch.run_until(task);
+	ASSERT_EQ(4, task.get().value());
+	ASSERT_EQ(2, allocator.allocations);
+}
+
+TEST(ThenChain, Chain_Of_Ready_Task_Is_Not_Allocated_From_Tick)
+{
+	CountingAllocator allocator;
+	Scheduler sch(allocator);
+	int allocations = -1;
+	auto outer = make_task(sch, [&]
+	{
+		const int before = allocator.allocations;
+		auto task = then_chain(make_task(success, sch, 1))
+			.then([](const Task<int>& t) { return t.get().value() + 1; })
+			.then([](const Task<int>& t) { return t.get().value() + 1; })
+			.task();
+		allocations = (allocator.allocations - before);
+		return (task.is_successful() ? task.get().value() : -1);
+	});
+	sch.run_until(outer);
+	ASSERT_EQ(3, outer.get().value());
+	ASSERT_EQ(0, allocations);
+}
+
+TEST(ThenChain, Error_Is_Passed_To_Next_Functor)
+{
+	Scheduler sch;
+	auto task = then_chain(make_task(sch, [] { return 1; }))
+		.then([](const Task<int>&) { return expected<int, int>(unexpected<int>(5)); })
+		.then([](const Task<int, int>& t) { return t.get().error() + 1; })
+		.task();
+
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(6, task.get().value());
+}
+
+TEST(ThenChain, Not_Finished_Task_Splits_Chain)
+{
+	Scheduler sch;
+	std::vector<int> calls;
+	auto task = then_chain(make_task(sch, [] { return 1; }))
+		.then([&](const Task<int>& t)
+		{
+			calls.push_back(1);
+			const int v = t.get().value();
+			return make_task(sch, [v] { return v + 1; });
+		})
+		.then([&](const Task<int>& t) { calls.push_back(2); return t.get().value() + 1; })
+		.then([&](const Task<int>& t) { calls.push_back(3); return t.get().value() + 1; })
+		.task();
+
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(4, task.get().value());
+	ASSERT_EQ((std::vector<int>{1, 2, 3}), calls);
+}
+
+TEST(ThenChain, Canceled_Chain_Does_Not_Invoke_Functors)
+{
+	Scheduler sch;
+	int calls = 0;
+	auto task = then_chain(make_task(sch, [] { return 1; }))
+		.then([&] { ++calls; })
+		.then([&] { ++calls; })
+		.task();
+	task.try_cancel();
+
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_canceled());
+	ASSERT_EQ(0, calls);
+}
+
+TEST(ThenChain, Empty_Chain_Returns_Root)
+{
+	Scheduler sch;
+	auto task = then_chain(make_task(success, sch, 1)).task();
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(1, task.get().value());
+}
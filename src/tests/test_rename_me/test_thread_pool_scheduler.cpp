@@ -0,0 +1,186 @@
+#include <rename_me/detail/threading.h>
+
+// Not available in single-threaded build
+#if !(NN_SINGLE_THREADED)
+#include <gtest/gtest.h>
+#include <rename_me/thread_pool_scheduler.h>
+#include <rename_me/function_task.h>
+
+#include "test_tools.h"
+
+#include <thread>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+using namespace nn;
+
+namespace
+{
+	void WaitAllTasks(Scheduler& sch)
+	{
+		while (sch.has_tasks())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	struct CountdownTask
+	{
+		explicit CountdownTask(int ticks)
+			: ticks_(ticks)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext&)
+		{
+			if (--ticks_ > 0)
+			{
+				return Status::InProgress;
+			}
+			data_ = std::this_thread::get_id();
+			return Status::Successful;
+		}
+
+		expected<std::thread::id, void>& get()
+		{
+			return data_;
+		}
+
+		int ticks_;
+		expected<std::thread::id, void> data_;
+	};
+} // namespace
+
+TEST(ThreadPoolScheduler, Default_Constructed_Has_Workers_And_No_Tasks)
+{
+	ThreadPoolScheduler sch;
+	ASSERT_LE(std::size_t(1), sch.workers_count());
+	ASSERT_EQ(std::size_t(0), sch.tasks_count());
+	ASSERT_FALSE(sch.has_tasks());
+
+	ThreadPoolScheduler sch2(3);
+	ASSERT_EQ(std::size_t(3), sch2.workers_count());
+}
+
+TEST(ThreadPoolScheduler, Executes_Tasks_On_Worker_Threads)
+{
+	ThreadPoolScheduler sch(2);
+	std::vector<Task<std::thread::id>> tasks;
+	for (int i = 0; i < 100; ++i)
+	{
+		tasks.push_back(make_task(sch
+			, [] { return std::this_thread::get_id(); }));
+	}
+	WaitAllTasks(sch);
+
+	for (auto& task : tasks)
+	{
+		ASSERT_TRUE(task.is_successful());
+		ASSERT_NE(std::this_thread::get_id(), task.get().value());
+	}
+}
+
+TEST(ThreadPoolScheduler, Executes_Then_Chain)
+{
+	ThreadPoolScheduler sch(4);
+	Task<int> task = make_task(sch, [] { return 1; })
+		.then([](const Task<int>& t) { return t.get().value() + 1; })
+		.then([](const Task<int>& t) { return t.get().value() * 10; });
+	WaitAllTasks(sch);
+
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(20, task.get().value());
+}
+
+TEST(ThreadPoolScheduler, Continuation_Is_Posted_To_Other_Scheduler)
+{
+	ThreadPoolScheduler pool(2);
+	Scheduler sch;
+	Task<std::thread::id> task = make_task(pool, [] { return 1; })
+		.then(sch, [] { return std::this_thread::get_id(); });
+	WaitAllTasks(pool);
+	ASSERT_EQ(std::size_t(1), sch.tasks_count());
+	ASSERT_EQ(std::size_t(1), sch.poll());
+
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(std::this_thread::get_id(), task.get().value());
+}
+
+TEST(ThreadPoolScheduler, In_Progress_Task_Is_Ticked_Until_Finish)
+{
+	ThreadPoolScheduler sch(2);
+	auto task = Task<std::thread::id>::make<CountdownTask>(sch, 100);
+	WaitAllTasks(sch);
+
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_NE(std::this_thread::get_id(), task.get().value());
+}
+
+TEST(ThreadPoolScheduler, Tasks_Posted_From_Many_Threads_Are_Executed)
+{
+	const int k_threads = 8;
+	const int k_tasks_per_thread = 1000;
+	ThreadPoolScheduler sch(4);
+	std::atomic<int> executed(0);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < k_threads; ++i)
+	{
+		threads.emplace_back([&]
+		{
+			for (int j = 0; j < k_tasks_per_thread; ++j)
+			{
+				(void)make_task(sch, [&] { ++executed; });
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	WaitAllTasks(sch);
+
+	ASSERT_EQ(k_threads * k_tasks_per_thread, executed.load());
+}
+
+TEST(ThreadPoolScheduler, Idle_Workers_Steal_Tasks)
+{
+	ThreadPoolScheduler sch(2);
+	std::mutex guard;
+	std::set<std::thread::id> threads;
+	// All tasks are posted from the worker thread to its own deque
+	(void)make_task(sch, [&]
+	{
+		for (int i = 0; i < 50; ++i)
+		{
+			(void)make_task(sch, [&]
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				std::lock_guard<std::mutex> _(guard);
+				threads.insert(std::this_thread::get_id());
+			});
+		}
+	});
+	WaitAllTasks(sch);
+
+	ASSERT_EQ(std::size_t(2), threads.size());
+}
+
+TEST(ThreadPoolScheduler, Run_Until_Waits_For_Task)
+{
+	ThreadPoolScheduler sch(2);
+	Task<int> task = make_task(sch, []
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		return 1;
+	}).then([](const Task<int>& t) { return t.get().value() + 1; });
+	sch.run_until(task);
+
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(2, task.get().value());
+}
+
+#endif // !(NN_SINGLE_THREADED)
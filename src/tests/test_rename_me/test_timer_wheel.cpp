@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <rename_me/detail/timer_wheel.h>
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+using namespace nn::detail;
+
+namespace
+{
+	struct Timers
+	{
+		std::vector<std::unique_ptr<TimerNode>> nodes;
+
+		TimerNode& make()
+		{
+			nodes.push_back(std::make_unique<TimerNode>(TimerNode::Clock::time_point()));
+			return *nodes.back();
+		}
+
+		int id(const TimerNode& timer) const
+		{
+			for (std::size_t i = 0; i < nodes.size(); ++i)
+			{
+				if (nodes[i].get() == &timer)
+				{
+					return static_cast<int>(i);
+				}
+			}
+			return -1;
+		}
+	};
+
+	// Returns (id, tick) of expired timers
+	std::vector<std::pair<int, std::uint64_t>> Advance(TimerWheel& wheel
+		, const Timers& timers, std::uint64_t now)
+	{
+		std::vector<std::pair<int, std::uint64_t>> expired;
+		wheel.advance(now, [&](TimerNode& timer)
+		{
+			EXPECT_FALSE(timer.is_scheduled());
+			expired.emplace_back(timers.id(timer), wheel.elapsed());
+		});
+		return expired;
+	}
+
+	using Expired = std::vector<std::pair<int, std::uint64_t>>;
+} // namespace
+
+TEST(TimerWheel, Empty_Wheel_Never_Expires)
+{
+	TimerWheel wheel;
+	ASSERT_TRUE(wheel.empty());
+	ASSERT_EQ(TimerWheel::k_never, wheel.next_expiration());
+	Timers timers;
+	ASSERT_TRUE(Advance(wheel, timers, 1000).empty());
+	ASSERT_EQ(std::uint64_t(1000), wheel.elapsed());
+}
+
+TEST(TimerWheel, Timers_Expire_On_Their_Ticks)
+{
+	TimerWheel wheel;
+	Timers timers;
+	wheel.schedule(timers.make(), 5);
+	wheel.schedule(timers.make(), 1);
+	wheel.schedule(timers.make(), 63);
+	wheel.schedule(timers.make(), 64);
+	wheel.schedule(timers.make(), 5000);
+	ASSERT_FALSE(wheel.empty());
+	ASSERT_EQ(std::uint64_t(1), wheel.next_expiration());
+
+	ASSERT_EQ(Expired({{1, 1}, {0, 5}}), Advance(wheel, timers, 10));
+	ASSERT_EQ(Expired({{2, 63}, {3, 64}}), Advance(wheel, timers, 4999));
+	ASSERT_EQ(Expired({{4, 5000}}), Advance(wheel, timers, 10000));
+	ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel, Next_Expiration_Is_Not_Later_Then_Timer)
+{
+	TimerWheel wheel;
+	Timers timers;
+	const std::uint64_t k_ticks[] = {100, 4096, 4097, 300'000, 1ull << 33};
+	for (std::uint64_t tick : k_ticks)
+	{
+		TimerNode& timer = timers.make();
+		wheel.schedule(timer, tick);
+		std::uint64_t expired_at = 0;
+		while (!wheel.empty())
+		{
+			const std::uint64_t next = wheel.next_expiration();
+			ASSERT_LE(next, tick);
+			wheel.advance(next, [&](TimerNode&) { expired_at = wheel.elapsed(); });
+		}
+		ASSERT_EQ(tick, expired_at);
+	}
+}
+
+TEST(TimerWheel, Cancel_Removes_Timer)
+{
+	TimerWheel wheel;
+	Timers timers;
+	TimerNode& first = timers.make();
+	TimerNode& second = timers.make();
+	TimerNode& third = timers.make();
+	wheel.schedule(first, 10);
+	wheel.schedule(second, 10);
+	wheel.schedule(third, 10);
+	wheel.cancel(second);
+	ASSERT_FALSE(second.is_scheduled());
+	wheel.cancel(third);
+	wheel.cancel(first);
+	ASSERT_TRUE(wheel.empty());
+	ASSERT_EQ(TimerWheel::k_never, wheel.next_expiration());
+	ASSERT_TRUE(Advance(wheel, timers, 100).empty());
+
+	wheel.schedule(second, 200);
+	ASSERT_EQ(Expired({{1, 200}}), Advance(wheel, timers, 200));
+}
+
+TEST(TimerWheel, Too_Far_Timer_Is_Clamped)
+{
+	TimerWheel wheel;
+	Timers timers;
+	wheel.schedule(timers.make(), TimerWheel::k_never - 1);
+	const Expired expired = Advance(wheel, timers, TimerWheel::k_max_ticks);
+	ASSERT_EQ(std::size_t(1), expired.size());
+	ASSERT_EQ(TimerWheel::k_max_ticks - 1, expired[0].second);
+}
+
+TEST(TimerWheel, Wraps_Around_Last_Level)
+{
+	TimerWheel wheel;
+	Timers timers;
+	const std::uint64_t start = (TimerWheel::k_range - 10);
+	wheel.advance(start, [](TimerNode&) {});
+	wheel.schedule(timers.make(), start + 20);
+	wheel.schedule(timers.make(), start + 5);
+	ASSERT_EQ(Expired({{1, start + 5}, {0, start + 20}}), Advance(wheel, timers, start + 100));
+}
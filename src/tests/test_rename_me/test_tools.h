@@ -1,7 +1,9 @@
 #pragma once
 #include <rename_me/custom_task.h>
+#include <rename_me/task_allocator.h>
 
 #include <ostream>
+#include <atomic>
 
 namespace nn
 {
@@ -26,4 +28,28 @@ namespace nn
 		return o;
 	}
 
+	// Counts allocations of the tasks (and of the Scheduler's
+	// memory_resource()), allocates from own PoolTaskAllocator
+	class CountingAllocator final : public TaskAllocator
+	{
+	public:
+		virtual void* allocate(std::size_t size, std::size_t alignment) override
+		{
+			++allocations;
+			++alive;
+			return pool.allocate(size, alignment);
+		}
+
+		virtual void deallocate(void* ptr
+			, std::size_t size, std::size_t alignment) noexcept override
+		{
+			--alive;
+			pool.deallocate(ptr, size, alignment);
+		}
+
+		PoolTaskAllocator pool;
+		std::atomic<int> allocations{0};
+		std::atomic<int> alive{0};
+	};
+
 } // namespace nn
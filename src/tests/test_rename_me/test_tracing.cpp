@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <rename_me/tracing.h>
+#include <rename_me/detail/trace.h>
+
+#include <sstream>
+#include <string>
+
+using namespace nn;
+using namespace nn::detail;
+
+namespace
+{
+	std::size_t Count(const std::string& str, const std::string& what)
+	{
+		std::size_t count = 0;
+		for (std::size_t pos = str.find(what); pos != std::string::npos
+			; pos = str.find(what, pos + what.size()))
+		{
+			++count;
+		}
+		return count;
+	}
+
+	std::string WriteTrace()
+	{
+		std::ostringstream out;
+		write_trace(out);
+		return out.str();
+	}
+} // namespace
+
+TEST(Tracing, Nothing_Is_Recorded_When_Tracing_Is_Stopped)
+{
+	(void)WriteTrace();
+	ASSERT_FALSE(is_tracing());
+	int task = 0;
+	TraceCreate(&task, "Task", Status::InProgress);
+	TraceTick(&task, TraceStart(), Status::Successful);
+
+	const std::string trace = WriteTrace();
+	ASSERT_EQ(0u, Count(trace, "\"cat\":\"task\""));
+	ASSERT_NE(std::string::npos, trace.find("\"traceEvents\":["));
+}
+
+TEST(Tracing, Writes_Task_Lifetime_And_Continuation_Flow)
+{
+	(void)WriteTrace();
+	start_tracing();
+	ASSERT_TRUE(is_tracing());
+	int parent = 0;
+	int continuation = 0;
+	TraceCreate(&parent, "Parent\"Task", Status::InProgress);
+	TraceCreate(&continuation, "Continuation", Status::InProgress);
+	TraceContinuation(&parent, &continuation);
+	TraceCancel(&parent);
+	TraceTick(&parent, TraceStart(), Status::InProgress);
+	TraceTick(&parent, TraceStart(), Status::Canceled);
+	TraceTick(&continuation, TraceStart(), Status::Successful);
+	stop_tracing();
+
+	const std::string trace = WriteTrace();
+	ASSERT_EQ(2u, Count(trace, "\"ph\":\"b\""));
+	ASSERT_EQ(2u, Count(trace, "\"ph\":\"e\""));
+	ASSERT_EQ(3u, Count(trace, "\"name\":\"tick\""));
+	ASSERT_EQ(1u, Count(trace, "\"ph\":\"i\""));
+	ASSERT_EQ(1u, Count(trace, "\"ph\":\"s\""));
+	ASSERT_EQ(1u, Count(trace, "\"ph\":\"f\""));
+	// Tick and end of the lifetime
+	ASSERT_EQ(2u, Count(trace, "\"status\":\"Canceled\""));
+	ASSERT_NE(std::string::npos, trace.find("Parent\\\"Task"));
+
+	// Events are removed from the buffers once written
+	ASSERT_EQ(0u, Count(WriteTrace(), "\"cat\":\"task\""));
+}
@@ -0,0 +1,256 @@
+#include <gtest/gtest.h>
+#include <rename_me/when_all.h>
+#include <rename_me/function_task.h>
+#include <rename_me/noop_task.h>
+#if !(NN_SINGLE_THREADED)
+#include <rename_me/thread_pool_scheduler.h>
+#endif
+
+#include "test_tools.h"
+
+#include <string>
+#include <vector>
+
+using namespace nn;
+
+namespace
+{
+
+	// Task that is finished only by the test
+	struct PendingTask
+	{
+		explicit PendingTask(const bool& finish, int value, int& ticks)
+			: finish_(finish)
+			, value_(value)
+			, ticks_(ticks)
+			, data_()
+		{
+		}
+
+		Status tick(const ExecutionContext& context)
+		{
+			++ticks_;
+			if (context.cancel_requested)
+			{
+				return Status::Canceled;
+			}
+			if (!finish_)
+			{
+				return Status::InProgress;
+			}
+			data_.emplace(value_);
+			return Status::Successful;
+		}
+
+		expected<int, void>& get()
+		{
+			return data_;
+		}
+
+		const bool& finish_;
+		const int value_;
+		int& ticks_;
+		expected<int, void> data_;
+	};
+
+} // namespace
+
+TEST(WhenAll, Finishes_Once_All_Tasks_Finish)
+{
+	Scheduler sch;
+	bool finish = false;
+	int ticks = 0;
+	auto task = when_all(
+		  make_task(sch, [] { return 1; })
+		, make_task(sch, [] { return std::string("2"); })
+		, Task<int>::make<PendingTask>(sch, finish, 3, ticks));
+	static_assert(std::is_same<Task<std::tuple<expected<int, void>
+		, expected<std::string, void>, expected<int, void>>>, decltype(task)>::value, "");
+
+	for (int i = 0; i < 5; ++i)
+	{
+		(void)sch.poll();
+		ASSERT_TRUE(task.is_in_progress());
+	}
+	finish = true;
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	auto& values = task.get().value();
+	ASSERT_EQ(1, std::get<0>(values).value());
+	ASSERT_EQ("2", std::get<1>(values).value());
+	ASSERT_EQ(3, std::get<2>(values).value());
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(WhenAll, Is_Not_Ticked_While_Tasks_Are_In_Progress)
+{
+	Scheduler sch;
+	bool finish = false;
+	int ticks = 0;
+	std::vector<Task<int>> tasks;
+	for (int i = 0; i < 10; ++i)
+	{
+		tasks.push_back(Task<int>::make<PendingTask>(sch, finish, i, ticks));
+	}
+	auto task = when_all(sch, std::move(tasks));
+	const std::uint64_t ticks_before = sch.stats().ticks;
+	for (int i = 0; i < 5; ++i)
+	{
+		(void)sch.poll();
+	}
+	// Only waited tasks are ticked
+	ASSERT_EQ(50, ticks);
+	ASSERT_EQ(50u, sch.stats().ticks - ticks_before);
+
+	finish = true;
+	sch.run_until(task);
+	// Every task is ticked once more and returned task is ticked once:
+	// finished tasks are counted without ticks
+	ASSERT_EQ(60, ticks);
+	ASSERT_EQ(50u + 10u + 1u, sch.stats().ticks - ticks_before);
+	ASSERT_TRUE(task.is_successful());
+	const auto& values = task.get().value();
+	ASSERT_EQ(10u, values.size());
+	for (int i = 0; i < 10; ++i)
+	{
+		ASSERT_EQ(i, values[i].value());
+	}
+}
+
+TEST(WhenAll, Keeps_Errors_Of_Failed_And_Canceled_Tasks)
+{
+	Scheduler sch;
+	bool finish = false;
+	int ticks = 0;
+	std::vector<Task<int, int>> tasks;
+	tasks.push_back(make_task(sch, expected<int, int>(1)));
+	tasks.push_back(make_task(error, sch, 2).then([] { return expected<int, int>(unexpected<int>(3)); }));
+	auto canceled = Task<int>::make<PendingTask>(sch, finish, 4, ticks);
+	canceled.try_cancel();
+	auto task = when_all(std::move(canceled)
+		, make_task(sch, [] { return expected<int, int>(5); }));
+
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_FALSE(std::get<0>(task.get().value()).has_value());
+	ASSERT_EQ(5, std::get<1>(task.get().value()).value());
+
+	auto all = when_all(sch, std::move(tasks));
+	sch.run_until(all);
+	ASSERT_TRUE(all.is_successful());
+	ASSERT_EQ(1, all.get().value()[0].value());
+	ASSERT_EQ(3, all.get().value()[1].error());
+}
+
+TEST(WhenAll, Of_Ready_Tasks_Is_Posted_Immediately)
+{
+	Scheduler sch;
+	auto task = when_all(make_task(success, sch, 1), make_task(success, sch, 2));
+	ASSERT_EQ(1u, sch.tasks_count());
+	ASSERT_EQ(1u, sch.poll());
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(2, std::get<1>(task.get().value()).value());
+
+	auto empty = when_all(sch, std::vector<Task<int>>());
+	ASSERT_EQ(1u, sch.poll());
+	ASSERT_TRUE(empty.is_successful());
+	ASSERT_TRUE(empty.get().value().empty());
+}
+
+TEST(WhenAll, Canceled_Is_Finished_Once_Tasks_Finish)
+{
+	Scheduler sch;
+	bool finish = false;
+	int ticks = 0;
+	auto task = when_all(Task<int>::make<PendingTask>(sch, finish, 1, ticks));
+	task.try_cancel();
+	(void)sch.poll();
+	ASSERT_TRUE(task.is_in_progress());
+	finish = true;
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_canceled());
+}
+
+TEST(WhenAll, Can_Be_Dropped_Before_Tasks_Finish)
+{
+	Scheduler sch;
+	bool finish = false;
+	int ticks = 0;
+	(void)when_all(Task<int>::make<PendingTask>(sch, finish, 1, ticks)
+		, make_task(sch, [] { return 2; }));
+	(void)sch.poll();
+	finish = true;
+	sch.run_until_idle();
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(WhenAny, Finishes_With_First_Task_And_Cancels_Others)
+{
+	Scheduler sch;
+	bool finish = false;
+	int ticks = 0;
+	auto slow = Task<int>::make<PendingTask>(sch, finish, 1, ticks);
+	auto task = when_any(std::move(slow)
+		, make_task(sch, [] { return std::string("fast"); }));
+	static_assert(std::is_same<Task<WhenAnyResult<std::variant<expected<int, void>
+		, expected<std::string, void>>>>, decltype(task)>::value, "");
+
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(1u, task.get().value().index);
+	ASSERT_EQ("fast", std::get<1>(task.get().value().value).value());
+	// Slow task is canceled on the next tick
+	sch.run_until_idle();
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(WhenAny, Of_Vector_Returns_Index_Of_First_Task)
+{
+	Scheduler sch;
+	bool finish = false;
+	bool finish_second = false;
+	int ticks = 0;
+	std::vector<Task<int>> tasks;
+	tasks.push_back(Task<int>::make<PendingTask>(sch, finish, 0, ticks));
+	tasks.push_back(Task<int>::make<PendingTask>(sch, finish_second, 1, ticks));
+	tasks.push_back(Task<int>::make<PendingTask>(sch, finish, 2, ticks));
+	auto task = when_any(sch, std::move(tasks));
+	(void)sch.poll();
+	ASSERT_TRUE(task.is_in_progress());
+	finish_second = true;
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	ASSERT_EQ(1u, task.get().value().index);
+	ASSERT_EQ(1, task.get().value().value.value());
+	sch.run_until_idle();
+	ASSERT_EQ(0u, sch.tasks_count());
+}
+
+TEST(WhenAny, Of_Empty_Vector_Fails)
+{
+	Scheduler sch;
+	auto task = when_any(sch, std::vector<Task<int>>());
+	sch.run_until(task);
+	ASSERT_EQ(Status::Failed, task.status());
+}
+
+#if !(NN_SINGLE_THREADED)
+TEST(WhenAll, Works_With_Thread_Pool)
+{
+	ThreadPoolScheduler sch(4);
+	std::vector<Task<int>> tasks;
+	for (int i = 0; i < 1000; ++i)
+	{
+		tasks.push_back(make_task(sch, [i] { return i; }));
+	}
+	auto task = when_all(sch, std::move(tasks));
+	sch.run_until(task);
+	ASSERT_TRUE(task.is_successful());
+	const auto& values = task.get().value();
+	ASSERT_EQ(1000u, values.size());
+	for (int i = 0; i < 1000; ++i)
+	{
+		ASSERT_EQ(i, values[i].value());
+	}
+}
+#endif